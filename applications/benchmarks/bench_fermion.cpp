@@ -1,5 +1,7 @@
 #include "bench.h"
 #include "plumbing/coordinates.h"
+#include "dirac/staggered.h"
+#include "dirac/wilson.h"
 #include "dirac/conjugate_gradient.h"
 
 #define N 3
@@ -136,5 +138,61 @@ int main(int argc, char **argv) {
     timing = timing / (double)n_runs;
     hila::out0 << "Dirac Wilson CG: " << timing << "ms / iteration\n";
 
+    // Full solves: double precision CG vs. mixed precision CG
+    gauge_field_base<sunmat> gauge;
+    foralldir(d) gauge.gauge[d] = U[d];
+
+    CG<Dirac_Wilson> w_inverse_double(D_wilson, 1e-10);
+    CG_mixed_precision<Dirac_Wilson, gauge_field_base<sunmat>> w_inverse_mixed(D_wilson, gauge,
+                                                                             1e-10);
+    wvec1[ALL] = 0;
+    gettimeofday(&start, NULL);
+    w_inverse_double.apply(wvec2, wvec1);
+    gettimeofday(&end, NULL);
+    double timing_double = timediff(start, end);
+
+    wvec1[ALL] = 0;
+    gettimeofday(&start, NULL);
+    w_inverse_mixed.apply(wvec2, wvec1);
+    gettimeofday(&end, NULL);
+    timing = timediff(start, end);
+    hila::out0 << "Dirac Wilson mixed precision CG: " << timing << "ms, double precision "
+               << timing_double << "ms, speedup " << timing_double / timing << '\n';
+
+    using dirac_stg_eo = dirac_staggered_evenodd<sunmat>;
+    dirac_stg_eo D_staggered_eo(0.1, U);
+    CG<dirac_stg_eo> stg_inverse_double(D_staggered_eo, 1e-10);
+    CG_mixed_precision<dirac_stg_eo, gauge_field_base<sunmat>> stg_inverse_mixed(D_staggered_eo,
+                                                                               gauge, 1e-10);
+    sunvec1[ALL] = 0;
+    gettimeofday(&start, NULL);
+    stg_inverse_double.apply(sunvec2, sunvec1);
+    gettimeofday(&end, NULL);
+    timing_double = timediff(start, end);
+
+    sunvec1[ALL] = 0;
+    gettimeofday(&start, NULL);
+    stg_inverse_mixed.apply(sunvec2, sunvec1);
+    gettimeofday(&end, NULL);
+    timing = timediff(start, end);
+    hila::out0 << "Staggered even-odd mixed precision CG: " << timing << "ms, double precision "
+               << timing_double << "ms, speedup " << timing_double / timing << '\n';
+
+    // Iteration time of the pipelined CG, one reduction per iteration, vs. CG.
+    // Run a fixed number of iterations
+    CG<Dirac_Wilson> w_inverse_fixed(D_wilson, 1e-30, 200);
+    CG_pipelined<Dirac_Wilson> w_inverse_pipelined(D_wilson, 1e-30, 200);
+    w_inverse_fixed.verbose = w_inverse_pipelined.verbose = false;
+
+    wvec1[ALL] = 0;
+    w_inverse_fixed.apply(wvec2, wvec1);
+    wvec1[ALL] = 0;
+    w_inverse_pipelined.apply(wvec2, wvec1);
+
+    double t_cg = w_inverse_fixed.time_ms / w_inverse_fixed.iterations;
+    double t_pipe = w_inverse_pipelined.time_ms / w_inverse_pipelined.iterations;
+    hila::out0 << "Dirac Wilson CG: " << t_cg << "ms / iteration, pipelined CG: " << t_pipe
+               << "ms / iteration, ratio " << t_pipe / t_cg << '\n';
+
     hila::finishrun();
 }
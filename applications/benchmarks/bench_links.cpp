@@ -0,0 +1,123 @@
+#include <sstream>
+#include <iostream>
+#include <string>
+#include <math.h>
+#include <assert.h>
+#include <sys/time.h>
+#include <ctime>
+
+#include "hila.h"
+#include "gauge/staples.h"
+
+// Minimum time to run each benchmark
+// in microseconds
+constexpr double mintime = 1000;
+
+// Calculate time difference in milliseconds
+static inline double timediff(timeval start, timeval end) {
+    long long t1 = (long long)(start.tv_usec) + 1000000 * (long long)(start).tv_sec;
+    long long t2 = (long long)(end.tv_usec) + 1000000 * (long long)(end).tv_sec;
+    return 1e-3 * (double)(t2 - t1);
+}
+
+#ifndef SEED
+#define SEED 100
+#endif
+
+const CoordinateVector latsize = {32, 32, 32, 32};
+
+using ntype = double;
+using mtype = SU<3, ntype>;
+using vtype = Vector<3, Complex<ntype>>;
+
+///////////////////////////////////////////////////////////////
+// benchmark gauge link loops with full and compressed
+// (reconstruct-12 and reconstruct-8) SU(3) link storage
+///////////////////////////////////////////////////////////////
+
+template <typename T>
+void bench_links(const GaugeField<mtype> &U0, const char *name) {
+    struct timeval start, end;
+    double timing;
+    int n_runs;
+
+    GaugeField<T> U = U0;
+    Field<mtype> staples;
+    Field<vtype> v, w;
+    v.gaussian_random();
+
+    hila::out0 << name << ": " << sizeof(T) << " bytes/link\n";
+
+    // Plaquette
+    double plaq = 0;
+    timing = 0;
+    for (n_runs = 1; timing < mintime;) {
+        n_runs *= 2;
+        gettimeofday(&start, NULL);
+        for (int i = 0; i < n_runs; i++) {
+            plaq = U.measure_plaq();
+        }
+        hila::synchronize();
+        gettimeofday(&end, NULL);
+        timing = timediff(start, end);
+    }
+    timing = timing / (double)n_runs;
+    hila::out0 << "   plaquette : " << timing << " ms, plaq " << plaq / lattice.volume()
+               << '\n';
+
+    // Staple sum, all directions
+    timing = 0;
+    for (n_runs = 1; timing < mintime;) {
+        n_runs *= 2;
+        gettimeofday(&start, NULL);
+        for (int i = 0; i < n_runs; i++) {
+            foralldir(d) staplesum(U, staples, d);
+        }
+        hila::synchronize();
+        gettimeofday(&end, NULL);
+        timing = timediff(start, end);
+    }
+    timing = timing / (double)n_runs;
+    hila::out0 << "   staplesum : " << timing << " ms\n";
+
+    // Hopping term, as in the staggered Dirac operator
+    timing = 0;
+    for (n_runs = 1; timing < mintime;) {
+        n_runs *= 2;
+        gettimeofday(&start, NULL);
+        for (int i = 0; i < n_runs; i++) {
+            w[ALL] = 0;
+            foralldir(d) {
+                onsites(ALL) {
+                    w[X] += U[d][X] * v[X + d] - U[d][X - d].dagger() * v[X - d];
+                }
+            }
+        }
+        hila::synchronize();
+        gettimeofday(&end, NULL);
+        timing = timediff(start, end);
+    }
+    timing = timing / (double)n_runs;
+    hila::out0 << "   hopping   : " << timing << " ms\n";
+}
+
+
+int main(int argc, char **argv) {
+
+    hila::initialize(argc, argv);
+
+    lattice.setup(latsize);
+
+    hila::seed_random(SEED);
+
+    GaugeField<mtype> U;
+    foralldir(d) {
+        onsites(ALL) U[d][X].random();
+    }
+
+    bench_links<mtype>(U, "SU(3) full");
+    bench_links<SU3_r12<ntype>>(U, "SU(3) reconstruct-12");
+    bench_links<SU3_r8<ntype>>(U, "SU(3) reconstruct-8");
+
+    hila::finishrun();
+}
@@ -440,12 +440,47 @@ void fft_test() {
 
         report_pass("FFT real to complex", eps, 1e-13 * sqrt(lattice.volume()));
 
-        auto r2 = f.FFT_complex_to_real(fft_direction::back) / lattice.volume();
+        Field<double> r2 = f.FFT_complex_to_real(fft_direction::back) / lattice.volume();
         eps = squarenorm_relative(r, r2);
 
         report_pass("FFT complex to real", eps, 1e-13 * sqrt(lattice.volume()));
     }
 
+#if defined(USE_FFTW)
+    {
+        Field<double> r, r2;
+        onsites(ALL) r[X] = hila::gaussrand();
+
+        // real-to-complex transform with half storage, compare to full complex
+        hila::half_k_field<double> h;
+        FFT_real_to_half(r, h);
+        f = r.FFT_real_to_complex();
+
+        hila::k_binning b;
+        b.k_max(M_PI * sqrt(3.0));
+
+        auto bf = b.bin_k_field(f);
+        auto bh = b.bin_k_field(h);
+        auto sf = b.bin_k_field_squarenorm(f);
+        auto sh = b.bin_k_field_squarenorm(h);
+
+        double diff = 0, norm = 0;
+        for (int i = 0; i < b.bins(); i++) {
+            diff += squarenorm(bf[i] - bh[i]) + squarenorm(sf[i] - sh[i]);
+            norm += squarenorm(bf[i]) + squarenorm(sf[i]);
+        }
+        eps = hila::broadcast(diff / norm);
+
+        report_pass("FFT real to half-complex", eps, 1e-20 * lattice.volume());
+
+        FFT_half_to_real(h, r2);
+        r2[ALL] = r2[X] / lattice.volume();
+        eps = squarenorm_relative(r, r2);
+
+        report_pass("FFT half-complex to real", eps, 1e-13 * sqrt(lattice.volume()));
+    }
+#endif
+
     //-----------------------------------------------------------------
     // Check fft norm
 
@@ -463,7 +498,8 @@ void fft_test() {
     hila::k_binning b;
     b.k_max(M_PI * sqrt(3.0));
 
-    auto bf = b.bin_k_field(p.conj() * p);
+    Field<T> pp = p.conj() * p;
+    auto bf = b.bin_k_field(pp);
 
     double s = 0;
     for (auto b : bf) {
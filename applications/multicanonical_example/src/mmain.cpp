@@ -109,7 +109,7 @@ void multi_iterate_weights(std::vector<Field<double>> &N_phi) {
 
         // compute and feed the order parameter of the configuration to the
         // iterator
-        iterate_status = hila::muca::iterate_weights(OPs[0]);
+        iterate_status = hila::muca::iterate_weights_multi(OPs);
     }
     hila::muca::write_weight_function(hila::muca::generate_outfile_name());
 }
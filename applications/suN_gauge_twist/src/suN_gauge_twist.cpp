@@ -5,6 +5,7 @@
 #include "gauge/sun_overrelax.h"
 #include "hila.h"
 #include "multicanonical.h"
+#include "replica_exchange.h"
 
 //#include "gauge/polyakov.h"
 
@@ -269,6 +270,22 @@ void iterate_weights_multicanonical(GaugeField<mygroup> U,
   hila::muca::write_weight_function(hila::muca::generate_outfile_name());
 }
 
+/**
+ * @brief Action of U with the given replica exchange parameters {beta, twist coeff}
+ *
+ * @param U Gauge field
+ * @param v Parameter set of a replica exchange slot
+ * @param p Parameters struct
+ */
+double replica_action(const GaugeField<mygroup> &U, const std::vector<double> &v,
+                      const parameters &p) {
+  auto plaq = measure_plaq_with_z(U, static_cast<int>(v[1])).back();
+  double S = v[0] * plaq * (lattice.volume() * NDIM * (NDIM - 1)) / 2;
+  if (p.muca_action)
+    S += hila::muca::weight(plaq);
+  return S;
+}
+
 int main(int argc, char **argv) {
   parameters p;
   CoordinateVector lsize;
@@ -333,6 +350,22 @@ int main(int argc, char **argv) {
   p.measure_surface = par.get("measure_surface");
   std::string initial_state = par.get("initial_state");
 
+  // replica exchange of {beta, twist coeff} between partitions
+  std::vector<std::vector<double>> replica_params;
+  if (hila::partitions.number() > 1 &&
+      par.get_item("replica exchange", {"off", "on"}) == 1) {
+    std::vector<double> betas = par.get("replica betas");
+    std::vector<int> twists = par.get("replica twist coeffs");
+    if (betas.size() != hila::partitions.number() ||
+        twists.size() != hila::partitions.number()) {
+      hila::out0 << "Error in input file: 'replica betas' and 'replica twist coeffs' "
+                    "need one value for each partition\n";
+      hila::terminate(0);
+    }
+    for (int i = 0; i < betas.size(); i++)
+      replica_params.push_back({betas[i], (double)twists[i]});
+  }
+
   par.close(); // file is closed also when par goes out of scope
 
   if (hila::cmdline.flag_present("-beta")) {
@@ -394,6 +427,16 @@ int main(int argc, char **argv) {
 
   // restore_checkpoint(U, start_traj, p);
 
+  std::unique_ptr<hila::replica_exchange> rex;
+  if (replica_params.size() > 0) {
+    rex = std::make_unique<hila::replica_exchange>(replica_params);
+    rex->restore_checkpoint();
+    p.beta = rex->parameters()[0];
+    p.twist_coeff = static_cast<int>(rex->parameters()[1]);
+    hila::out0 << "Replica exchange slot " << rex->slot() << ", beta " << p.beta
+               << " twist coeff " << p.twist_coeff << '\n';
+  }
+
   //  muca_timer.start();
 
   if (p.muca_action || p.muca_poly) {
@@ -435,6 +478,16 @@ int main(int argc, char **argv) {
     hila::synchronize_threads();
     update_timer.stop();
 
+    if (rex && rex->exchange([&](const std::vector<double> &v) {
+          return replica_action(U, v, p);
+        })) {
+      p.beta = rex->parameters()[0];
+      p.twist_coeff = static_cast<int>(rex->parameters()[1]);
+    }
+    if (rex)
+      hila::out0 << "replica slot " << rex->slot() << " beta " << p.beta << " twist coeff "
+                 << p.twist_coeff << '\n';
+
     // trajectory is negative during thermalization
     if (trajectory >= 0) {
       measure_timer.start();
@@ -453,8 +506,12 @@ int main(int argc, char **argv) {
 
     if (p.n_save > 0 && (trajectory + 1) % p.n_save == 0) {
       checkpoint(U, trajectory, p);
+      if (rex)
+        rex->checkpoint();
     }
   }
+  if (rex)
+    rex->report();
   
   hila::out0 << "MEASURE end\n";
   hila::out0 << expi(4.0 / 3.0 * M_PI) << std::endl;
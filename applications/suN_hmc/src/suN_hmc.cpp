@@ -27,6 +27,7 @@
 #include "gauge/gradient_flow.h"
 #include "tools/string_format.h"
 #include "tools/floating_point_epsilon.h"
+#include "tools/measurement_pipeline.h"
 
 #ifdef STOUTSMEAR
 #include "gauge/stout_smear.h"
@@ -59,6 +60,8 @@ struct parameters {
     int n_save;         // number of trajectories between config. check point
     std::string config_file;
     ftype time_offset;
+    bool pipeline;      // gradient flow in partition 1 while partition 0 runs HMC
+    double pipeline_mb; // memory limit for snapshots waiting for gradient flow
 };
 
 
@@ -239,6 +242,42 @@ void measure_stuff(const GaugeField<group> &U, const VectorField<Algebra<group>>
                << '\n';
 }
 
+template <typename group>
+void measure_gradient_flow(const GaugeField<group> &U, int gtrajectory, const parameters &p,
+                           ftype &t_step0) {
+    // perform gradient flow measurements on a copy of U
+
+    static hila::timer gf_timer("Gradient Flow");
+    gf_timer.start();
+
+    int nflow_steps = (int)(p.gflow_max_l / p.gflow_l_step);
+
+    ftype gftime = hila::gettime();
+    hila::out0 << "Gflow_start " << gtrajectory << '\n';
+
+    GaugeField<group> V = U;
+
+    ftype t_step = t_step0;
+    measure_gradient_flow_stuff(V, (ftype)0.0, t_step);
+    t_step = do_gradient_flow_adapt(V, (ftype)0.0, p.gflow_l_step, p.gflow_a_accu,
+                                    p.gflow_r_accu, t_step);
+    measure_gradient_flow_stuff(V, p.gflow_l_step, t_step);
+    t_step0 = t_step;
+
+    for (int i = 1; i < nflow_steps; ++i) {
+
+        t_step = do_gradient_flow_adapt(V, i * p.gflow_l_step, (i + 1) * p.gflow_l_step,
+                                        p.gflow_a_accu, p.gflow_r_accu, t_step);
+
+        measure_gradient_flow_stuff(V, (i + 1) * p.gflow_l_step, t_step);
+    }
+
+    gf_timer.stop();
+
+    hila::out0 << "Gflow_end " << gtrajectory << "    time " << std::setprecision(3)
+               << hila::gettime() - gftime << '\n';
+}
+
 // end measurement functions
 ///////////////////////////////////////////////////////////////////////////////////
 // load/save config functions
@@ -370,6 +409,10 @@ int main(int argc, char **argv) {
     p.n_save = par.get("trajs/saved");
     // measure surface properties and print "profile"
     p.config_file = par.get("config name");
+    // gradient flow in a separate partition (run with -partitions 2)
+    p.pipeline = (par.get_item("measurement pipeline", {"off", "on"}) == 1);
+    if (p.pipeline)
+        p.pipeline_mb = par.get("pipeline buffer MB");
 
     par.close(); // file is closed also when par goes out of scope
 
@@ -383,6 +426,21 @@ int main(int argc, char **argv) {
     GaugeField<mygroup> U;
     VectorField<Algebra<mygroup>> E;
 
+    ftype t_step0 = 0.0;
+
+    // With the measurement pipeline partition 1 only runs the gradient flow on the
+    // snapshots sent by partition 0, in trajectory order
+    std::unique_ptr<hila::measurement_pipeline> pipe;
+    if (p.pipeline) {
+        pipe = std::make_unique<hila::measurement_pipeline>(U, p.pipeline_mb);
+        if (pipe->is_consumer()) {
+            int64_t trajectory;
+            while (pipe->receive(U, trajectory))
+                measure_gradient_flow(U, trajectory / p.gflow_freq, p, t_step0);
+            hila::finishrun();
+        }
+    }
+
     if (0 && hila::myrank() == 0) {
         // test matrix exponential and corresponding differential computations
         Alg_gen<NCOLOR, ftype> genlist[NCOLOR * NCOLOR - 1];
@@ -430,13 +488,11 @@ int main(int argc, char **argv) {
 
     hila::timer update_timer("Updates");
     hila::timer measure_timer("Measurements");
-    hila::timer gf_timer("Gradient Flow");
 
     auto orig_dt = p.dt;
     auto orig_trajlen = p.trajlen;
     GaugeField<mygroup> U_old;
     int nreject = 0;
-    ftype t_step0 = 0.0;
     double g_act_old, act_old, g_act_new, act_new;
     g_act_old = p.beta * measure_s(U);
 
@@ -530,36 +586,10 @@ int main(int argc, char **argv) {
             if (p.gflow_freq > 0 && trajectory % p.gflow_freq == 0) {
                 int gtrajectory = trajectory / p.gflow_freq;
                 if (p.gflow_l_step > 0) {
-
-                    gf_timer.start();
-
-                    int nflow_steps = (int)(p.gflow_max_l / p.gflow_l_step);
-
-                    ftype gftime = hila::gettime();
-                    hila::out0 << "Gflow_start " << gtrajectory << '\n';
-
-                    GaugeField<mygroup> V = U;
-
-                    ftype t_step = t_step0;
-                    measure_gradient_flow_stuff(V, (ftype)0.0, t_step);
-                    t_step = do_gradient_flow_adapt(V, (ftype)0.0, p.gflow_l_step, p.gflow_a_accu,
-                                                    p.gflow_r_accu, t_step);
-                    measure_gradient_flow_stuff(V, p.gflow_l_step, t_step);
-                    t_step0 = t_step;
-
-                    for (int i = 1; i < nflow_steps; ++i) {
-
-                        t_step =
-                            do_gradient_flow_adapt(V, i * p.gflow_l_step, (i + 1) * p.gflow_l_step,
-                                                   p.gflow_a_accu, p.gflow_r_accu, t_step);
-
-                        measure_gradient_flow_stuff(V, (i + 1) * p.gflow_l_step, t_step);
-                    }
-
-                    gf_timer.stop();
-
-                    hila::out0 << "Gflow_end " << gtrajectory << "    time " << std::setprecision(3)
-                               << hila::gettime() - gftime << '\n';
+                    if (pipe && pipe->is_producer())
+                        pipe->send(U, trajectory);
+                    else
+                        measure_gradient_flow(U, gtrajectory, p, t_step0);
                 }
             }
         }
@@ -569,5 +599,8 @@ int main(int argc, char **argv) {
         }
     }
 
+    if (pipe)
+        pipe->finish();
+
     hila::finishrun();
 }
@@ -129,11 +129,34 @@ void TopLevelVisitor::generate_code(Stmt *S) {
     // Build replacement in variable "code"
     // Encapsulate everything within {}
     std::stringstream code;
+
+    // Inside a parallel region the ReductionVector init and the MPI reduction must be
+    // done by one thread; the whole loop is run by that thread
+    bool in_omp_single = false;
+    if (target.openmp && loop_info.has_pragma_omp_parallel_region) {
+        for (array_ref &ar : array_ref_list) {
+            if (ar.type == array_ref::REDUCTION) {
+                code << "#pragma omp single\n";
+                in_omp_single = true;
+                break;
+            }
+        }
+    }
     code << "{\n";
 
+    // Otherwise all threads of the parallel region run this code.  The site rng loop
+    // counter and flag are shared, so one thread updates them; the barrier at the end
+    // of omp single makes the new values visible to the others
+    std::string site_rng_single;
+    if (target.openmp && loop_info.has_pragma_omp_parallel_region && !in_omp_single)
+        site_rng_single = "#pragma omp single\n";
 
     if (loop_info.contains_random) {
         code << "hila::check_that_rng_is_initialized();\n";
+
+        // on non-kernelized targets random numbers come from the per-site generator
+        if (!target.kernelize)
+            code << site_rng_single << "hila::begin_site_rng_loop();\n";
     }
 
     const std::string t = loopBuf.dump();
@@ -195,6 +218,28 @@ void TopLevelVisitor::generate_code(Stmt *S) {
             code << l.new_name << ".check_alloc();\n";
         }
 
+    // Loop profiling: static entry keyed by file:line, and a scope object which
+    // times the rest of the loop block.  Bytes/site counts local reads, writes and
+    // one read for each neighbour direction or offset
+    if (cmdline::loop_profile) {
+        SourceLocation sl = get_real_range(S->getSourceRange()).getBegin();
+        std::string fname = srcMgr.getFilename(sl).str();
+        fname = fname.substr(fname.find_last_of('/') + 1);
+
+        std::string bytes = "0";
+        for (field_info &l : field_info_list) {
+            int n = (l.is_read_atX ? 1 : 0) + (l.is_written ? 1 : 0) + l.dir_list.size();
+            if (n > 0)
+                bytes += " + " + std::to_string(n) + " * sizeof(" + l.element_type + ")";
+        }
+
+        code << "static hila::loop_profile_entry " << name_prefix << "loop_profile_(\"" << fname
+             << "\", " << srcMgr.getSpellingLineNumber(sl) << ");\n";
+        code << "hila::loop_profile_scope " << name_prefix << "loop_profile_scope_("
+             << name_prefix << "loop_profile_, " << bytes << ", " << loop_info.parity_str
+             << ");\n";
+    }
+
     // Check that read fields are initialized
     for (field_info &l : field_info_list) {
         if (l.is_read_nb || l.is_read_atX) {
@@ -230,6 +275,29 @@ void TopLevelVisitor::generate_code(Stmt *S) {
     // change the f[X+offset] -references, generate code
     handle_field_plus_offsets(code, loopBuf, loop_info.parity_str);
 
+    // directions gathered for loop local direction refs, see direction_range_analysis.cpp
+    for (field_info &l : field_info_list) {
+        if (l.is_loop_local_dir && l.restrict_dirs) {
+            code << "unsigned " << l.new_name << "_dirs_ = 0;\n";
+            bool has_cond = false;
+            for (auto &gd : l.gather_dirs) {
+                if (gd.first.size() == 0)
+                    code << l.new_name << "_dirs_ |= 1u << (" << gd.second << ");\n";
+                else
+                    has_cond = true;
+            }
+            if (has_cond) {
+                code << "for (Direction _HILAdir_ = (Direction)0; _HILAdir_ < NDIRS; "
+                        "++_HILAdir_) {\n";
+                for (auto &gd : l.gather_dirs)
+                    if (gd.first.size() > 0)
+                        code << "if (" << gd.first << ") " << l.new_name << "_dirs_ |= 1u << ("
+                             << gd.second << ");\n";
+                code << "}\n";
+            }
+        }
+    }
+
     bool first = true;
     bool generate_wait_loops;
     if (cmdline::no_interleaved_comm)
@@ -256,19 +324,16 @@ void TopLevelVisitor::generate_code(Stmt *S) {
                     }
                 }
         } else {
-            // now loop local dirs - gather all neighbours!
-            // TODO: restrict dirs
+            // now loop local dirs - gather the neighbours which may be referenced
             if (!generate_wait_loops) {
-                code << "for (Direction _HILAdir_ = (Direction)0; _HILAdir_ < NDIRS; "
-                        "++_HILAdir_) {\n"
+                code << loop_local_dir_loop(l) << " {\n"
                      << l.new_name << ".start_gather(_HILAdir_," << loop_info.parity_str
                      << ");\n}\n";
             } else {
                 if (first)
                     code << "dir_mask_t  _dir_mask_ = 0;\n";
                 first = false;
-                code << "for (Direction _HILAdir_ = (Direction)0; _HILAdir_ < NDIRS; "
-                        "++_HILAdir_) {\n"
+                code << loop_local_dir_loop(l) << " {\n"
                      << "_dir_mask_ |= " << l.new_name << ".start_gather(_HILAdir_,"
                      << loop_info.parity_str << ");\n}\n";
             }
@@ -279,8 +344,7 @@ void TopLevelVisitor::generate_code(Stmt *S) {
     if (!generate_wait_loops)
         for (field_info &l : field_info_list)
             if (l.is_loop_local_dir) {
-                code << "for (Direction _HILAdir_ = (Direction)0; _HILAdir_ < NDIRS; "
-                        "++_HILAdir_) {\n"
+                code << loop_local_dir_loop(l) << " {\n"
                      << l.new_name << ".wait_gather(_HILAdir_," << loop_info.parity_str
                      << ");\n}\n";
             }
@@ -340,6 +404,10 @@ void TopLevelVisitor::generate_code(Stmt *S) {
     // Place the content of the loop
     code << backend_generate_code(S, semicolon_at_end, loopBuf, generate_wait_loops);
 
+    if (loop_info.contains_random && !target.kernelize) {
+        code << site_rng_single << "hila::end_site_rng_loop();\n";
+    }
+
     // Check reduction variables
     for (reduction_expr &v : reduction_list) {
 
@@ -556,6 +624,15 @@ void GeneralVisitor::backend_handle_loop_constructor(call_info_struct &ci) {
     }
 }
 
+/// Loop header over the directions gathered for a field with loop local direction refs:
+/// all NDIRS, or those in the mask computed before the gathers
+std::string TopLevelVisitor::loop_local_dir_loop(const field_info &l) {
+    std::string s = "for (Direction _HILAdir_ = (Direction)0; _HILAdir_ < NDIRS; ++_HILAdir_)";
+    if (l.restrict_dirs)
+        s += "\nif (" + l.new_name + "_dirs_ & (1u << _HILAdir_))";
+    return s;
+}
+
 /// Call the backend function for generating loop code
 std::string TopLevelVisitor::backend_generate_code(Stmt *S, bool semicolon_at_end, srcBuf &loopBuf,
                                                    bool generate_wait_loops) {
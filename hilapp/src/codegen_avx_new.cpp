@@ -206,6 +206,7 @@ struct vecinfo_struct {
     number_type numtype;
     std::string var_name; // variable which determines the vectorization
     std::string var_type; // type of variable which determines the vectorization
+    std::string vectortype; // and the vector type, e.g. Vec4d
 };
 
 //
@@ -225,6 +226,7 @@ static bool are_vectors_compatible(const vectorization_info &vecinfo, const std:
         vinfo.numtype = vecinfo.basetype;
         vinfo.var_name = name;
         vinfo.var_type = vecinfo.basetype_str;
+        vinfo.vectortype = vecinfo.vectortype;
 
     } else if (vecinfo.vector_size != vinfo.vector_size || vecinfo.basetype != vinfo.numtype) {
         return false;
@@ -243,9 +245,11 @@ static bool are_vectors_compatible(const vectorization_info &vecinfo, const std:
 ///       vector type.  Otherwise leads to missing type conversions
 ///  TODO: Rectify this issue!
 ///  d) no site selection operation in the loop
+///  e) random numbers only through calls which have vector versions
 ///////////////////////////////////////////////////////////////////////////////////
 
-bool TopLevelVisitor::check_loop_vectorizable(Stmt *S, int &vector_size_, std::string &diag_str) {
+bool TopLevelVisitor::check_loop_vectorizable(Stmt *S, int &vector_size_,
+                                              std::string &vector_type_, std::string &diag_str) {
 
     bool is_vectorizable = true;
 
@@ -266,9 +270,9 @@ bool TopLevelVisitor::check_loop_vectorizable(Stmt *S, int &vector_size_, std::s
             reason.push_back("it contains site dependent conditional or array index");
         }
 
-        if (contains_random(S)) {
+        if (contains_vector_unsafe_random(S)) {
             is_vectorizable = false;
-            reason.push_back("it contains a random number generator");
+            reason.push_back("it contains a random number generator call without vector version");
         }
 
         if (selection_info_list.size() > 0) {
@@ -356,10 +360,6 @@ bool TopLevelVisitor::check_loop_vectorizable(Stmt *S, int &vector_size_, std::s
                     is_vectorizable = false;
 
                     reason.push_back("function 'X.parity()' is not AVX vectorizable");
-
-                } else if (sfc.name == "random" || sfc.name == "hila::random") {
-                    is_vectorizable = false;
-                    reason.push_back("random number generators prevent vectorization");
                 }
             }
         }
@@ -412,6 +412,7 @@ bool TopLevelVisitor::check_loop_vectorizable(Stmt *S, int &vector_size_, std::s
     }
 
     vector_size_ = vinfo.vector_size;
+    vector_type_ = vinfo.vectortype;
     return is_vectorizable;
 }
 
@@ -424,10 +425,11 @@ std::string TopLevelVisitor::generate_code_avx(Stmt *S, bool semicolon_at_end, s
 
     std::stringstream code;
     int vector_size;
+    std::string vector_type;
 
     // is the loop vectorizable?
     std::string vector_diag;
-    bool is_vectorized = check_loop_vectorizable(S, vector_size, vector_diag);
+    bool is_vectorized = check_loop_vectorizable(S, vector_size, vector_type, vector_diag);
 
     code << comment_string(vector_diag) << '\n';
 
@@ -471,10 +473,18 @@ std::string TopLevelVisitor::generate_code_avx(Stmt *S, bool semicolon_at_end, s
     code << "const int loop_begin = loop_lattice.loop_begin(" << loop_info.parity_str << ");\n";
     code << "const int loop_end   = loop_lattice.loop_end(" << loop_info.parity_str << ");\n";
 
+    if (target.openmp)
+        generate_openmp_vector_reductions(code, loopBuf);
+
     if (generate_wait_loops) {
         code << "for (int _wait_i_ = 0; _wait_i_ < 2; ++_wait_i_) {\n";
     }
 
+    // hybrid AVX + OpenMP: threads share the vector loop
+    if (target.openmp) {
+        generate_openmp_loop_header(code, true);
+    }
+
     // Start the loop
     code << "for(int " << looping_var << " = loop_begin; " << looping_var << " < loop_end; ++"
          << looping_var << ") {\n";
@@ -484,6 +494,11 @@ std::string TopLevelVisitor::generate_code_avx(Stmt *S, bool semicolon_at_end, s
              << "] & _dir_mask_) != 0) == _wait_i_) {\n";
     }
 
+    // per-site random numbers to the lanes of this vector
+    if (loop_info.contains_random) {
+        code << "hila::set_site_rng_vector(" << looping_var << ", " << vector_size << ");\n";
+    }
+
 
     // Create temporary field element variables
     for (field_info &l : field_info_list) {
@@ -639,6 +654,13 @@ std::string TopLevelVisitor::generate_code_avx(Stmt *S, bool semicolon_at_end, s
     // Handle calls to special in-loop functions
     for (special_function_call &sfc : special_function_call_list) {
         std::string repl = sfc.replace_expression; // comes with ( now
+
+        // scalar random number calls return vectors here
+        if (sfc.name == "random")
+            repl = "hila::random<" + vector_type + ">()";
+        else if (sfc.name == "gaussrand")
+            repl = "hila::gaussian_random<" + vector_type + ">()";
+
         if (sfc.add_loop_var) {
             repl += looping_var;
             if (sfc.argsExpr != nullptr)
@@ -696,8 +718,7 @@ std::string TopLevelVisitor::generate_code_avx(Stmt *S, bool semicolon_at_end, s
                     }
 
             } else {
-                code << "for (Direction _HILAdir_ = (Direction)0; _HILAdir_ < NDIRS; "
-                        "++_HILAdir_) {\n"
+                code << loop_local_dir_loop(l) << " {\n"
                      << "  " << l.new_name << ".wait_gather(_HILAdir_, " << loop_info.parity_str
                      << ");\n}\n";
             }
@@ -14,6 +14,113 @@
 extern std::string looping_var;
 extern std::string parity_name;
 
+/// OpenMP pragmas for the site loop, used by the cpu and vectorized (AVX) targets.
+/// In vectorized loops the reduction variables are the vector-typed loop variables.
+/// Non-arithmetic reduction types get a declared reduction.
+/// Random numbers in the loop use the per-site generator, thread safe.
+
+/// ReductionVectors are reduced as OpenMP array sections of their data.  The refs in the
+/// loop body are changed to go through a raw data pointer, which is the reduction
+/// list item.  Non-arithmetic element types get a declared reduction.  Called before
+/// the loop body is generated.
+
+void TopLevelVisitor::generate_openmp_vector_reductions(std::stringstream &code,
+                                                        srcBuf &loopBuf) {
+
+    // in an omp parallel region the whole loop is in omp single, see codegen.cpp
+    if (loop_info.has_pragma_omp_parallel_region)
+        return;
+
+    int i = 0;
+    for (array_ref &ar : array_ref_list) {
+        if (ar.type == array_ref::REDUCTION) {
+            ar.new_name = name_prefix + "vred_" + std::to_string(i) + "_";
+            code << ar.element_type << " * " << ar.new_name << " = " << ar.data_ptr << ";\n";
+            code << "const int " << ar.new_name << "n = " << ar.size_expr << ";\n";
+
+            if (get_number_type(ar.element_type) == number_type::UNKNOWN) {
+                bool is_sum = (ar.reduction_type == reduction::SUM);
+                std::string tname = "_hila_omp_vreduction_type" + std::to_string(i);
+
+                code << "using " << tname << " = " << ar.element_type << ";\n";
+                code << "#pragma omp declare reduction(_hila_vreduction" << i << ":" << tname
+                     << ":omp_out " << (is_sum ? "+=" : "*=") << " omp_in) initializer(omp_priv = "
+                     << tname << (is_sum ? "(0))" : "(1))") << '\n';
+            }
+
+            for (bracket_ref_t &br : ar.refs) {
+                loopBuf.replace(br.BASE, ar.new_name);
+            }
+            i++;
+        }
+    }
+}
+
+void TopLevelVisitor::generate_openmp_loop_header(std::stringstream &code, bool vectorized) {
+
+    // ReductionVector loop in omp parallel region is run in omp single
+    if (loop_info.has_pragma_omp_parallel_region) {
+        for (array_ref &ar : array_ref_list) {
+            if (ar.type == array_ref::REDUCTION) {
+                code << "// Loop in omp single, contains ReductionVector\n";
+                return;
+            }
+        }
+    }
+
+    int n_declared = 0;
+    for (reduction_expr &r : reduction_list) {
+        if (r.reduction_type != reduction::NONE &&
+            (vectorized || get_number_type(r.type) == number_type::UNKNOWN)) {
+            bool is_sum = (r.reduction_type == reduction::SUM);
+            std::string tname = "_hila_omp_reduction_type" + std::to_string(n_declared);
+
+            code << "using " << tname << " = "
+                 << (vectorized ? r.vecinfo.vectorized_type : r.type) << ";\n";
+            code << "#pragma omp declare reduction(_hila_reduction" << n_declared << ":" << tname
+                 << ":omp_out " << (is_sum ? "+=" : "*=") << " omp_in) initializer(omp_priv = "
+                 << tname << (is_sum ? "(0))" : "(1))") << '\n';
+            n_declared++;
+        }
+    }
+
+    if (loop_info.has_pragma_omp_parallel_region)
+        code << "#pragma omp for";
+    else
+        code << "#pragma omp parallel for";
+
+    n_declared = 0;
+    for (reduction_expr &r : reduction_list) {
+        if (r.reduction_type != reduction::NONE) {
+            code << " reduction(";
+            if (vectorized || get_number_type(r.type) == number_type::UNKNOWN) {
+                code << "_hila_reduction" << n_declared++;
+            } else if (r.reduction_type == reduction::SUM) {
+                code << '+';
+            } else {
+                code << '*';
+            }
+            code << ": " << (vectorized ? r.loop_name : r.reduction_name) << ")";
+        }
+    }
+
+    int i = 0;
+    for (array_ref &ar : array_ref_list) {
+        if (ar.type == array_ref::REDUCTION) {
+            code << " reduction(";
+            if (get_number_type(ar.element_type) == number_type::UNKNOWN)
+                code << "_hila_vreduction" << i;
+            else if (ar.reduction_type == reduction::SUM)
+                code << '+';
+            else
+                code << '*';
+            code << ": " << ar.new_name << "[:" << ar.new_name << "n])";
+            i++;
+        }
+    }
+    code << '\n';
+}
+
 std::string TopLevelVisitor::generate_code_cpu(Stmt *S, bool semicolon_at_end, srcBuf &loopBuf,
                                                bool generate_wait_loops) {
     std::stringstream code;
@@ -34,53 +141,47 @@ std::string TopLevelVisitor::generate_code_cpu(Stmt *S, bool semicolon_at_end, s
     code << "const int loop_begin = loop_lattice.loop_begin(" << loop_info.parity_str << ");\n";
     code << "const int loop_end   = loop_lattice.loop_end(" << loop_info.parity_str << ");\n";
 
-    // are there
+    // Loops which wait for gathers: the interior sites, whose neighbours in the
+    // gathered directions are on this node, are looped over first in contiguous
+    // blocks, then the gathers are waited for and the boundary sites are done from
+    // an index list.  The loop body is generated for both loops.  Only with option
+    // -split-site-loops; otherwise, and for OpenACC and loops inside an omp parallel
+    // region, the loop tests the per-site wait mask instead.
+    bool split_sites = cmdline::split_site_loops && generate_wait_loops && !target.openacc &&
+                       !loop_info.has_pragma_omp_parallel_region;
+    bool mask_wait_loops = generate_wait_loops && !split_sites;
 
-    if (generate_wait_loops) {
+    if (target.openmp)
+        generate_openmp_vector_reductions(code, loopBuf);
+
+    if (mask_wait_loops) {
         code << "for (int _wait_i_ = 0; _wait_i_ < 2; ++_wait_i_) {\n";
     }
 
-    // and the openacc loop header
-    if (target.openacc) {
-        generate_openacc_loop_header(code);
-    } else if (target.openmp && !loop_info.contains_random) {
-        int sums = 0;
-        for (reduction_expr &r : reduction_list) {
-            if (r.reduction_type != reduction::NONE &&
-                get_number_type(r.type) == number_type::UNKNOWN) {
-                code << "#pragma omp declare reduction(_hila_reduction_sum" << sums << ":" << r.type
-                     << ":omp_out += omp_in)\n";
-                sums++;
-            }
+    if (!split_sites) {
+        // and the openacc loop header
+        if (target.openacc) {
+            generate_openacc_loop_header(code);
+        } else if (target.openmp) {
+            generate_openmp_loop_header(code, false);
         }
-        if (loop_info.has_pragma_omp_parallel_region)
-            code << "#pragma omp for";
-        else
-            code << "#pragma omp parallel for";
-
-        sums = 0;
-        for (reduction_expr &r : reduction_list) {
-            if (r.reduction_type != reduction::NONE) {
-                code << " reduction(";
-                if (get_number_type(r.type) == number_type::UNKNOWN) {
-                    code << "_hila_reduction_sum" << sums;
-                } else {
-                    code << '+';
-                }
-                code << ": " << r.reduction_name << ")";
-            }
+
+        // Start the loop
+        code << "for(int " << looping_var << " = loop_begin; " << looping_var << " < loop_end; ++"
+             << looping_var << ") {\n";
+
+        if (mask_wait_loops) {
+            code << "if (((loop_lattice.wait_arr_[" << looping_var
+                 << "] & _dir_mask_) != 0) == _wait_i_) {\n";
         }
-        code << '\n';
     }
 
+    // per-site code of the loop
+    std::stringstream body;
 
-    // Start the loop
-    code << "for(int " << looping_var << " = loop_begin; " << looping_var << " < loop_end; ++"
-         << looping_var << ") {\n";
-
-    if (generate_wait_loops) {
-        code << "if (((loop_lattice.wait_arr_[" << looping_var
-             << "] & _dir_mask_) != 0) == _wait_i_) {\n";
+    // set the per-site random number generator to this site
+    if (loop_info.contains_random) {
+        body << "hila::set_site_rng(" << looping_var << ");\n";
     }
 
     // replace reduction variables in the loop
@@ -123,17 +224,17 @@ std::string TopLevelVisitor::generate_code_cpu(Stmt *S, bool semicolon_at_end, s
                                                                           // get_stmt_str(d.e);
 
                     // generate access stmt
-                    code << "const " << l.element_type << " " << d.name_with_dir << " = "
+                    body << "const " << l.element_type << " " << d.name_with_dir << " = "
                          << l.new_name;
 
                     if (target.vectorize && l.vecinfo.is_vectorizable) {
                         // now l is vectorizable, but accessed sequentially -- this inly
                         // happens in vectorized targets
-                        code << ".get_value_at_nb_site(" << dirname << ", " << looping_var
+                        body << ".get_value_at_nb_site(" << dirname << ", " << looping_var
                              << ");\n";
                     } else {
                         // std neighbour accessor for scalars
-                        code << ".get_value_at(" << l.new_name << ".fs->neighbours[" << dirname
+                        body << ".get_value_at(" << l.new_name << ".fs->neighbours[" << dirname
                              << "][" << looping_var << "]);\n";
                     }
 
@@ -177,18 +278,18 @@ std::string TopLevelVisitor::generate_code_cpu(Stmt *S, bool semicolon_at_end, s
             // if (!l.is_written) {
             //     code << "const ";
             // }
-            code << l.element_type << " " << l.loop_ref_name << " = " << l.new_name
+            body << l.element_type << " " << l.loop_ref_name << " = " << l.new_name
                  << ".get_value_at(" << looping_var << ");\n";
 
             if (!l.is_read_atX) {
-                code << "// Value of var " << l.loop_ref_name
+                body << "// Value of var " << l.loop_ref_name
                      << " read in because loop has conditional\n";
-                code << "// TODO: MAY BE UNNECESSARY, write more careful analysis\n";
+                body << "// TODO: MAY BE UNNECESSARY, write more careful analysis\n";
             }
 
         } else if (l.is_written) {
-            code << l.element_type << " " << l.loop_ref_name << ";\n";
-            code << "// Initial value of variable " << l.loop_ref_name << " not needed\n";
+            body << l.element_type << " " << l.loop_ref_name << ";\n";
+            body << "// Initial value of variable " << l.loop_ref_name << " not needed\n";
         }
 
         // and finally replace references in body
@@ -223,40 +324,78 @@ std::string TopLevelVisitor::generate_code_cpu(Stmt *S, bool semicolon_at_end, s
     }
 
     // Dump the main loop code here
-    code << loopBuf.dump();
+    body << loopBuf.dump();
     if (semicolon_at_end)
-        code << ";";
-    code << "\n";
+        body << ";";
+    body << "\n";
 
     // Add calls to setters
     for (field_info &l : field_info_list)
         if (l.is_written) {
-            code << l.new_name << ".set_value_at(" << l.loop_ref_name << ", " << looping_var
+            body << l.new_name << ".set_value_at(" << l.loop_ref_name << ", " << looping_var
                  << ");\n";
         }
 
-    code << "}\n";
-
+    // wait for the gathers started before the loop
+    std::stringstream waits;
     if (generate_wait_loops) {
-        // add the code for 2nd round - also need one } to balance the if ()
-        code << "}\nif (_dir_mask_ == 0) break;    // No need for another round\n";
-
         for (field_info &l : field_info_list) {
             // If neighbour references exist, communicate them
             if (!l.is_loop_local_dir) {
                 for (dir_ptr &d : l.dir_list)
                     if (d.count > 0) {
-                        code << l.new_name << ".wait_gather(" << d.direxpr_s << ", "
-                             << loop_info.parity_str << ");\n";
+                        waits << l.new_name << ".wait_gather(" << d.direxpr_s << ", "
+                              << loop_info.parity_str << ");\n";
                     }
             } else {
-                code << "for (Direction _HILAdir_ = (Direction)0; _HILAdir_ < NDIRS; "
-                        "++_HILAdir_) {\n"
-                     << "  " << l.new_name << ".wait_gather(_HILAdir_, " << loop_info.parity_str
-                     << ");\n}\n";
+                waits << loop_local_dir_loop(l) << " {\n"
+                      << "  " << l.new_name << ".wait_gather(_HILAdir_, "
+                      << loop_info.parity_str << ");\n}\n";
             }
         }
-        code << "}\n";
+    }
+
+    if (split_sites) {
+        std::string split = name_prefix + "site_split_";
+        code << "const lattice_struct::site_split_struct & " << split
+             << " = loop_lattice.site_split(" << loop_info.parity_str << ", _dir_mask_);\n";
+
+        // interior blocks
+        if (target.openmp)
+            generate_openmp_loop_header(code, false);
+        code << "for (int " << name_prefix << "block_ = 0; " << name_prefix << "block_ < (int)"
+             << split << ".interior.size(); ++" << name_prefix << "block_) {\n";
+        code << "for (int " << looping_var << " = " << split << ".interior[" << name_prefix
+             << "block_].begin; " << looping_var << " < (int)" << split << ".interior["
+             << name_prefix << "block_].end; ++" << looping_var << ") {\n";
+        code << body.str() << "}\n}\n";
+
+        if (cmdline::loop_profile)
+            code << name_prefix << "loop_profile_scope_.interior_done(" << split
+                 << ".n_interior);\n";
+
+        // nothing to wait for if all gathers were done already
+        code << "if (_dir_mask_ != 0) {\n";
+        code << waits.str();
+
+        // boundary sites
+        if (target.openmp)
+            generate_openmp_loop_header(code, false);
+        code << "for (int " << name_prefix << "bi_ = 0; " << name_prefix << "bi_ < (int)"
+             << split << ".boundary.size(); ++" << name_prefix << "bi_) {\n";
+        code << "const int " << looping_var << " = " << split << ".boundary[" << name_prefix
+             << "bi_];\n";
+        code << body.str() << "}\n}\n";
+
+    } else {
+        code << body.str() << "}\n";
+
+        if (mask_wait_loops) {
+            // add the code for 2nd round - also need one } to balance the if ()
+            code << "}\nif (_dir_mask_ == 0) break;    // No need for another round\n";
+            code << waits.str();
+            code << "}\n";
+        }
     }
 
     // Post-process ny site selections?
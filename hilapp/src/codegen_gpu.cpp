@@ -141,8 +141,7 @@ std::string TopLevelVisitor::generate_code_gpu(Stmt *S, bool semicolon_at_end, s
                          << loop_info.parity_str << ");\n";
                 }
         } else {
-            code << "for (Direction _HILAdir_ = (Direction)0; _HILAdir_ < NDIRS; "
-                    "++_HILAdir_) {\n"
+            code << loop_local_dir_loop(l) << " {\n"
                  << l.new_name << ".wait_gather(_HILAdir_," << loop_info.parity_str << ");\n}\n";
         }
     }
@@ -87,3 +87,67 @@ bool GeneralVisitor::contains_random(Stmt *s) {
     fdecls.clear();
     return (checker.found_random);
 }
+
+//////////////////////////////////////////////////////////////////////////////
+/// Vectorization check for random numbers: random numbers in vectorized loops
+/// come from the per-site generator through the vector overloads of
+///   hila::random(T &), hila::gaussian_random(T &, w), hila::gaussrand2(T &)
+/// and hilapp replaces direct hila::random() and hila::gaussrand() calls.
+/// The random() and gaussian_random() methods of hila datatypes (libraries/datatypes)
+/// are written using these.  Any other function which (recursively) calls rng
+/// would give the same number to all vector lanes, thus it is "vector unsafe".
+//////////////////////////////////////////////////////////////////////////////
+
+class containsVectorUnsafeRandomChecker
+    : public GeneralVisitor,
+      public RecursiveASTVisitor<containsVectorUnsafeRandomChecker> {
+
+  public:
+    bool found_unsafe;
+
+    template <typename visitor_type>
+    containsVectorUnsafeRandomChecker(visitor_type &v) : GeneralVisitor(v) {
+        found_unsafe = false;
+    }
+
+    bool is_vector_safe_rng(FunctionDecl *FD) {
+        std::string name = FD->getQualifiedNameAsString();
+        if (name == "hila::random" || name == "hila::gaussrand" ||
+            name == "hila::gaussian_random" || name == "hila::gaussrand2")
+            return true;
+
+        if (isa<CXXMethodDecl>(FD)) {
+            std::string mname = FD->getNameAsString();
+            if (mname == "random" || mname == "gaussian_random") {
+                std::string fname = srcMgr.getFilename(FD->getLocation()).str();
+                if (fname.find("datatypes/") != std::string::npos)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    bool VisitStmt(Stmt *S) {
+        if (CallExpr *CE = dyn_cast<CallExpr>(S)) {
+            if (FunctionDecl *FD = CE->getDirectCallee()) {
+
+                if (is_vector_safe_rng(FD))
+                    return true; // args are checked too
+
+                if (has_pragma(FD, pragma_hila::CONTAINS_RNG) ||
+                    (FD->hasBody() && contains_random(FD->getBody()))) {
+                    found_unsafe = true;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+bool GeneralVisitor::contains_vector_unsafe_random(Stmt *s) {
+
+    containsVectorUnsafeRandomChecker checker(*this);
+    checker.TraverseStmt(s);
+    return (checker.found_unsafe);
+}
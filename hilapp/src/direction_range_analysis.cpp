@@ -0,0 +1,458 @@
+#include <sstream>
+#include <iostream>
+#include <string>
+#include <algorithm>
+
+#include "toplevelvisitor.h"
+#include "hilapp.h"
+#include "stringops.h"
+
+//////////////////////////////////////////////////////////////////////////////
+/// Value range analysis of loop local directions.
+///
+/// In Field[X + d], where d depends on a variable defined inside the site loop,
+/// the direction is not known before the loop where the gathers are started.
+/// Collect the conditions which guard each such reference:
+///   - conditions of the enclosing if-statements (negated in else-branch)
+///   - conditions of the enclosing for- and while-loops, e.g. d < NDIM of foralldir(d)
+///   - negated conditions of preceding  "if (cond) continue;"  (or break, return)
+/// The parts of these which depend only on the direction variable and loop
+/// constant values are evaluated before the loop for all values of the variable,
+/// and only the directions which can be referenced are gathered.  For example
+///
+///     onsites(ALL) {
+///         foralldir(d2) if (d2 != d1) {
+///             s[X] += U[d2][X+d1] ...
+///             s[X] += U[d2][X-d2] ...
+///
+/// gathers U[d2] only from -d2 for up-directions d2 != d1.
+///
+/// If the direction variable is modified in the loop other than in the increment
+/// of its for-statement, or the direction expression cannot be analyzed, all
+/// directions are gathered.  Then
+///
+///     #pragma hila directions(e_x, -e_x, d1)
+///
+/// before the loop gives the directions gathered for the loop local direction refs.
+///
+/// Only with hilapp option -direction-analysis (make DIRECTION_ANALYSIS=1), without
+/// it all directions are gathered and the pragma is ignored.
+//////////////////////////////////////////////////////////////////////////////
+
+static bool is_direction_type(QualType qt) {
+    const EnumType *ET = qt.getCanonicalType()->getAs<EnumType>();
+    return ET && ET->getDecl()->getNameAsString() == "Direction";
+}
+
+/// Does the statement refer to the variable
+static bool refers_to_var(Stmt *s, VarDecl *var) {
+    if (s == nullptr)
+        return false;
+    if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(s))
+        if (DRE->getDecl() == var)
+            return true;
+    for (Stmt *c : s->children())
+        if (refers_to_var(c, var))
+            return true;
+    return false;
+}
+
+/// Is the statement (or the last stmt of the block) a jump out of the rest of the block
+static bool is_jump_stmt(Stmt *s) {
+    if (CompoundStmt *CS = dyn_cast<CompoundStmt>(s)) {
+        if (CS->body_empty())
+            return false;
+        s = CS->body_back();
+    }
+    return isa<ContinueStmt>(s) || isa<BreakStmt>(s) || isa<ReturnStmt>(s);
+}
+
+/// Split a && b && c to a, b, c
+static void split_conjunction(Expr *e, std::vector<Expr *> &list) {
+    e = e->IgnoreParenImpCasts();
+    if (BinaryOperator *BO = dyn_cast<BinaryOperator>(e)) {
+        if (BO->getOpcode() == BO_LAnd) {
+            split_conjunction(BO->getLHS(), list);
+            split_conjunction(BO->getRHS(), list);
+            return;
+        }
+    }
+    list.push_back(e);
+}
+
+static bool get_integer_constant(Expr *e, ASTContext &ctx, int64_t &value) {
+    if (e->isValueDependent() || !e->isIntegerConstantExpr(ctx))
+        return false;
+#if defined(__clang_major__) && (__clang_major__ <= 11)
+    llvm::APSInt result;
+    e->isIntegerConstantExpr(result, ctx);
+    value = result.getExtValue();
+#else
+    auto res = e->getIntegerConstantExpr(ctx);
+    if (!res)
+        return false;
+    value = res->getExtValue();
+#endif
+    return true;
+}
+
+/// Walk the loop body and record the guards active at the refs (keys of found)
+
+void TopLevelVisitor::collect_direction_guards(Stmt *s, std::vector<direction_guard> &guards,
+                                              std::map<Expr *, std::vector<direction_guard>> &found) {
+    if (s == nullptr)
+        return;
+
+    if (Expr *E = dyn_cast<Expr>(s)) {
+        auto it = found.find(E);
+        if (it != found.end()) {
+            it->second = guards;
+            return;
+        }
+    }
+
+    if (IfStmt *IS = dyn_cast<IfStmt>(s)) {
+        collect_direction_guards(IS->getInit(), guards, found);
+        collect_direction_guards(IS->getCond(), guards, found);
+        guards.push_back({IS->getCond(), false});
+        collect_direction_guards(IS->getThen(), guards, found);
+        guards.back().second = true;
+        collect_direction_guards(IS->getElse(), guards, found);
+        guards.pop_back();
+        return;
+    }
+
+    if (ForStmt *FS = dyn_cast<ForStmt>(s)) {
+        collect_direction_guards(FS->getInit(), guards, found);
+        collect_direction_guards(FS->getCond(), guards, found);
+        collect_direction_guards(FS->getInc(), guards, found);
+        if (FS->getCond())
+            guards.push_back({FS->getCond(), false});
+        collect_direction_guards(FS->getBody(), guards, found);
+        if (FS->getCond())
+            guards.pop_back();
+        return;
+    }
+
+    if (WhileStmt *WS = dyn_cast<WhileStmt>(s)) {
+        collect_direction_guards(WS->getCond(), guards, found);
+        guards.push_back({WS->getCond(), false});
+        collect_direction_guards(WS->getBody(), guards, found);
+        guards.pop_back();
+        return;
+    }
+
+    if (CompoundStmt *CS = dyn_cast<CompoundStmt>(s)) {
+        size_t n = guards.size();
+        for (Stmt *c : CS->body()) {
+            // jump targets can be reached without the preceding guards
+            if (isa<SwitchCase>(c) || isa<LabelStmt>(c))
+                guards.resize(n);
+
+            collect_direction_guards(c, guards, found);
+
+            // rest of the block is done only if cond is false
+            IfStmt *IS = dyn_cast<IfStmt>(c);
+            if (IS && IS->getElse() == nullptr && is_jump_stmt(IS->getThen()))
+                guards.push_back({IS->getCond(), true});
+        }
+        guards.resize(n);
+        return;
+    }
+
+    for (Stmt *c : s->children())
+        collect_direction_guards(c, guards, found);
+}
+
+/// Is the variable modified in the statement, other than in the increment of the for-loop
+/// which declares it
+
+bool TopLevelVisitor::is_direction_var_modified(Stmt *s, VarDecl *var) {
+    if (s == nullptr)
+        return false;
+
+    if (ForStmt *FS = dyn_cast<ForStmt>(s)) {
+        DeclStmt *DS = dyn_cast_or_null<DeclStmt>(FS->getInit());
+        if (DS && DS->isSingleDecl() && DS->getSingleDecl() == var)
+            return is_direction_var_modified(FS->getCond(), var) ||
+                   is_direction_var_modified(FS->getBody(), var);
+    }
+
+    Expr *target = nullptr;
+    if (BinaryOperator *BO = dyn_cast<BinaryOperator>(s)) {
+        if (BO->isAssignmentOp())
+            target = BO->getLHS();
+    } else if (UnaryOperator *UO = dyn_cast<UnaryOperator>(s)) {
+        if (UO->isIncrementDecrementOp() || UO->getOpcode() == UO_AddrOf)
+            target = UO->getSubExpr();
+    } else if (CXXOperatorCallExpr *OC = dyn_cast<CXXOperatorCallExpr>(s)) {
+        if (OC->getNumArgs() > 0 &&
+            (OC->isAssignmentOp() || OC->getOperator() == OO_PlusPlus ||
+             OC->getOperator() == OO_MinusMinus))
+            target = OC->getArg(0);
+    } else if (CallExpr *CE = dyn_cast<CallExpr>(s)) {
+        // passed as a non-const reference
+        FunctionDecl *FD = CE->getDirectCallee();
+        for (int i = 0; FD && i < CE->getNumArgs() && i < FD->getNumParams(); i++) {
+            QualType pt = FD->getParamDecl(i)->getType();
+            DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(CE->getArg(i)->IgnoreParenImpCasts());
+            if (DRE && DRE->getDecl() == var && pt->isReferenceType() &&
+                !pt->getPointeeType().isConstQualified())
+                return true;
+        }
+    } else if (DeclStmt *DS = dyn_cast<DeclStmt>(s)) {
+        // non-const reference to the variable
+        for (Decl *D : DS->decls()) {
+            VarDecl *vd = dyn_cast<VarDecl>(D);
+            if (vd && vd->getType()->isReferenceType() &&
+                !vd->getType()->getPointeeType().isConstQualified() && vd->getInit() &&
+                refers_to_var(vd->getInit(), var))
+                return true;
+        }
+    }
+
+    if (target) {
+        DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(target->IgnoreParenImpCasts());
+        if (DRE && DRE->getDecl() == var)
+            return true;
+    }
+
+    for (Stmt *c : s->children())
+        if (is_direction_var_modified(c, var))
+            return true;
+
+    return false;
+}
+
+/// Print the expression for evaluation before the loop, with the direction variable
+/// replaced by _HILAdir_.  Returns false if the expression contains something else
+/// which is not loop constant, or constructs not handled here.
+
+bool TopLevelVisitor::print_direction_expr(Expr *e, VarDecl *var, std::string &out) {
+
+    e = e->IgnoreParenImpCasts();
+
+    if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(e)) {
+        if (DRE->getDecl() == var) {
+            out = "_HILAdir_";
+            return true;
+        }
+    }
+
+    // loop constant subexpressions as such
+    if (!contains_loop_local_var(e)) {
+        int64_t value;
+        if (get_integer_constant(e, *Context, value)) {
+            if (is_direction_type(e->getType()))
+                out = "((Direction)" + std::to_string(value) + ")";
+            else
+                out = "(" + std::to_string(value) + ")";
+            return true;
+        }
+
+        // not through macros, the text may not be valid outside
+        if (e->getBeginLoc().isMacroID() || e->getEndLoc().isMacroID())
+            return false;
+
+        std::vector<var_info *> deps;
+        if (is_site_dependent(e, &deps))
+            return false;
+        for (var_info *vi : deps)
+            if (vi->is_assigned || vi->reduction_type != reduction::NONE)
+                return false;
+
+        out = "(" + get_stmt_str(e) + ")";
+        return true;
+    }
+
+    std::string a, b;
+
+    if (BinaryOperator *BO = dyn_cast<BinaryOperator>(e)) {
+        if ((BO->isComparisonOp() || BO->isLogicalOp() || BO->isAdditiveOp()) &&
+            print_direction_expr(BO->getLHS(), var, a) &&
+            print_direction_expr(BO->getRHS(), var, b)) {
+            out = "(" + a + " " + BO->getOpcodeStr().str() + " " + b + ")";
+            return true;
+        }
+        return false;
+    }
+
+    if (UnaryOperator *UO = dyn_cast<UnaryOperator>(e)) {
+        UnaryOperatorKind op = UO->getOpcode();
+        if ((op == UO_LNot || op == UO_Minus || op == UO_Plus) &&
+            print_direction_expr(UO->getSubExpr(), var, a)) {
+            out = UnaryOperator::getOpcodeStr(op).str() + a;
+            return true;
+        }
+        return false;
+    }
+
+    if (CXXOperatorCallExpr *OC = dyn_cast<CXXOperatorCallExpr>(e)) {
+        static const std::vector<std::string> ops = {"==", "!=", "<", "<=", ">", ">=",
+                                                     "&&", "||", "!", "-",  "+"};
+        std::string op = getOperatorSpelling(OC->getOperator());
+        if (std::find(ops.begin(), ops.end(), op) == ops.end())
+            return false;
+
+        if (OC->getNumArgs() == 1 && print_direction_expr(OC->getArg(0), var, a)) {
+            out = op + "(" + a + ")";
+            return true;
+        }
+        if (OC->getNumArgs() == 2 && print_direction_expr(OC->getArg(0), var, a) &&
+            print_direction_expr(OC->getArg(1), var, b)) {
+            out = "(" + a + " " + op + " " + b + ")";
+            return true;
+        }
+        return false;
+    }
+
+    if (CallExpr *CE = dyn_cast<CallExpr>(e)) {
+        FunctionDecl *FD = CE->getDirectCallee();
+        if (FD && CE->getNumArgs() == 1) {
+            std::string name = FD->getNameAsString();
+            if ((name == "is_up_dir" || name == "opp_dir" || name == "abs") &&
+                print_direction_expr(CE->getArg(0), var, a)) {
+                out = name + "(" + a + ")";
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if (ExplicitCastExpr *EC = dyn_cast<ExplicitCastExpr>(e)) {
+        if (print_direction_expr(EC->getSubExpr(), var, a)) {
+            PrintingPolicy pp(Context->getLangOpts());
+            out = "((" + EC->getTypeAsWritten().getAsString(pp) + ")" + a + ")";
+            return true;
+        }
+        return false;
+    }
+
+    return false;
+}
+
+/// Set restrict_dirs and gather_dirs of the fields with loop local direction refs
+
+void TopLevelVisitor::analyze_loop_local_directions(Stmt *ls) {
+
+    // without -direction-analysis all directions are gathered
+    if (!cmdline::direction_analysis)
+        return;
+
+    bool has_local_dirs = false;
+    for (field_info &l : field_info_list)
+        if (l.is_loop_local_dir)
+            has_local_dirs = true;
+    if (!has_local_dirs)
+        return;
+
+    // directions given in #pragma hila directions(...), split at top level commas
+    std::vector<std::string> pragma_dirs;
+    if (loop_info.has_pragma_directions) {
+        std::string args = loop_info.pragma_directions_args;
+        std::string item;
+        int level = 0;
+        for (char c : args + ',') {
+            if (c == '(')
+                level++;
+            else if (c == ')')
+                level--;
+            if (c == ',' && level == 0) {
+                item = remove_extra_whitespace(item);
+                if (item.size() > 0)
+                    pragma_dirs.push_back(item);
+                item.clear();
+            } else {
+                item += c;
+            }
+        }
+    }
+
+    // guards at each loop local ref
+    std::map<Expr *, std::vector<direction_guard>> guards_at;
+    for (field_info &l : field_info_list)
+        if (l.is_loop_local_dir)
+            for (field_ref *p : l.ref_list)
+                if (p->is_loop_local_dir)
+                    guards_at[p->parityExpr] = {};
+
+    std::vector<direction_guard> guards;
+    collect_direction_guards(ls, guards, guards_at);
+
+    for (field_info &l : field_info_list) {
+        if (!l.is_loop_local_dir)
+            continue;
+
+        std::vector<std::pair<std::string, std::string>> dirs;
+
+        // directions which are not loop local are gathered as usual
+        for (dir_ptr &d : l.dir_list)
+            if (!d.is_loop_local_dir && d.count > 0)
+                dirs.push_back({"", d.direxpr_s});
+
+        bool ok = true;
+        if (loop_info.has_pragma_directions) {
+            for (std::string &s : pragma_dirs)
+                dirs.push_back({"", s});
+
+        } else {
+            for (field_ref *p : l.ref_list) {
+                if (!p->is_loop_local_dir)
+                    continue;
+
+                // direction must depend on one Direction variable which keeps its range
+                std::vector<var_info *> vars;
+                std::string dir;
+                ok = p->dirExpr != nullptr;
+                if (ok) {
+                    contains_loop_local_var(p->dirExpr, &vars);
+                    ok = (vars.size() == 1 && vars[0]->decl != nullptr &&
+                          is_direction_type(vars[0]->decl->getType()) &&
+                          !is_direction_var_modified(ls, vars[0]->decl) &&
+                          print_direction_expr(p->dirExpr, vars[0]->decl, dir));
+                }
+                if (!ok) {
+                    if (cmdline::verbosity >= 1)
+                        reportDiag(DiagnosticsEngine::Level::Remark,
+                                   p->fullExpr->getSourceRange().getBegin(),
+                                   "gathering all directions for '%0', use '#pragma hila "
+                                   "directions(...)' to restrict",
+                                   get_stmt_str(p->fullExpr).c_str());
+                    break;
+                }
+                VarDecl *var = vars[0]->decl;
+                if (p->is_dir_minus)
+                    dir = "-" + dir;
+
+                // the parts of the guards which can be evaluated before the loop
+                std::string cond;
+                for (direction_guard &g : guards_at[p->parityExpr]) {
+                    std::vector<Expr *> parts;
+                    if (g.second)
+                        parts.push_back(g.first);
+                    else
+                        split_conjunction(g.first, parts);
+
+                    for (Expr *c : parts) {
+                        std::string s;
+                        if (refers_to_var(c, var) && print_direction_expr(c, var, s)) {
+                            if (cond.size() > 0)
+                                cond += " && ";
+                            cond += (g.second ? "!" : "") + s;
+                        }
+                    }
+                }
+                if (cond.size() == 0)
+                    cond = "true";
+
+                if (std::find(dirs.begin(), dirs.end(), std::make_pair(cond, dir)) == dirs.end())
+                    dirs.push_back({cond, dir});
+            }
+        }
+
+        if (ok) {
+            l.restrict_dirs = true;
+            l.gather_dirs = dirs;
+        }
+    }
+}
@@ -145,6 +145,9 @@ class GeneralVisitor {
     /// check if stmt contains random number generator
     bool contains_random(Stmt *s);
 
+    /// check if stmt contains rng calls which cannot be vectorized
+    bool contains_vector_unsafe_random(Stmt *s);
+
     /// similarly if contains #pragma hila novector -functions, recursively
     bool contains_novector(Stmt *s);
 
@@ -85,6 +85,11 @@ llvm::cl::opt<bool> cmdline::no_interleaved_comm(
     "no-interleave", llvm::cl::desc("Do not interleave communications with computation"),
     llvm::cl::cat(HilappCategory));
 
+llvm::cl::opt<bool> cmdline::loop_profile(
+    "loop-profile",
+    llvm::cl::desc("Instrument site loops: count, time, gather wait and bytes touched per loop"),
+    llvm::cl::cat(HilappCategory));
+
 llvm::cl::opt<bool> cmdline::check_initialization(
     "check-init",
     llvm::cl::desc("Insert checks that Field variables are appropriately initialized before use"),
@@ -122,8 +127,11 @@ llvm::cl::opt<bool> cmdline::openacc("target:openacc",
                                      llvm::cl::desc("Offload to GPU using openACC"),
                                      llvm::cl::cat(HilappCategory));
 
-llvm::cl::opt<bool> cmdline::c_openmp("target:openmp", llvm::cl::desc("Hybrid OpenMP - MPI"),
-                                      llvm::cl::cat(HilappCategory));
+llvm::cl::opt<bool> cmdline::c_openmp(
+    "target:openmp",
+    llvm::cl::desc("Hybrid OpenMP - MPI.  Can be combined with -target:AVX, e.g.\n"
+                   "-target:AVX -target:openmp gives vectorized loops split to threads"),
+    llvm::cl::cat(HilappCategory));
 
 
 // Debug and Utility arguments
@@ -137,6 +145,30 @@ llvm::cl::opt<bool>
                              llvm::cl::desc("Use slow (but memory economical) reduction on gpus"),
                              llvm::cl::cat(HilappCategory));
 
+llvm::cl::opt<bool>
+    cmdline::loop_fusion("loop-fusion",
+                         llvm::cl::desc("Fuse consecutive compatible site loops (changes the "
+                                        "order of random number calls)"),
+                         llvm::cl::cat(HilappCategory));
+
+llvm::cl::opt<bool>
+    cmdline::fusion_report("fusion-report",
+                           llvm::cl::desc("Report fused site loops and why adjacent loops "
+                                          "were not fused"),
+                           llvm::cl::cat(HilappCategory));
+
+llvm::cl::opt<bool> cmdline::direction_analysis(
+    "direction-analysis",
+    llvm::cl::desc("Gather only the reachable directions for loop local direction refs, "
+                   "also enables '#pragma hila directions(..)'"),
+    llvm::cl::cat(HilappCategory));
+
+llvm::cl::opt<bool> cmdline::split_site_loops(
+    "split-site-loops",
+    llvm::cl::desc("Loops waiting for gathers run the interior sites from contiguous blocks "
+                   "and the boundary sites from a list (cpu targets)"),
+    llvm::cl::cat(HilappCategory));
+
 llvm::cl::opt<int> cmdline::verbosity("verbosity",
                                       llvm::cl::desc("Verbosity level 0-2.  Default 0 (quiet)"),
                                       llvm::cl::cat(HilappCategory));
@@ -191,7 +223,15 @@ void handle_cmdline_arguments(codetype &target) {
     } else if (cmdline::vectorize) {
         target.vectorize = true;
         target.vector_size = cmdline::vectorize;
-    } else if (cmdline::c_openmp) {
+    }
+
+    // OpenMP can be used alone or together with the vectorized targets
+    if (cmdline::c_openmp) {
+        if (target.cuda || target.hip || target.openacc) {
+            llvm::errs() << "hilapp commandline error: option '-target:openmp' can be combined "
+                            "only with vectorized targets (AVX, AVX512, vectorize)\n";
+            exit(1);
+        }
         target.openmp = true;
     }
 
@@ -244,7 +284,8 @@ struct pragma_types {
 static std::vector<pragma_types> pragma_hila_types{
     {"skip", false},         {"ast_dump", false},        {"loop_function", false},
     {"novector", false},     {"nonvectorizable", false}, {"contains_rng", false},
-    {"direct_access", true}, {"safe_access", true},      {"omp_parallel_region", false}};
+    {"direct_access", true}, {"safe_access", true},      {"omp_parallel_region", false},
+    {"directions", true},    {"nofuse", false}};
 
 void check_pragmas(std::string &arg, SourceLocation prloc, SourceLocation refloc,
                    std::vector<pragma_loc_struct> &pragmas) {
@@ -66,6 +66,7 @@ extern llvm::cl::opt<bool> funcinfo;
 extern llvm::cl::opt<bool> no_output;
 extern llvm::cl::opt<bool> syntax_only;
 extern llvm::cl::opt<bool> check_initialization;
+extern llvm::cl::opt<bool> loop_profile;
 extern llvm::cl::opt<std::string> output_filename;
 extern llvm::cl::opt<bool> vanilla;
 extern llvm::cl::opt<bool> CUDA;
@@ -84,6 +85,10 @@ extern llvm::cl::opt<int> avx_info;
 extern llvm::cl::opt<bool> comment_pragmas;
 extern llvm::cl::opt<bool> insert_includes;
 extern llvm::cl::opt<bool> slow_gpu_reduce;
+extern llvm::cl::opt<bool> loop_fusion;
+extern llvm::cl::opt<bool> fusion_report;
+extern llvm::cl::opt<bool> direction_analysis;
+extern llvm::cl::opt<bool> split_site_loops;
 
 extern llvm::cl::opt<bool> allow_func_globals;
 
@@ -140,9 +145,12 @@ struct field_ref {
     bool is_offset;             // true if dir is for offset instead of simple Direction
     bool is_loop_local_dir;     // if dir depends on loop local var - not known outside loop
     unsigned constant_value;
+    Expr *dirExpr;              // non-constant nn direction: "d" in X+d or X-d
+    bool is_dir_minus;          // X-d
 
     field_ref() {
-        fullExpr = nameExpr = parityExpr = nullptr;
+        fullExpr = nameExpr = parityExpr = dirExpr = nullptr;
+        is_dir_minus = false;
         direxpr_s.clear();
         info = nullptr;
         is_written = is_read = is_offset = is_direction = is_constant_direction =
@@ -254,9 +262,17 @@ struct field_info {
     bool is_loop_local_dir; // is read with loop local direction?
     int first_assign_seq;   // the sequence of the first assignment
 
+    // Directions to gather with loop local direction refs, set by
+    // analyze_loop_local_directions().  If restrict_dirs is false gather all.
+    // Pairs (condition, direction): direction is gathered if condition holds
+    // for some value of _HILAdir_; empty condition is an unconditional direction.
+    bool restrict_dirs;
+    std::vector<std::pair<std::string, std::string>> gather_dirs;
+
     field_info() {
         type_template = old_name = new_name = loop_ref_name = "";
         is_written = is_read_nb = is_read_atX = is_read_offset = is_loop_local_dir = false;
+        restrict_dirs = false;
         first_assign_seq = 0;
         dir_list = {};
         ref_list = {};
@@ -403,8 +419,10 @@ struct loop_info_struct {
     bool has_pragma_access;
     bool has_pragma_safe;
     bool has_pragma_omp_parallel_region;
+    bool has_pragma_directions;
     const char *pragma_access_args;
     const char *pragma_safe_args;
+    const char *pragma_directions_args;
     bool has_site_dependent_cond_or_index;    // if, for, while w. site dep. cond?
     bool contains_random;                     // does it contain rng (also in loop functions)?
     bool has_conditional;                     // if, for, while, switch, ternary in loop
@@ -514,7 +532,9 @@ enum class pragma_hila {
     CONTAINS_RNG,
     ACCESS,
     SAFE,
-    IN_OMP_PARALLEL_REGION
+    IN_OMP_PARALLEL_REGION,
+    DIRECTIONS,
+    NOFUSE
 };
 
 /// Pragma handling things
@@ -758,6 +758,25 @@ bool TopLevelVisitor::handle_special_loop_function(CallExpr *Call) {
             special_function_call_list.push_back(sfc);
             return true;
         }
+
+        if (target.vectorize &&
+            Call->getDirectCallee()->getQualifiedNameAsString() == "hila::gaussrand" &&
+            Call->getNumArgs() == 0) {
+
+            // hila::gaussrand() - in vectorized loops this is replaced by vector version,
+            // see codegen_avx_new.cpp
+            special_function_call sfc;
+            sfc.fullExpr = Call;
+            sfc.argsExpr = nullptr;
+            sfc.scope = parsing_state.scope_level;
+            sfc.name = name;
+            sfc.replace_expression = "hila::gaussrand()";
+            sfc.replace_range = Call->getSourceRange();
+            sfc.add_loop_var = false;
+            special_function_call_list.push_back(sfc);
+            loop_info.contains_random = true;
+            return true;
+        }
     }
     return false;
 }
@@ -0,0 +1,425 @@
+#include <sstream>
+#include <iostream>
+#include <string>
+#include <set>
+
+#include "toplevelvisitor.h"
+#include "hilapp.h"
+#include "stringops.h"
+
+//////////////////////////////////////////////////////////////////////////////
+/// Fusion of consecutive site loops.
+///
+/// Back-to-back loops like
+///
+///     onsites(ALL) r[X] -= alpha * Dp[X];
+///     onsites(ALL) rr += r[X].squarenorm();
+///
+/// are generated as one loop over the sites, with the gathers and reductions of
+/// both loops, saving a sweep through memory.  Loops are fused if
+///   - they are consecutive statements of the same block, with only whitespace
+///     and comments between
+///   - the parity arguments are textually the same
+///   - neither has loop pragmas ('#pragma hila nofuse' is for preventing fusion)
+///   - a field written in one loop is not read from a neighbour site (X+dir or
+///     X+offset) in the other.  Fields which may be the same object (references,
+///     pointers or class members of the same type) are taken to be the same field
+///   - a variable defined outside the loops and assigned in one (e.g. a reduction
+///     variable) is not used in the other
+///   - the first loop does not 'continue' the site loop
+/// Fusion is off by default, option -loop-fusion switches it on.  Option
+/// -fusion-report reports the fused loops and why adjacent loops were not fused.
+///
+/// Fused loops make the random number calls of the loops site by site, interleaved,
+/// instead of the first loop over all sites and then the second.  Runs with random
+/// numbers in fused loops are not bit-reproducible against unfused code.
+//////////////////////////////////////////////////////////////////////////////
+
+/// Field[X] or Field[X+dir] reference
+struct fusion_field_ref {
+    Expr *fullExpr;
+    ValueDecl *root;     // variable or class member where the field is found
+    QualType type;       // type of the field
+    bool is_local;       // root is an automatic non-reference variable, not via a pointer
+    bool is_distinct;    // root is a non-reference variable, not via a pointer
+    bool is_parm_or_member;
+    bool is_written;
+    bool is_nb;
+};
+
+/// What a sequence of loop bodies reads and writes
+struct loop_access_summary {
+    std::vector<fusion_field_ref> fields;
+    std::set<ValueDecl *> vars_referenced;
+    std::set<ValueDecl *> vars_assigned;
+    std::set<ValueDecl *> local_vars;
+};
+
+/// Find the variable or member where the field expression of Field[X] is found
+static void find_field_root(Expr *e, fusion_field_ref &ref) {
+    ref.root = nullptr;
+    ref.is_distinct = true;
+    ref.is_parm_or_member = false;
+    while (e != nullptr) {
+        e = e->IgnoreImplicit()->IgnoreParens();
+        if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(e)) {
+            ref.root = DRE->getDecl();
+            if (!isa<VarDecl>(ref.root) || ref.root->getType()->isReferenceType())
+                ref.is_distinct = false;
+            ref.is_parm_or_member = isa<ParmVarDecl>(ref.root);
+            break;
+        } else if (MemberExpr *ME = dyn_cast<MemberExpr>(e)) {
+            if (ME->isArrow() || ME->getMemberDecl()->getType()->isReferenceType())
+                ref.is_distinct = false;
+            if (isa<CXXThisExpr>(ME->getBase()->IgnoreImplicit()->IgnoreParens())) {
+                ref.root = ME->getMemberDecl();
+                ref.is_distinct = false;
+                ref.is_parm_or_member = true;
+                break;
+            }
+            e = ME->getBase();
+        } else if (ArraySubscriptExpr *ASE = dyn_cast<ArraySubscriptExpr>(e)) {
+            if (!ASE->getBase()->IgnoreImpCasts()->getType()->isArrayType())
+                ref.is_distinct = false;
+            e = ASE->getBase();
+        } else if (CXXOperatorCallExpr *OC = dyn_cast<CXXOperatorCallExpr>(e)) {
+            // e.g. GaugeField U[d], or a std::array/vector of fields
+            if (OC->getNumArgs() == 0)
+                break;
+            e = OC->getArg(0);
+        } else if (UnaryOperator *UO = dyn_cast<UnaryOperator>(e)) {
+            ref.is_distinct = false;
+            e = UO->getSubExpr();
+        } else {
+            break;
+        }
+    }
+    if (ref.root == nullptr)
+        ref.is_distinct = false;
+
+    VarDecl *vd = ref.is_distinct ? dyn_cast<VarDecl>(ref.root) : nullptr;
+    ref.is_local = (vd != nullptr && vd->hasLocalStorage());
+}
+
+/// Can the fields be the same object
+static bool may_alias(const fusion_field_ref &a, const fusion_field_ref &b) {
+    if (a.root != nullptr && a.root == b.root)
+        return true;
+    if (a.type != b.type)
+        return false;
+    if (a.is_distinct && b.is_distinct)
+        return false;
+    // automatic variables of the function cannot be referred to by its
+    // parameters or class members
+    if ((a.is_local && b.is_parm_or_member) || (b.is_local && a.is_parm_or_member))
+        return false;
+    return true;
+}
+
+/// Does the loop body contain 'continue' of the site loop (not of a loop inside it)
+static bool continues_site_loop(Stmt *s) {
+    if (s == nullptr)
+        return false;
+    if (isa<ContinueStmt>(s))
+        return true;
+    if (isa<ForStmt>(s) || isa<WhileStmt>(s) || isa<DoStmt>(s) || isa<CXXForRangeStmt>(s))
+        return false;
+    for (Stmt *c : s->children())
+        if (continues_site_loop(c))
+            return true;
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// Visitor collecting the field and variable accesses of a loop body.
+/// Writes are recognized conservatively: assignments, increments, non-const
+/// method calls, non-const reference or pointer arguments and address-of
+//////////////////////////////////////////////////////////////////////////////
+
+class loopAccessScanner : public GeneralVisitor, public RecursiveASTVisitor<loopAccessScanner> {
+
+  public:
+    loop_access_summary &acc;
+    std::set<Expr *> written;
+
+    template <typename visitor_type>
+    loopAccessScanner(visitor_type &v, loop_access_summary &a) : GeneralVisitor(v), acc(a) {}
+
+    /// The Field[X] -expression, variable or class member modified through e
+    Expr *access_root(Expr *e) {
+        while (e != nullptr) {
+            e = e->IgnoreImplicit()->IgnoreParens();
+            if (is_field_with_X_expr(e) || is_field_with_X_and_dir(e) || isa<DeclRefExpr>(e))
+                return e;
+            if (MemberExpr *ME = dyn_cast<MemberExpr>(e)) {
+                if (isa<CXXThisExpr>(ME->getBase()->IgnoreImplicit()->IgnoreParens()))
+                    return e;
+                e = ME->getBase();
+            } else if (ArraySubscriptExpr *ASE = dyn_cast<ArraySubscriptExpr>(e)) {
+                e = ASE->getBase();
+            } else if (CXXMemberCallExpr *MCE = dyn_cast<CXXMemberCallExpr>(e)) {
+                e = MCE->getImplicitObjectArgument();
+            } else if (CXXOperatorCallExpr *OC = dyn_cast<CXXOperatorCallExpr>(e)) {
+                if (OC->getNumArgs() == 0)
+                    return nullptr;
+                e = OC->getArg(0);
+            } else if (UnaryOperator *UO = dyn_cast<UnaryOperator>(e)) {
+                e = UO->getSubExpr();
+            } else {
+                return nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    void mark_written(Expr *e) {
+        Expr *r = access_root(e);
+        if (r == nullptr)
+            return;
+        written.insert(r);
+        if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(r))
+            acc.vars_assigned.insert(DRE->getDecl());
+        else if (MemberExpr *ME = dyn_cast<MemberExpr>(r))
+            acc.vars_assigned.insert(ME->getMemberDecl());
+    }
+
+    bool VisitVarDecl(VarDecl *V) {
+        acc.local_vars.insert(V);
+        return true;
+    }
+
+    bool VisitStmt(Stmt *s) {
+        bool iscompound;
+        Expr *assignee = nullptr;
+        if (is_assignment_expr(s, nullptr, iscompound, &assignee) ||
+            is_increment_expr(s, &assignee)) {
+            mark_written(assignee);
+        }
+
+        if (CXXMemberCallExpr *MCE = dyn_cast<CXXMemberCallExpr>(s)) {
+            CXXMethodDecl *MD = MCE->getMethodDecl();
+            if (MD && !MD->isConst() && !MD->isStatic())
+                mark_written(MCE->getImplicitObjectArgument());
+        }
+
+        if (CallExpr *CE = dyn_cast<CallExpr>(s)) {
+            FunctionDecl *FD = CE->getDirectCallee();
+            if (FD != nullptr) {
+                unsigned first = 0;
+                CXXOperatorCallExpr *OC = dyn_cast<CXXOperatorCallExpr>(s);
+                if (OC && isa<CXXMethodDecl>(FD)) {
+                    // member operator, object is the 1st arg.  Field[X] itself is not a write
+                    first = 1;
+                    if (!cast<CXXMethodDecl>(FD)->isConst() && !is_field_with_X_expr(OC) &&
+                        !is_field_with_X_and_dir(OC))
+                        mark_written(OC->getArg(0));
+                }
+                for (unsigned i = first; i < CE->getNumArgs() && i - first < FD->getNumParams();
+                     i++) {
+                    QualType pt = FD->getParamDecl(i - first)->getType();
+                    if ((pt->isReferenceType() && !pt.getNonReferenceType().isConstQualified()) ||
+                        (pt->isPointerType() && !pt->getPointeeType().isConstQualified()))
+                        mark_written(CE->getArg(i));
+                }
+            }
+        }
+
+        if (UnaryOperator *UO = dyn_cast<UnaryOperator>(s)) {
+            if (UO->getOpcode() == UO_AddrOf)
+                mark_written(UO->getSubExpr());
+        }
+
+        if (CXXOperatorCallExpr *OC = dyn_cast<CXXOperatorCallExpr>(s)) {
+            bool is_nb = is_field_with_X_and_dir(OC);
+            if (is_nb || is_field_with_X_expr(OC)) {
+                fusion_field_ref ref;
+                ref.fullExpr = OC;
+                ref.type = OC->getArg(0)->getType().getCanonicalType().getUnqualifiedType();
+                ref.is_nb = is_nb;
+                ref.is_written = false;
+                find_field_root(OC->getArg(0), ref);
+                acc.fields.push_back(ref);
+            }
+        }
+
+        if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(s)) {
+            if (isa<VarDecl>(DRE->getDecl()))
+                acc.vars_referenced.insert(DRE->getDecl());
+        } else if (MemberExpr *ME = dyn_cast<MemberExpr>(s)) {
+            if (isa<CXXThisExpr>(ME->getBase()->IgnoreImplicit()->IgnoreParens()))
+                acc.vars_referenced.insert(ME->getMemberDecl());
+        }
+
+        return true;
+    }
+
+    void scan(Stmt *s) {
+        size_t first = acc.fields.size();
+        TraverseStmt(s);
+        for (size_t i = first; i < acc.fields.size(); i++)
+            acc.fields[i].is_written = (written.count(acc.fields[i].fullExpr) > 0);
+    }
+};
+
+/// Check if the loop body b can be fused after the loops summarized in a.
+/// Returns an empty string if it can, otherwise the reason
+static std::string fusion_hazard(GeneralVisitor &v, const loop_access_summary &a,
+                                 const loop_access_summary &b) {
+
+    for (const fusion_field_ref &fa : a.fields) {
+        for (const fusion_field_ref &fb : b.fields) {
+            if (((fa.is_written && fb.is_nb) || (fb.is_written && fa.is_nb)) &&
+                may_alias(fa, fb)) {
+                const fusion_field_ref &w = fa.is_written ? fa : fb;
+                return "field '" + v.get_stmt_str(w.fullExpr) +
+                       "' is written in one loop and read from a neighbour site in the other";
+            }
+        }
+    }
+
+    for (auto *d : a.vars_assigned) {
+        if (a.local_vars.count(d) == 0 && b.vars_referenced.count(d) > 0)
+            return "variable '" + d->getNameAsString() +
+                   "' is assigned in the first loop and used in the next";
+    }
+    for (auto *d : b.vars_assigned) {
+        if (b.local_vars.count(d) == 0 && a.vars_referenced.count(d) > 0)
+            return "variable '" + d->getNameAsString() +
+                   "' is assigned in the next loop and used in the first";
+    }
+
+    return "";
+}
+
+/// Does the loop have any of the loop pragmas
+bool TopLevelVisitor::has_loop_pragmas(Stmt *s, std::string &pragma_name) {
+    if (has_pragma(s, pragma_hila::NOFUSE))
+        pragma_name = "nofuse";
+    else if (has_pragma(s, pragma_hila::NOVECTOR))
+        pragma_name = "novector";
+    else if (has_pragma(s, pragma_hila::ACCESS))
+        pragma_name = "direct_access";
+    else if (has_pragma(s, pragma_hila::SAFE))
+        pragma_name = "safe_access";
+    else if (has_pragma(s, pragma_hila::IN_OMP_PARALLEL_REGION))
+        pragma_name = "omp_parallel_region";
+    else if (has_pragma(s, pragma_hila::DIRECTIONS))
+        pragma_name = "directions";
+    else
+        return false;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// Go through the statements of a block and find the chains of fusable site
+/// loops.  The chains are stored in fusion_chains, indexed by the first loop,
+/// and the rest are marked in fused_loops
+//////////////////////////////////////////////////////////////////////////////
+
+void TopLevelVisitor::find_fusable_loops(CompoundStmt *CS) {
+
+    // the same block may be traversed again
+    if (!cmdline::loop_fusion || !fusion_checked_blocks.insert(CS).second)
+        return;
+
+    SourceManager &SM = TheRewriter.getSourceMgr();
+
+    ForStmt *first = nullptr, *prev = nullptr;
+    std::string parity;
+    loop_access_summary acc;
+
+    for (Stmt *st : CS->body()) {
+
+        // stray ; after a loop block
+        if (isa<NullStmt>(st))
+            continue;
+
+        if (!is_onsites(st)) {
+            first = prev = nullptr;
+            continue;
+        }
+
+        ForStmt *f = cast<ForStmt>(st);
+        std::string reason, pragma_name;
+
+        if (prev != nullptr) {
+            SourceLocation prev_end = get_real_range(prev->getBody()->getSourceRange()).getEnd();
+            SourceLocation this_begin = get_real_range(f->getSourceRange()).getBegin();
+
+            loop_access_summary next;
+            loopAccessScanner scanner(*this, next);
+
+            if (has_loop_pragmas(prev, pragma_name) || has_loop_pragmas(f, pragma_name)) {
+                reason = "loop has '#pragma hila " + pragma_name + "'";
+            } else if (onsites_parity_text(f) != parity) {
+                reason = "parity differs";
+            } else if (getRangeText(SM, prev_end, this_begin).find('#') != std::string::npos) {
+                reason = "preprocessor directive between the loops";
+            } else if (continues_site_loop(prev->getBody())) {
+                reason = "the first loop contains 'continue'";
+            } else {
+                scanner.scan(f->getBody());
+                reason = fusion_hazard(*this, acc, next);
+            }
+
+            if (reason.empty()) {
+                fusion_chains[first].push_back(f);
+                fused_loops.insert(f);
+
+                acc.fields.insert(acc.fields.end(), next.fields.begin(), next.fields.end());
+                acc.vars_referenced.insert(next.vars_referenced.begin(),
+                                           next.vars_referenced.end());
+                acc.vars_assigned.insert(next.vars_assigned.begin(), next.vars_assigned.end());
+                acc.local_vars.insert(next.local_vars.begin(), next.local_vars.end());
+                prev = f;
+
+                if (cmdline::fusion_report)
+                    reportDiag(DiagnosticsEngine::Level::Remark, f->getSourceRange().getBegin(),
+                               "site loop fused with the preceding loop");
+                continue;
+            }
+
+            if (cmdline::fusion_report)
+                reportDiag(DiagnosticsEngine::Level::Remark, f->getSourceRange().getBegin(),
+                           "site loop not fused with the preceding loop: %0", reason.c_str());
+        }
+
+        // start a new chain from this loop
+        first = prev = f;
+        parity = onsites_parity_text(f);
+        acc = loop_access_summary();
+        loopAccessScanner scanner(*this, acc);
+        scanner.scan(f->getBody());
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// Combine the bodies of the site loop f and the loops fused to it into one
+/// block, to be analyzed and generated as the body of f.  The onsites() -texts
+/// of the fused loops are removed, the bodies stay in place in the source.
+//////////////////////////////////////////////////////////////////////////////
+
+Stmt *TopLevelVisitor::fuse_loop_bodies(ForStmt *f, const std::vector<ForStmt *> &chain) {
+
+    std::vector<Stmt *> bodies = {f->getBody()};
+
+    for (ForStmt *g : chain) {
+        CharSourceRange CSR =
+            TheRewriter.getSourceMgr().getImmediateExpansionRange(g->getSourceRange().getBegin());
+        std::string macro = TheRewriter.getRewrittenText(CSR.getAsRange());
+
+        global.full_loop_text += "\n" + macro + " " + get_stmt_str(g->getBody());
+        writeBuf->remove(CSR);
+
+        bodies.push_back(g->getBody());
+    }
+
+    SourceLocation lb = get_real_range(f->getBody()->getSourceRange()).getBegin();
+    SourceLocation rb = get_real_range(chain.back()->getBody()->getSourceRange()).getEnd();
+
+#if defined(__clang_major__) && (__clang_major__ <= 14)
+    return CompoundStmt::Create(*Context, bodies, lb, rb);
+#else
+    return CompoundStmt::Create(*Context, bodies, FPOptionsOverride(), lb, rb);
+#endif
+}
@@ -292,6 +292,9 @@ bool TopLevelVisitor::handle_field_X_expr(Expr *e, bool &is_assign, bool is_also
                 //   handle_var_ref(DRE, false, assignop);
                 // }
 
+                lfe.dirExpr = dirE;
+                lfe.is_dir_minus = (strcmp(getOperatorSpelling(Op->getOperator()), "-") == 0);
+
                 // traverse the dir-expression to find var-references etc.
                 is_assign = false;
                 TraverseStmt(lfe.parityExpr);
@@ -1021,6 +1024,7 @@ bool TopLevelVisitor::handle_full_loop_stmt(Stmt *ls, bool field_parity_ok) {
     check_var_info_list();
     check_addrofops_and_refs(ls); // scan through the full loop again
     check_field_ref_list();
+    analyze_loop_local_directions(ls);
     process_loop_functions(); // revisit functions when vars are fully resolved
 
     if (!loop_info.contains_random)
@@ -1931,6 +1935,15 @@ bool TopLevelVisitor::is_onsites(Stmt *s) {
     return false;
 }
 
+/// Parity argument of onsites(par) as text, without whitespace
+
+std::string TopLevelVisitor::onsites_parity_text(ForStmt *f) {
+    CharSourceRange CSR =
+        TheRewriter.getSourceMgr().getImmediateExpansionRange(f->getSourceRange().getBegin());
+    std::string macro = TheRewriter.getRewrittenText(CSR.getAsRange());
+    return remove_all_whitespace(macro.substr(site_loop_name.length(), std::string::npos));
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 /// VisitStmt is called for each statement in AST.  Thus, when traversing the
@@ -1953,6 +1966,12 @@ bool TopLevelVisitor::VisitStmt(Stmt *s) {
     // Defined as a macro, needs special macro handling
     if (is_onsites(s)) {
 
+        // loops fused to the preceding site loop were handled with it
+        if (fused_loops.count(s) > 0) {
+            parsing_state.skip_children = 1;
+            return true;
+        }
+
         ForStmt *f = cast<ForStmt>(s);
         SourceLocation startloc = f->getSourceRange().getBegin();
 
@@ -1968,6 +1987,8 @@ bool TopLevelVisitor::VisitStmt(Stmt *s) {
         loop_info.has_pragma_omp_parallel_region =
             has_pragma(s, pragma_hila::IN_OMP_PARALLEL_REGION);
         loop_info.has_pragma_safe = has_pragma(s, pragma_hila::SAFE, &loop_info.pragma_safe_args);
+        loop_info.has_pragma_directions =
+            has_pragma(s, pragma_hila::DIRECTIONS, &loop_info.pragma_directions_args);
 
         DeclStmt *init = dyn_cast<DeclStmt>(f->getInit());
         if (init && init->isSingleDecl()) {
@@ -1987,7 +2008,11 @@ bool TopLevelVisitor::VisitStmt(Stmt *s) {
                     // TheRewriter.RemoveText(CSR);
                     writeBuf->remove(CSR);
 
-                    handle_full_loop_stmt(f->getBody(), false);
+                    auto chain = fusion_chains.find(s);
+                    if (chain != fusion_chains.end())
+                        handle_full_loop_stmt(fuse_loop_bodies(f, chain->second), false);
+                    else
+                        handle_full_loop_stmt(f->getBody(), false);
                     internal_error = false;
                 }
             }
@@ -2022,6 +2047,7 @@ bool TopLevelVisitor::VisitStmt(Stmt *s) {
         loop_info.has_pragma_access =
             has_pragma(s, pragma_hila::ACCESS, &loop_info.pragma_access_args);
         loop_info.has_pragma_safe = has_pragma(s, pragma_hila::SAFE, &loop_info.pragma_safe_args);
+        loop_info.has_pragma_directions = false;
 
         SourceRange full_range = getRangeWithSemicolon(s, false);
         global.full_loop_text = TheRewriter.getRewrittenText(full_range);
@@ -2031,9 +2057,13 @@ bool TopLevelVisitor::VisitStmt(Stmt *s) {
     }
 
     // And, for correct level for pragma handling - turns to 0 for stmts inside
-    if (isa<CompoundStmt>(s))
+    if (isa<CompoundStmt>(s)) {
         parsing_state.ast_depth = -1;
 
+        // site loops in this block which can be fused
+        find_fusable_loops(cast<CompoundStmt>(s));
+    }
+
     // new stuff: if there is field[coordinate], modify these to appropriate
     // functions
 
@@ -2,6 +2,8 @@
 #define TOPLEVELVISITOR_H
 
 #include <string>
+#include <map>
+#include <set>
 #include "clang/AST/AST.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/RecursiveASTVisitor.h"
@@ -29,6 +31,9 @@
 class TopLevelVisitor;
 extern TopLevelVisitor *g_TopLevelVisitor;
 
+/// condition guarding a statement in a site loop, and whether it is negated
+using direction_guard = std::pair<Expr *, bool>;
+
 class TopLevelVisitor : public GeneralVisitor, public RecursiveASTVisitor<TopLevelVisitor> {
 
   private:
@@ -48,6 +53,11 @@ class TopLevelVisitor : public GeneralVisitor, public RecursiveASTVisitor<TopLev
         bool loop_function_next;
     } parsing_state;
 
+    // site loops fused with the following loops, and the loops fused to a preceding one
+    std::map<Stmt *, std::vector<ForStmt *>> fusion_chains;
+    std::set<Stmt *> fused_loops;
+    std::set<Stmt *> fusion_checked_blocks;
+
   public:
     TopLevelVisitor(Rewriter &R, ASTContext *C) : GeneralVisitor(R, C) {
         is_top_level = true;
@@ -132,6 +142,14 @@ class TopLevelVisitor : public GeneralVisitor, public RecursiveASTVisitor<TopLev
 
     bool check_field_ref_list();
 
+    /// Value range analysis of loop local directions in Field[X+dir],
+    /// see direction_range_analysis.cpp
+    void analyze_loop_local_directions(Stmt *ls);
+    void collect_direction_guards(Stmt *s, std::vector<direction_guard> &guards,
+                                  std::map<Expr *, std::vector<direction_guard>> &found);
+    bool print_direction_expr(Expr *e, VarDecl *var, std::string &out);
+    bool is_direction_var_modified(Stmt *s, VarDecl *var);
+
     void check_var_info_list();
 
     bool handle_field_X_expr(Expr *e, bool &is_assign, bool is_compound, bool is_X,
@@ -147,6 +165,12 @@ class TopLevelVisitor : public GeneralVisitor, public RecursiveASTVisitor<TopLev
 
     bool is_onsites(Stmt *s);
 
+    /// Fusion of consecutive site loops, see loop_fusion.cpp
+    void find_fusable_loops(CompoundStmt *CS);
+    std::string onsites_parity_text(ForStmt *f);
+    bool has_loop_pragmas(Stmt *s, std::string &pragma_name);
+    Stmt *fuse_loop_bodies(ForStmt *f, const std::vector<ForStmt *> &chain);
+
     bool handle_vector_reference(Stmt *s, bool &is_assign, std::string &assignop, Stmt *assingstmt);
 
     bool is_select_stmt(Stmt *s, Expr **value_expr);
@@ -214,12 +238,16 @@ class TopLevelVisitor : public GeneralVisitor, public RecursiveASTVisitor<TopLev
     std::string backend_generate_code(Stmt *S, bool semicolon_at_end, srcBuf &loopBuf,
                                       bool generate_wait);
 
-    bool check_loop_vectorizable(Stmt *S, int &vector_size, std::string &diag);
+    bool check_loop_vectorizable(Stmt *S, int &vector_size, std::string &vector_type,
+                                 std::string &diag);
 
     /// Generate a header for starting communication and marking fields changed
     std::string generate_code_cpu(Stmt *S, bool semicolon_at_end, srcBuf &sb, bool generate_wait);
     std::string generate_code_gpu(Stmt *S, bool semicolon_at_end, srcBuf &sb, bool generate_wait);
     void generate_openacc_loop_header(std::stringstream &code);
+    void generate_openmp_vector_reductions(std::stringstream &code, srcBuf &loopBuf);
+    void generate_openmp_loop_header(std::stringstream &code, bool vectorized);
+    std::string loop_local_dir_loop(const field_info &l);
     //   std::string generate_code_openacc(Stmt *S, bool semicolon_at_end, srcBuf &sb);
     std::string generate_code_avx(Stmt *S, bool semicolon_at_end, srcBuf &sb, bool generate_wait);
 
@@ -323,8 +323,8 @@ class Complex {
      * @return Complex<T>&
      */
     inline Complex<T> &random() out_only {
-        re = hila::random();
-        im = hila::random();
+        hila::random(re);
+        hila::random(im);
         return *this;
     }
 
@@ -336,7 +336,7 @@ class Complex {
      * @return Complex<T>&
      */
     inline Complex<T> &gaussian_random(double width = 1.0) out_only {
-        double d;
+        T d;
         re = hila::gaussrand2(d) * width;
         im = d * width;
         return *this;
@@ -1325,13 +1325,13 @@ class Matrix_t {
             // now not complex matrix
             // if n*m even, max i in loop below is n*m-2.
             // if n*m odd, max i is n*m-3
-            double gr;
+            T gr;
             for (int i = 0; i < n * m - 1; i += 2) {
                 c[i] = hila::gaussrand2(gr) * width;
                 c[i + 1] = gr * width;
             }
             if constexpr ((n * m) % 2 > 0) {
-                c[n * m - 1] = hila::gaussrand() * width;
+                hila::gaussian_random(c[n * m - 1], width);
             }
         }
         return *this;
@@ -195,7 +195,7 @@ class SU2 {
 
     /// make random SU2
     inline SU2<T> &random(double width = 1.0) out_only {
-        double one, two;
+        T one, two;
         one = hila::gaussrand2(two);
         a = width*one;
         b = width*two;
@@ -207,7 +207,7 @@ class SU2 {
 
     /// make gaussian random matrix, does not normalize
     inline SU2<T> &gaussian_random(double width = 1.0) out_only {
-        double one, two;
+        T one, two;
         one = hila::gaussrand2(two);
         a = width*one;
         b = width*two;
@@ -561,7 +561,7 @@ class Algebra<SU2<T>> {
         one = hila::gaussrand2(two);
         a = width * one;
         b = width * two;
-        c = width * hila::gaussrand();
+        hila::gaussian_random(c, width);
         return *this;
     }
 };
@@ -0,0 +1,244 @@
+/**
+ * @file sun_compressed.h
+ * @brief Compressed storage of SU(3) matrices
+ * @details Gauge link loops (staples, plaquettes, Dirac hopping terms) are typically
+ * limited by the memory bandwidth of reading the links.  SU3_compressed stores
+ * only a part of the matrix in the field, and the full SU(3) matrix is rebuilt
+ * when the element is used.  Halo communications shrink by the same factor.
+ *
+ * - SU3_r12<T>: 2 first rows (12 reals), third row is (row0 x row1)^*
+ * - SU3_r8<T>:  8 real parameters, see SU3_compressed::expand()
+ *
+ * These can be used as the element type of GaugeField, e.g.
+ * \code{.cpp}
+ * GaugeField<SU<3, double>> U;
+ * ...
+ * GaugeField<SU3_r12<double>> Uc = U;
+ * \endcode
+ * Uc[d][X] expands to SU<3,T> in expressions, and assignment of SU<3,T> compresses.
+ */
+
+#ifndef SUN_COMPRESSED_H_
+#define SUN_COMPRESSED_H_
+
+#include "sun_matrix.h"
+
+/**
+ * @brief Compressed SU(3) matrix
+ *
+ * @details n_reals comes first, so that the vector backend vectorizes this like
+ * SU<3,T> (vectorize_struct matches C<int, T>).
+ *
+ * @tparam n_reals Number of stored reals, 12 or 8
+ * @tparam T Arithmetic type, float or double
+ */
+template <int n_reals, typename T>
+class SU3_compressed {
+    static_assert(hila::is_floating_point<T>::value,
+                  "SU3_compressed requires a floating point type");
+    static_assert(n_reals == 12 || n_reals == 8, "SU3_compressed stores 12 or 8 reals");
+
+  public: // public on purpose
+    T c[n_reals];
+
+  public:
+    using base_type = T;
+    using argument_type = T;
+
+    SU3_compressed() = default;
+    ~SU3_compressed() = default;
+    SU3_compressed(const SU3_compressed &) = default;
+
+    /// construct from SU(3) matrix
+    SU3_compressed(const SU<3, T> &m) {
+        compress(m);
+    }
+
+    /// construct from 'scalar', e.g. 1 (unit matrix)
+    template <typename B, std::enable_if_t<hila::is_assignable<T &, B>::value, int> = 0>
+    SU3_compressed(const B z) {
+        SU<3, T> m;
+        m = z;
+        compress(m);
+    }
+
+    inline SU3_compressed &operator=(const SU3_compressed &rhs) & = default;
+
+    inline SU3_compressed &operator=(const SU<3, T> &m) & {
+        compress(m);
+        return *this;
+    }
+
+    template <typename B, std::enable_if_t<hila::is_assignable<T &, B>::value, int> = 0>
+    inline SU3_compressed &operator=(const B z) & {
+        SU<3, T> m;
+        m = z;
+        compress(m);
+        return *this;
+    }
+
+    /// Group size, for compatibility with SU<3,T>::size()
+    static constexpr int size() {
+        return 3;
+    }
+
+    /**
+     * @brief Store the SU(3) matrix m
+     * @details reconstruct-12 stores rows 0 and 1.  reconstruct-8 stores m(0,1), m(0,2),
+     * m(1,0) and the phases of m(0,0) and m(2,0).
+     */
+    inline void compress(const SU<3, T> &m) out_only {
+        if constexpr (n_reals == 12) {
+            for (int i = 0; i < 3; i++) {
+                c[2 * i] = m.e(0, i).re;
+                c[2 * i + 1] = m.e(0, i).im;
+                c[6 + 2 * i] = m.e(1, i).re;
+                c[6 + 2 * i + 1] = m.e(1, i).im;
+            }
+        } else {
+            c[0] = m.e(0, 1).re;
+            c[1] = m.e(0, 1).im;
+            c[2] = m.e(0, 2).re;
+            c[3] = m.e(0, 2).im;
+            c[4] = m.e(1, 0).re;
+            c[5] = m.e(1, 0).im;
+            c[6] = m.e(0, 0).arg();
+            c[7] = m.e(2, 0).arg();
+        }
+    }
+
+    /**
+     * @brief Rebuild the full SU(3) matrix
+     * @details For reconstruct-8 the first row a and the first column (a0, b0, c0) are
+     * known up to |a0| and |c0|, which follow from unitarity.  The rest is
+     *
+     *     b1 = -(c0^* a2^* + a0^* a1 b0) / N      b2 =  (c0^* a1^* - a0^* a2 b0) / N
+     *     c1 =  (b0^* a2^* - a0^* a1 c0) / N      c2 = -(b0^* a1^* + a0^* a2 c0) / N
+     *
+     * where N = |a1|^2 + |a2|^2.  This is singular at N = 0, i.e. |a0| = 1; then
+     * the result is diag(a0, 1, a0^*), which is exact for the unit matrix (cold start).
+     * Thermalized configurations do not hit the singular set.
+     */
+    inline SU<3, T> expand() const {
+        SU<3, T> m;
+        if constexpr (n_reals == 12) {
+            for (int i = 0; i < 3; i++) {
+                m.e(0, i) = Complex<T>(c[2 * i], c[2 * i + 1]);
+                m.e(1, i) = Complex<T>(c[6 + 2 * i], c[6 + 2 * i + 1]);
+            }
+            m.e(2, 0) = (m.e(0, 1) * m.e(1, 2) - m.e(0, 2) * m.e(1, 1)).conj();
+            m.e(2, 1) = (m.e(0, 2) * m.e(1, 0) - m.e(0, 0) * m.e(1, 2)).conj();
+            m.e(2, 2) = (m.e(0, 0) * m.e(1, 1) - m.e(0, 1) * m.e(1, 0)).conj();
+        } else {
+            Complex<T> a1(c[0], c[1]), a2(c[2], c[3]), b0(c[4], c[5]);
+            T n = a1.squarenorm() + a2.squarenorm();
+            // abs() guards against rounding below 0
+            T a0abs = sqrt(abs(1 - n));
+            T c0abs = sqrt(abs(n - b0.squarenorm()));
+            Complex<T> a0(a0abs * cos(c[6]), a0abs * sin(c[6]));
+            Complex<T> c0(c0abs * cos(c[7]), c0abs * sin(c[7]));
+
+            // avoid branching: s = 1 when n >> tiny, 0 at n = 0
+            const T tiny = 1e-30;
+            T inv_n = 1 / (n + tiny);
+            T s = n * inv_n;
+
+            m.e(0, 0) = a0;
+            m.e(0, 1) = a1;
+            m.e(0, 2) = a2;
+            m.e(1, 0) = b0;
+            m.e(2, 0) = c0;
+            m.e(1, 1) = -(c0.conj() * a2.conj() + a0.conj() * a1 * b0) * inv_n + (1 - s);
+            m.e(1, 2) = (c0.conj() * a1.conj() - a0.conj() * a2 * b0) * inv_n;
+            m.e(2, 1) = (b0.conj() * a2.conj() - a0.conj() * a1 * c0) * inv_n;
+            m.e(2, 2) = -(b0.conj() * a1.conj() + a0.conj() * a2 * c0) * inv_n +
+                        (1 - s) * a0.conj();
+        }
+        return m;
+    }
+
+    /// Implicit conversion to full matrix
+    inline operator SU<3, T>() const {
+        return expand();
+    }
+
+    inline SU<3, T> dagger() const {
+        return expand().dagger();
+    }
+
+    inline SU<3, T> adjoint() const {
+        return expand().dagger();
+    }
+
+    inline Complex<T> trace() const {
+        return expand().trace();
+    }
+
+    /// Reunitarize the stored matrix, cleans up rounding errors
+    inline SU3_compressed &reunitarize() {
+        SU<3, T> m = expand();
+        m.reunitarize();
+        compress(m);
+        return *this;
+    }
+
+    /// Random SU(3) matrix
+    inline SU3_compressed &random(int nhits = 16) out_only {
+        SU<3, T> m;
+        m.random(nhits);
+        compress(m);
+        return *this;
+    }
+
+    std::string str(int prec = 8, char separator = ' ') const {
+        return expand().str(prec, separator);
+    }
+};
+
+/// reconstruct-12 and reconstruct-8 link types
+template <typename T>
+using SU3_r12 = SU3_compressed<12, T>;
+
+template <typename T>
+using SU3_r8 = SU3_compressed<8, T>;
+
+namespace hila {
+/// is_compressed_su3<T>::value is true for SU3_compressed types
+template <typename T>
+struct is_compressed_su3 : std::false_type {};
+
+template <int n, typename T>
+struct is_compressed_su3<SU3_compressed<n, T>> : std::true_type {};
+} // namespace hila
+
+/// Products expand the compressed matrix first
+template <int n, typename T, typename B,
+          std::enable_if_t<!hila::is_compressed_su3<B>::value, int> = 0,
+          typename R = decltype(std::declval<SU<3, T>>() * std::declval<B>())>
+inline R operator*(const SU3_compressed<n, T> &a, const B &b) {
+    return a.expand() * b;
+}
+
+template <typename A, int n, typename T,
+          std::enable_if_t<!hila::is_compressed_su3<A>::value, int> = 0,
+          typename R = decltype(std::declval<A>() * std::declval<SU<3, T>>())>
+inline R operator*(const A &a, const SU3_compressed<n, T> &b) {
+    return a * b.expand();
+}
+
+template <int n, typename T, int m, typename U>
+inline auto operator*(const SU3_compressed<n, T> &a, const SU3_compressed<m, U> &b) {
+    return a.expand() * b.expand();
+}
+
+template <int n, typename T>
+inline Complex<T> trace(const SU3_compressed<n, T> &U) {
+    return U.trace();
+}
+
+template <int n, typename T>
+inline std::ostream &operator<<(std::ostream &strm, const SU3_compressed<n, T> &U) {
+    return strm << U.expand();
+}
+
+#endif
@@ -90,12 +90,13 @@ class U1 {
 
     /// Generate random elements
     U1 &random() out_only {
-        phase = M_PI * (2.0 * hila::random() - 1.0);
+        hila::random(phase);
+        phase = M_PI * (2.0 * phase - 1.0);
         return *this;
     }
 
     U1 &gaussian_random(double width=1.0) out_only {
-        phase = hila::gaussrand() * width;
+        hila::gaussian_random(phase, width);
         return *this;
     }
 };
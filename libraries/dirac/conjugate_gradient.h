@@ -11,9 +11,14 @@
 
 #include <sstream>
 #include <iostream>
+#include "solver_guess.h"
 
 constexpr int CG_DEFAULT_MAXITERS = 10000;
 constexpr double CG_DEFAULT_ACCURACY = 1e-12;
+/// relative accuracy of each single precision solve in CG_mixed_precision
+constexpr double CG_MIXED_INNER_ACCURACY = 1e-5;
+/// iterations between residual replacements in CG_pipelined
+constexpr int CG_PIPELINED_REPLACE_INTERVAL = 50;
 
 /// The conjugate gradient operator. Applies the inverse square of an operator on a vector
 template <typename Op> class CG {
@@ -29,6 +34,23 @@ template <typename Op> class CG {
     /// Get the type the operator applies to
     using vector_type = typename Op::vector_type;
 
+    /// Number of iterations and time in ms of the last apply()
+    int iterations = 0;
+    double time_ms = 0;
+    /// Print the iterations and residue after apply()
+    bool verbose = true;
+
+    /// Start from the guess instead of out and record the solves in it
+    solver_guess<Op> *guess = nullptr;
+    bool guess_add = true;
+
+    /// Use the chronological guess g.  If add_solution is false the caller
+    /// adds the solutions (e.g. with add(psi, D psi) if D psi is needed anyway)
+    void use_guess(solver_guess<Op> &g, bool add_solution = true) {
+        guess = &g;
+        guess_add = add_solution;
+    }
+
     /// Constructor: initialize the operator
     CG(Op &op) : M(op){};
     /// Constructor: operator and accuracy
@@ -58,6 +80,9 @@ template <typename Op> class CG {
 
         gettimeofday(&start, NULL);
 
+        if (guess)
+            guess->apply(in, out);
+
         onsites(M.par) { source_norm += squarenorm(in[X]); }
 
         target_rr = accuracy * accuracy * source_norm;
@@ -99,8 +124,325 @@ template <typename Op> class CG {
         double timing =
             1e-3 * (end.tv_usec - start.tv_usec) + 1e3 * (end.tv_sec - start.tv_sec);
 
-        hila::out0 << "Conjugate Gradient: " << i << " steps in " << timing << "ms, ";
-        hila::out0 << "relative residue:" << rrnew / source_norm << "\n";
+        iterations = i;
+        time_ms = timing;
+
+        if (guess) {
+            guess->record(i, source_norm, rr_start, rrnew);
+            if (guess_add)
+                guess->add(out);
+        }
+
+        if (verbose) {
+            hila::out0 << "Conjugate Gradient: " << i << " steps in " << timing << "ms, ";
+            hila::out0 << "relative residue:" << rrnew / source_norm << "\n";
+        }
+    }
+};
+
+/// Pipelined conjugate gradient (Ghysels and Vanroose, Parallel Computing 40 (2014) 224).
+///
+/// Mathematically equivalent to CG, but the recursions are rearranged so that
+/// all vector updates and both dot products (r,r) and (w,r) of an iteration are
+/// done in a single site loop.  The dot products are combined in one non-blocking
+/// ReductionVector reduction, which runs while the operator is applied to the
+/// next vector.  Useful when the global reductions dominate, i.e. with many ranks
+/// and small local volumes.  Uses 3 more vectors than CG.
+///
+/// The recursively updated residual drifts from the true one faster than in CG,
+/// thus every replace_interval iterations r, w, s and z are recalculated from
+/// out and p (residual replacement, costs 3 extra operator applications).
+template <typename Op> class CG_pipelined {
+  private:
+    // The operator to invert
+    Op &M;
+    // desired relative accuracy
+    double accuracy = CG_DEFAULT_ACCURACY;
+    // maximum number of iterations
+    int maxiters = CG_DEFAULT_MAXITERS;
+
+  public:
+    /// Get the type the operator applies to
+    using vector_type = typename Op::vector_type;
+
+    /// Number of iterations and time in ms of the last apply()
+    int iterations = 0;
+    double time_ms = 0;
+    /// Print the iterations and residue after apply()
+    bool verbose = true;
+    /// Iterations between residual replacements
+    int replace_interval = CG_PIPELINED_REPLACE_INTERVAL;
+
+    /// Constructor: initialize the operator
+    CG_pipelined(Op &op) : M(op){};
+    /// Constructor: operator and accuracy
+    CG_pipelined(Op &op, double _accuracy) : M(op) {
+        accuracy = _accuracy;
+    };
+    /// Constructor: operator, accuracy and maximum number of iterations
+    CG_pipelined(Op &op, double _accuracy, int _maxiters) : M(op) {
+        accuracy = _accuracy;
+        maxiters = _maxiters;
+    };
+
+    /// Solve D^dagger D out = in, starting from the initial guess in out
+    void apply(Field<vector_type> &in, Field<vector_type> &out) {
+        int i;
+        struct timeval start, end;
+        // w = A r, n = A w, s = A p, z = A s
+        Field<vector_type> r, w, n, p, s, z, tmp;
+        r.copy_boundary_condition(in);
+        w.copy_boundary_condition(in);
+        n.copy_boundary_condition(in);
+        p.copy_boundary_condition(in);
+        s.copy_boundary_condition(in);
+        z.copy_boundary_condition(in);
+        tmp.copy_boundary_condition(in);
+        out.copy_boundary_condition(in);
+
+        double gamma = 0, gamma_old = 0, delta, alpha = 0, beta;
+        double target_rr, source_norm = 0;
+
+        // (r,r) and (w,r), reduced together
+        ReductionVector<double> dots(2);
+        dots.allreduce(true).nonblocking(true);
+
+        gettimeofday(&start, NULL);
+
+        onsites(M.par) { source_norm += squarenorm(in[X]); }
+        target_rr = accuracy * accuracy * source_norm;
+
+        M.apply(out, tmp);
+        M.dagger(tmp, r);
+        r[M.par] = in[X] - r[X];
+        M.apply(r, tmp);
+        M.dagger(tmp, w);
+
+        dots = 0;
+        onsites(M.par) {
+            p[X] = 0;
+            s[X] = 0;
+            z[X] = 0;
+            dots[0] += squarenorm(r[X]);
+            dots[1] += r[X].rdot(w[X]);
+        }
+
+        for (i = 0; i < maxiters; i++) {
+            if (i > 0 && i % replace_interval == 0) {
+                // residual replacement
+                dots.wait();
+                M.apply(out, tmp);
+                M.dagger(tmp, r);
+                r[M.par] = in[X] - r[X];
+                M.apply(r, tmp);
+                M.dagger(tmp, w);
+                M.apply(p, tmp);
+                M.dagger(tmp, s);
+                M.apply(s, tmp);
+                M.dagger(tmp, z);
+
+                dots = 0;
+                onsites(M.par) {
+                    dots[0] += squarenorm(r[X]);
+                    dots[1] += r[X].rdot(w[X]);
+                }
+            }
+
+            // n = A w, overlapping with the reduction
+            M.apply(w, tmp);
+            M.dagger(tmp, n);
+
+            dots.wait();
+            gamma = dots[0];
+            delta = dots[1];
+#ifdef DEBUG_CG
+            hila::out0 << "Pipelined CG step " << i << ", residue " << sqrt(gamma / target_rr)
+                       << "\n";
+#endif
+            if (gamma < target_rr)
+                break;
+
+            if (i > 0) {
+                beta = gamma / gamma_old;
+                alpha = gamma / (delta - beta * gamma / alpha);
+            } else {
+                beta = 0;
+                alpha = gamma / delta;
+            }
+            gamma_old = gamma;
+
+            dots = 0;
+            onsites(M.par) {
+                z[X] = n[X] + beta * z[X];
+                s[X] = w[X] + beta * s[X];
+                p[X] = r[X] + beta * p[X];
+                out[X] += alpha * p[X];
+                r[X] -= alpha * s[X];
+                w[X] -= alpha * z[X];
+                dots[0] += squarenorm(r[X]);
+                dots[1] += r[X].rdot(w[X]);
+            }
+        }
+        dots.wait();
+
+        gettimeofday(&end, NULL);
+        double timing =
+            1e-3 * (end.tv_usec - start.tv_usec) + 1e3 * (end.tv_sec - start.tv_sec);
+
+        iterations = i;
+        time_ms = timing;
+
+        if (verbose) {
+            hila::out0 << "Pipelined Conjugate Gradient: " << i << " steps in " << timing
+                       << "ms, ";
+            hila::out0 << "relative residue:" << gamma / source_norm << "\n";
+        }
+    }
+};
+
+/// Mixed precision conjugate gradient: defect correction with the
+/// inner solves in single precision.
+///
+/// The residual r = in - D^dagger D out is calculated in double precision,
+/// then D^dagger D e = r is solved approximately with CG in single precision
+/// (Op::type_flt on a single precision copy of the gauge field) and
+/// out is updated with e.  This is repeated until the double precision
+/// residual reaches the requested accuracy.  Most of the operator
+/// applications are done in single precision, moving half of the bytes.
+///
+/// The gauge_field type must be double precision, it is copied to single
+/// precision at the beginning of each apply().  Usage:
+///   CG_mixed_precision<Dirac_Wilson_evenodd<SU<3,double>>, gauge_field<SU<3,double>>>
+///       inverse(D, gauge);
+template <typename Op, typename gauge_field> class CG_mixed_precision {
+  private:
+    using gauge_flt_type = gauge_field_base<typename gauge_field::gauge_type_flt>;
+    using Op_flt = typename Op::type_flt;
+
+    // The double precision operator and gauge field
+    Op &M;
+    gauge_field &gauge;
+    // single precision copy of the gauge field and the operator using it
+    gauge_flt_type gauge_flt;
+    Op_flt M_flt;
+
+    // desired relative accuracy
+    double accuracy = CG_DEFAULT_ACCURACY;
+    // maximum number of single precision iterations
+    int maxiters = CG_DEFAULT_MAXITERS;
+
+  public:
+    using vector_type = typename Op::vector_type;
+    using vector_type_flt = typename Op_flt::vector_type;
+
+    /// relative accuracy of the single precision solves
+    double inner_accuracy = CG_MIXED_INNER_ACCURACY;
+
+    /// Iteration counts and timing in ms of the last apply(), by precision
+    int iterations_double = 0, iterations_float = 0;
+    double time_double = 0, time_float = 0;
+
+    /// Start from the guess instead of out and record the solves in it,
+    /// see CG::use_guess()
+    solver_guess<Op> *guess = nullptr;
+    bool guess_add = true;
+
+    void use_guess(solver_guess<Op> &g, bool add_solution = true) {
+        guess = &g;
+        guess_add = add_solution;
+    }
+
+    static_assert(std::is_same<double, typename gauge_field::basetype>::value,
+                  "CG_mixed_precision requires a double precision gauge field");
+
+    /// Constructor: operator and gauge field
+    CG_mixed_precision(Op &op, gauge_field &g) : M(op), gauge(g), M_flt(op, gauge_flt) {}
+    /// Constructor: operator, gauge field and accuracy
+    CG_mixed_precision(Op &op, gauge_field &g, double _accuracy)
+        : M(op), gauge(g), M_flt(op, gauge_flt) {
+        accuracy = _accuracy;
+    }
+    /// Constructor: operator, gauge field, accuracy and maximum number of iterations
+    CG_mixed_precision(Op &op, gauge_field &g, double _accuracy, int _maxiters)
+        : M(op), gauge(g), M_flt(op, gauge_flt) {
+        accuracy = _accuracy;
+        maxiters = _maxiters;
+    }
+
+    /// Solve D^dagger D out = in, starting from the initial guess in out
+    void apply(Field<vector_type> &in, Field<vector_type> &out) {
+        struct timeval start, end;
+        Field<vector_type> r, Dout, DDout;
+        Field<vector_type_flt> r_flt, e_flt;
+        r.copy_boundary_condition(in);
+        Dout.copy_boundary_condition(in);
+        DDout.copy_boundary_condition(in);
+        out.copy_boundary_condition(in);
+        r_flt.copy_boundary_condition(in);
+        e_flt.copy_boundary_condition(in);
+        double rr = 0, rr_start = 0, source_norm = 0, target_rr;
+
+        gettimeofday(&start, NULL);
+
+        if (guess)
+            guess->apply(in, out);
+
+        foralldir(d) gauge_flt.gauge[d] = gauge.gauge[d];
+
+        onsites(M.par) { source_norm += squarenorm(in[X]); }
+        target_rr = accuracy * accuracy * source_norm;
+
+        iterations_double = iterations_float = 0;
+        time_float = 0;
+
+        while (iterations_float < maxiters) {
+            // true residual in double precision
+            M.apply(out, Dout);
+            M.dagger(Dout, DDout);
+            rr = 0;
+            onsites(M.par) {
+                r[X] = in[X] - DDout[X];
+                rr += squarenorm(r[X]);
+            }
+            if (iterations_double == 0)
+                rr_start = rr;
+            iterations_double++;
+#ifdef DEBUG_CG
+            hila::out0 << "Mixed CG step " << iterations_double << ", residue "
+                       << sqrt(rr / target_rr) << "\n";
+#endif
+            if (rr < target_rr)
+                break;
+
+            // solve for the correction in single precision.  No need to go much below
+            // the remaining reduction of the residual
+            double inner_acc = std::max(inner_accuracy, 0.5 * sqrt(target_rr / rr));
+            CG<Op_flt> inner(M_flt, inner_acc, maxiters - iterations_float);
+            inner.verbose = false;
+
+            r_flt[M.par] = r[X];
+            e_flt[ALL] = 0;
+            inner.apply(r_flt, e_flt);
+            iterations_float += std::max(inner.iterations, 1);
+            time_float += inner.time_ms;
+
+            out[M.par] += e_flt[X];
+        }
+
+        gettimeofday(&end, NULL);
+        double timing =
+            1e-3 * (end.tv_usec - start.tv_usec) + 1e3 * (end.tv_sec - start.tv_sec);
+        time_double = timing - time_float;
+
+        if (guess) {
+            guess->record(iterations_float, source_norm, rr_start, rr);
+            if (guess_add)
+                guess->add(out);
+        }
+
+        hila::out0 << "Mixed precision CG: " << iterations_double << " double steps in "
+                   << time_double << "ms, " << iterations_float << " single steps in "
+                   << time_float << "ms, relative residue:" << rr / source_norm << "\n";
     }
 };
 
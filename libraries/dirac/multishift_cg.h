@@ -0,0 +1,174 @@
+#ifndef MULTISHIFT_CG_ALG
+#define MULTISHIFT_CG_ALG
+
+///////////////////////////////////////////////////////
+/// Multi-shift conjugate gradient
+///
+/// Solves (D^dagger D + sigma_i) x_i = b for a list of
+/// shifts sigma_i using a single Krylov sequence.  The
+/// operator is applied only for the base system (smallest
+/// shift), the other solutions are updated with scalar
+/// recursions (Jegerlehner, hep-lat/9612014).
+///
+/// Used for rational approximations in RHMC.
+///////////////////////////////////////////////////////
+
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include "conjugate_gradient.h"
+
+template <typename Op> class MultiShiftCG {
+  private:
+    // The operator to invert
+    Op &M;
+    // the shifts sigma_i
+    std::vector<double> shifts;
+    // desired relative accuracy
+    double accuracy = CG_DEFAULT_ACCURACY;
+    // maximum number of iterations
+    int maxiters = CG_DEFAULT_MAXITERS;
+
+  public:
+    /// Get the type the operator applies to
+    using vector_type = typename Op::vector_type;
+
+    /// Number of iterations and time in ms of the last apply()
+    int iterations = 0;
+    double time_ms = 0;
+    /// Iteration at which each shift converged
+    std::vector<int> shift_iterations;
+
+    /// Constructor: operator and shifts
+    MultiShiftCG(Op &op, const std::vector<double> &s) : M(op), shifts(s) {}
+    /// Constructor: operator, shifts and accuracy
+    MultiShiftCG(Op &op, const std::vector<double> &s, double _accuracy) : M(op), shifts(s) {
+        accuracy = _accuracy;
+    }
+    /// Constructor: operator, shifts, accuracy and maximum number of iterations
+    MultiShiftCG(Op &op, const std::vector<double> &s, double _accuracy, int _maxiters)
+        : M(op), shifts(s) {
+        accuracy = _accuracy;
+        maxiters = _maxiters;
+    }
+
+    /// Solve (D^dagger D + shifts[i]) out[i] = in for all i.  out is resized to the
+    /// number of shifts, initial values are not used.
+    void apply(Field<vector_type> &in, std::vector<Field<vector_type>> &out) {
+        struct timeval start, end;
+        const int n_shifts = shifts.size();
+
+        Field<vector_type> r, p, Dp, DDp;
+        std::vector<Field<vector_type>> ps(n_shifts);
+        r.copy_boundary_condition(in);
+        p.copy_boundary_condition(in);
+        Dp.copy_boundary_condition(in);
+        DDp.copy_boundary_condition(in);
+
+        out.resize(n_shifts);
+        shift_iterations.assign(n_shifts, 0);
+        if (n_shifts == 0)
+            return;
+
+        gettimeofday(&start, NULL);
+
+        // The base system uses the smallest shift, the hardest one to solve
+        double sigma = shifts[0];
+        for (double s : shifts)
+            sigma = std::min(sigma, s);
+
+        // scalar recursion variables for each shift
+        std::vector<double> zeta(n_shifts, 1.0), zeta_prev(n_shifts, 1.0),
+            zeta_next(n_shifts, 1.0);
+        std::vector<bool> active(n_shifts, true);
+        int n_active = n_shifts;
+
+        double source_norm = 0, rr, rrnew = 0, pAp;
+        double alpha, beta, alpha_prev = 1, beta_prev = 0;
+
+        onsites(M.par) {
+            r[X] = in[X];
+            p[X] = in[X];
+        }
+        for (int i = 0; i < n_shifts; i++) {
+            out[i].copy_boundary_condition(in);
+            ps[i].copy_boundary_condition(in);
+            out[i][ALL] = 0;
+            ps[i][ALL] = in[X];
+        }
+
+        onsites(M.par) { source_norm += squarenorm(in[X]); }
+        double target_rr = accuracy * accuracy * source_norm;
+        rr = source_norm;
+
+        int k;
+        for (k = 0; k < maxiters && n_active > 0; k++) {
+            pAp = 0;
+            M.apply(p, Dp);
+            M.dagger(Dp, DDp);
+            onsites(M.par) { pAp += squarenorm(Dp[X]) + sigma * squarenorm(p[X]); }
+
+            alpha = rr / pAp;
+
+            for (int i = 0; i < n_shifts; i++)
+                if (active[i]) {
+                    double ds = shifts[i] - sigma;
+                    zeta_next[i] = zeta[i] * zeta_prev[i] * alpha_prev /
+                                   (alpha * beta_prev * (zeta_prev[i] - zeta[i]) +
+                                    zeta_prev[i] * alpha_prev * (1 + ds * alpha));
+                    double alpha_i = alpha * zeta_next[i] / zeta[i];
+                    onsites(M.par) { out[i][X] = out[i][X] + alpha_i * ps[i][X]; }
+                }
+
+            rrnew = 0;
+            onsites(M.par) {
+                r[X] = r[X] - alpha * (DDp[X] + sigma * p[X]);
+                rrnew += squarenorm(r[X]);
+            }
+            beta = rrnew / rr;
+
+            for (int i = 0; i < n_shifts; i++)
+                if (active[i]) {
+                    double z = zeta_next[i] / zeta[i];
+                    double beta_i = beta * z * z;
+                    double zn = zeta_next[i];
+                    onsites(M.par) { ps[i][X] = zn * r[X] + beta_i * ps[i][X]; }
+
+                    // residual of shift i is zeta_i * r; drop converged shifts
+                    if (zn * zn * rrnew < target_rr) {
+                        active[i] = false;
+                        n_active--;
+                        shift_iterations[i] = k + 1;
+                    }
+                    zeta_prev[i] = zeta[i];
+                    zeta[i] = zn;
+                }
+
+#ifdef DEBUG_CG
+            hila::out0 << "Multishift CG step " << k << ", residue " << sqrt(rrnew / target_rr)
+                       << ", active shifts " << n_active << "\n";
+#endif
+            p[M.par] = beta * p[X] + r[X];
+            alpha_prev = alpha;
+            beta_prev = beta;
+            rr = rrnew;
+        }
+
+        for (int i = 0; i < n_shifts; i++)
+            if (active[i])
+                shift_iterations[i] = k;
+
+        gettimeofday(&end, NULL);
+        double timing =
+            1e-3 * (end.tv_usec - start.tv_usec) + 1e3 * (end.tv_sec - start.tv_sec);
+
+        iterations = k;
+        time_ms = timing;
+
+        hila::out0 << "Multishift CG: " << n_shifts << " shifts, " << k << " steps in "
+                   << timing << "ms, ";
+        hila::out0 << "relative residue:" << rrnew / source_norm << "\n";
+    }
+};
+
+#endif
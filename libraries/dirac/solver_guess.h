@@ -0,0 +1,242 @@
+#ifndef SOLVER_GUESS_H
+#define SOLVER_GUESS_H
+
+#include "hila.h"
+#include "plumbing/multi_dot.h"
+#include <cmath>
+
+/// Relative size of the smallest accepted pivot in the projected solves.  Basis vectors
+/// whose component orthogonal to the previous ones is smaller are dropped.
+#ifndef MRE_PIVOT_TOLERANCE
+#define MRE_PIVOT_TOLERANCE 1e-12
+#endif
+
+namespace hila {
+
+/// Solve G v = b for a symmetric positive (semi)definite G with the Cholesky
+/// decomposition G = L L^T.  Directions with a pivot below MRE_PIVOT_TOLERANCE
+/// relative to the largest diagonal element, i.e. (nearly) linearly dependent or
+/// vanishing basis vectors, get v = 0.
+inline std::vector<double> projected_solve(const std::vector<std::vector<double>> &G,
+                                           const std::vector<double> &b) {
+    int n = b.size();
+    double max_diag = 0;
+    for (int i = 0; i < n; i++)
+        max_diag = std::max(max_diag, G[i][i]);
+
+    std::vector<std::vector<double>> L(n, std::vector<double>(n, 0.0));
+    std::vector<bool> keep(n);
+    for (int j = 0; j < n; j++) {
+        double d = G[j][j];
+        for (int k = 0; k < j; k++)
+            d -= L[j][k] * L[j][k];
+        keep[j] = (d > MRE_PIVOT_TOLERANCE * max_diag && d > 0);
+        if (keep[j]) {
+            L[j][j] = sqrt(d);
+            for (int i = j + 1; i < n; i++) {
+                double s = G[i][j];
+                for (int k = 0; k < j; k++)
+                    s -= L[i][k] * L[j][k];
+                L[i][j] = s / L[j][j];
+            }
+        }
+    }
+
+    // Solve L y = b and L^T v = y
+    std::vector<double> v(n, 0.0);
+    for (int i = 0; i < n; i++)
+        if (keep[i]) {
+            double s = b[i];
+            for (int k = 0; k < i; k++)
+                s -= L[i][k] * v[k];
+            v[i] = s / L[i][i];
+        }
+    for (int i = n - 1; i >= 0; i--)
+        if (keep[i]) {
+            double s = v[i];
+            for (int k = i + 1; k < n; k++)
+                s -= L[k][i] * v[k];
+            v[i] = s / L[i][i];
+        }
+
+    for (int i = 0; i < n; i++)
+        if (std::isnan(v[i]))
+            v[i] = 0;
+
+    return v;
+}
+
+} // namespace hila
+
+/// Chronological initial guess for solving D^dagger D psi = chi.
+///
+/// Keeps the last size() solutions x_i in a ring of preallocated fields together
+/// with the projected matrix G[i][j] = x_i.(D^dagger D x_j).  When a solution is
+/// added, D^dagger D is applied to it once and its row of G is computed with one
+/// fused multi_rdot.  The guess minimizes the D^dagger D -norm of the error in the
+/// span of the x_i, using G and b[i] = x_i.chi:  it costs one operator application,
+/// one multi_rdot and one multi_axpy (MRE_guess() needs size() operator applications).
+///
+/// The operator application in apply() recomputes the row of the newest solution
+/// with the current operator, in the same multi_rdot as b.  The older rows are from
+/// the operator of the time they were added or refreshed.  During an MD trajectory the
+/// gauge field changes slowly and the guess is still good, the solver corrects the rest.
+/// After a rejected trajectory call clear(), the stored solutions belong to the
+/// rejected gauge fields.
+///
+/// Attach to a CG with inverse.use_guess(guess).  The solver then starts from the
+/// guess, adds the solution and records the iteration counts, and report() prints
+/// the estimated iterations saved since the previous report.
+template <typename Op> class solver_guess {
+  public:
+    using vector_type = typename Op::vector_type;
+
+  private:
+    Op &M;
+    int max_size = 0;
+    int n_stored = 0;
+    // ring index of the newest solution
+    int newest = -1;
+    std::vector<Field<vector_type>> x;
+    std::vector<std::vector<double>> G;
+    Field<vector_type> Dx, DDx;
+
+    // statistics since the last report()
+    int64_t n_solves = 0, n_iterations = 0;
+    double n_saved = 0;
+
+    /// stored solutions, newest first
+    std::vector<int> ring_order() const {
+        std::vector<int> order(n_stored);
+        for (int i = 0; i < n_stored; i++)
+            order[i] = (newest - i + max_size) % max_size;
+        return order;
+    }
+
+  public:
+    solver_guess(Op &op, int size = 0) : M(op) {
+        resize(size);
+    }
+
+    /// Number of solutions kept.  Drops the stored solutions
+    void resize(int size) {
+        max_size = size;
+        x.resize(max_size);
+        for (int i = 0; i < max_size; i++)
+            x[i][ALL] = 0;
+        G.assign(max_size, std::vector<double>(max_size, 0.0));
+        clear();
+    }
+
+    int size() const {
+        return max_size;
+    }
+
+    /// Number of solutions stored now
+    int stored() const {
+        return n_stored;
+    }
+
+    /// Forget the stored solutions, e.g. after a rejected trajectory
+    void clear() {
+        n_stored = 0;
+        newest = -1;
+    }
+
+    /// Set psi to the guess for D^dagger D psi = chi
+    void apply(const Field<vector_type> &chi, Field<vector_type> &psi) {
+        psi[ALL] = 0;
+        if (n_stored == 0)
+            return;
+
+        std::vector<int> order = ring_order();
+        std::vector<const Field<vector_type> *> basis(n_stored);
+        for (int i = 0; i < n_stored; i++)
+            basis[i] = &x[order[i]];
+
+        // refresh the row of the newest solution with the current operator
+        Dx.copy_boundary_condition(x[newest]);
+        DDx.copy_boundary_condition(x[newest]);
+        M.apply(x[newest], Dx);
+        M.dagger(Dx, DDx);
+
+        auto b = hila::multi_rdot(basis, std::vector<const Field<vector_type> *>{&chi, &DDx},
+                                  M.par);
+        for (int i = 0; i < n_stored; i++) {
+            G[order[i]][newest] = b[i][1];
+            G[newest][order[i]] = b[i][1];
+        }
+
+        std::vector<std::vector<double>> Gs(n_stored, std::vector<double>(n_stored));
+        std::vector<double> bs(n_stored);
+        for (int i = 0; i < n_stored; i++) {
+            bs[i] = b[i][0];
+            for (int j = 0; j < n_stored; j++)
+                Gs[i][j] = G[order[i]][order[j]];
+        }
+
+        std::vector<double> v = hila::projected_solve(Gs, bs);
+        hila::multi_axpy(psi, v, basis, M.par);
+    }
+
+    /// Add a solution, with D psi already calculated (saves one operator application)
+    void add(const Field<vector_type> &psi, const Field<vector_type> &Dpsi) {
+        if (max_size == 0)
+            return;
+
+        int slot = (newest + 1) % max_size;
+        x[slot].copy_boundary_condition(psi);
+        x[slot][M.par] = psi[X];
+        newest = slot;
+        if (n_stored < max_size)
+            n_stored++;
+
+        DDx.copy_boundary_condition(psi);
+        M.dagger(Dpsi, DDx);
+
+        std::vector<int> order = ring_order();
+        std::vector<const Field<vector_type> *> basis(n_stored);
+        for (int i = 0; i < n_stored; i++)
+            basis[i] = &x[order[i]];
+
+        auto g = hila::multi_rdot(basis, std::vector<const Field<vector_type> *>{&DDx}, M.par);
+        for (int i = 0; i < n_stored; i++) {
+            G[order[i]][slot] = g[i][0];
+            G[slot][order[i]] = g[i][0];
+        }
+    }
+
+    /// Add a solution
+    void add(const Field<vector_type> &psi) {
+        if (max_size == 0)
+            return;
+        Field<vector_type> Dpsi;
+        Dpsi.copy_boundary_condition(psi);
+        M.apply(psi, Dpsi);
+        add(psi, Dpsi);
+    }
+
+    /// Record a solve: iterations and the squared norms of the source, the starting
+    /// and the final residual.  The iterations without the guess are estimated
+    /// assuming a constant convergence rate.
+    void record(int iterations, double source_norm, double rr_start, double rr_final) {
+        n_solves++;
+        n_iterations += iterations;
+        if (rr_start < source_norm && rr_final > 0 && rr_final < rr_start)
+            n_saved += iterations * (log(source_norm / rr_final) / log(rr_start / rr_final) - 1);
+    }
+
+    /// Print the statistics since the previous report and reset them
+    void report() {
+        if (n_solves > 0) {
+            hila::out0 << "SOLVER GUESS: " << n_solves << " solves, " << n_iterations
+                       << " iterations, estimated " << (int64_t)n_saved << " saved ("
+                       << 100.0 * n_saved / (n_iterations + n_saved) << "%), " << n_stored
+                       << " solutions in basis\n";
+        }
+        n_solves = n_iterations = 0;
+        n_saved = 0;
+    }
+};
+
+#endif
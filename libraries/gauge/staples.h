@@ -18,16 +18,17 @@
  *
  * But the method is computed in a slightly more optimized way
  *
- * @tparam T
+ * @tparam T Gauge group type
+ * @tparam S Type of the staple, T or for compressed links (SU3_compressed) SU<3,..>
  * @param U GaugeField to compute staples for
  * @param staples Filed to compute staplesum into at each lattice point
  * @param d1 Direction to compute staplesum for
  * @param par Parity to compute staplesum for
  */
-template <typename T>
-void staplesum(const GaugeField<T> &U, Field<T> &staples, Direction d1, Parity par = ALL) {
+template <typename T, typename S>
+void staplesum(const GaugeField<T> &U, Field<S> &staples, Direction d1, Parity par = ALL) {
 
-    Field<T> lower;
+    Field<S> lower;
 
     bool first = true;
     foralldir(d2) if (d2 != d1) {
@@ -7,10 +7,10 @@
 
 // functions for Wilson's plaquette action -S_{plaq}=\beta/N * \sum_{plaq} ReTr(plaq)
 
-template <typename T>
-void rstaplesum(const GaugeField<T> &U, out_only Field<T> &staples, Direction d1) {
+template <typename T, typename S>
+void rstaplesum(const GaugeField<T> &U, out_only Field<S> &staples, Direction d1) {
 
-    Field<T> lower;
+    Field<S> lower;
     bool first = true;
     foralldir(d2) if (d2 != d1) {
 
@@ -3,87 +3,51 @@
 
 #include "gauge_field.h"
 #include "dirac/Hasenbusch.h"
+#include "dirac/solver_guess.h"
 #include <cmath>
 
 /// Builds an initial guess for a matrix inverter given a set of basis vectors
+///
+/// Minimizes the D^dagger D -norm of the error in the space spanned by
+/// old_chi_inv, i.e. solves M v = b with M[i][j] = x_i.(D^dagger D x_j) and
+/// b[i] = x_i.chi, and sets psi = sum_i v[i] x_i.
+/// M and b come from one hila::multi_rdot() call.  The basis is orthogonalized
+/// in coefficient space with the Cholesky decomposition of M, which drops
+/// (nearly) linearly dependent or vanishing vectors (hila::projected_solve).
+///
+/// This costs MRE_size operator applications per call, solver_guess keeps the
+/// projected matrix between calls instead.
 template <typename vector_type, typename DIRAC_OP>
-void MRE_guess(Field<vector_type> &psi, Field<vector_type> &chi, DIRAC_OP D,
-               std::vector<Field<vector_type>> old_chi_inv) {
+void MRE_guess(Field<vector_type> &psi, const Field<vector_type> &chi, DIRAC_OP &D,
+               const std::vector<Field<vector_type>> &old_chi_inv) {
     int MRE_size = old_chi_inv.size();
-    double M[MRE_size][MRE_size];
-    double v[MRE_size];
-    Field<vector_type> basis[MRE_size];
+    std::vector<Field<vector_type>> DDchi(MRE_size);
     Field<vector_type> tmp;
 
-    // Build an orthogonal basis from the previous solutions
+    std::vector<const Field<vector_type> *> basis(MRE_size), rhs(MRE_size + 1);
     for (int i = 0; i < MRE_size; i++) {
-        // Start with the original solution vector
-        basis[i][ALL] = old_chi_inv[i][X];
-        // Remove the projected components of all previous vectors
-        for (int j = 0; j < i; j++) {
-            double vdot = 0, norm = 0;
-            onsites(D.par) {
-                norm += basis[i][X].rdot(basis[i][X]);
-                vdot += basis[j][X].rdot(basis[i][X]);
-            }
-            if (norm * norm > 1e-32) {
-                onsites(D.par) { basis[i][X] = basis[i][X] - vdot / norm * basis[j][X]; }
-            }
-        }
+        D.apply(old_chi_inv[i], tmp);
+        D.dagger(tmp, DDchi[i]);
+        basis[i] = &old_chi_inv[i];
+        rhs[i] = &DDchi[i];
     }
+    rhs[MRE_size] = &chi;
 
-    // Build the projected matrix, M[i][j] = v[i].v[j]
-    for (int i = 0; i < MRE_size; i++) {
-        Field<vector_type> Dchi, DDchi;
-        D.apply(basis[i], Dchi);
-        D.dagger(Dchi, DDchi);
-        for (int j = 0; j < MRE_size; j++) {
-            double sum = 0;
-            onsites(D.par) { sum += basis[j][X].rdot(DDchi[X]); }
-            M[j][i] = sum;
-        }
-    }
-    // And the projected vector
-    for (int i = 0; i < MRE_size; i++) {
-        double sum = 0;
-        onsites(D.par) { sum += basis[i][X].rdot(chi[X]); }
-        v[i] = sum;
-    }
+    // The projected matrix, M[i][j] = x_i.DDx_j and the projected vector M[i][MRE_size]
+    auto M = hila::multi_rdot(basis, rhs, D.par);
 
-    // Now invert the small matrix M (Gaussian elimination)
+    std::vector<std::vector<double>> G(MRE_size, std::vector<double>(MRE_size));
+    std::vector<double> b(MRE_size);
     for (int i = 0; i < MRE_size; i++) {
-        // Check that the diagonal element is nonzero
-        if (M[i][i] * M[i][i] > 1e-32) {
-            // Normalize the i:th row
-            double diag_inv = 1.0 / M[i][i];
-            for (int j = 0; j < MRE_size; j++) {
-                M[i][j] *= diag_inv;
-            }
-            v[i] *= diag_inv;
-            // Subtract from all other rows
-            for (int k = 0; k < MRE_size; k++)
-                if (k != i) {
-                    double weight = M[k][i];
-                    for (int j = 0; j < MRE_size; j++) {
-                        M[k][j] -= weight * M[i][j];
-                    }
-                    v[k] -= weight * v[i];
-                }
-        } else {
-            // In the matrix element is too small, just remove it from the basis
-            v[i] = 0;
-            for (int j = 0; j < MRE_size; j++) {
-                M[j][i] = 0;
-            }
-        }
+        b[i] = M[i][MRE_size];
+        for (int j = 0; j < MRE_size; j++)
+            G[i][j] = M[i][j];
     }
+    std::vector<double> v = hila::projected_solve(G, b);
 
     // Construct the solution in the original basis
     psi[ALL] = 0;
-    for (int i = 0; i < MRE_size; i++)
-        if (!isnan(v[i])) {
-            onsites(D.par) { psi[X] = basis[i][X] + v[i] * basis[i][X]; }
-        }
+    hila::multi_axpy(psi, v, basis, D.par);
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -4,16 +4,75 @@
 #include "gauge_field.h"
 #include "dirac/Hasenbusch.h"
 #include "dirac/conjugate_gradient.h"
+#include "dirac/multishift_cg.h"
 #include "MRE_guess.h"
 #include <cmath>
 
+/// Solver of (D^dagger D) psi = chi for the pseudofermion actions, shared by
+/// fermion_action and Hasenbusch_action_2.  The solves start from the chronological
+/// initial guess (solver_guess) of the action.
+template <typename gauge_field, typename DIRAC_OP>
+class pseudofermion_solver {
+  public:
+    using vector_type = typename DIRAC_OP::vector_type;
+    gauge_field &gauge;
+    DIRAC_OP &D;
+    solver_guess<DIRAC_OP> &guess;
+
+    /// Use the mixed precision CG (CG_mixed_precision) in the force.  Only used
+    /// with a double precision gauge field, default is the double precision CG
+    bool mixed_precision = false;
+
+    pseudofermion_solver(gauge_field &g, DIRAC_OP &d, solver_guess<DIRAC_OP> &sg)
+        : gauge(g), D(d), guess(sg) {}
+
+    /// Build an initial guess for the fermion matrix inversion
+    /// by inverting first in the limited space of a few previous
+    /// solutions. These are saved in guess.
+    void initial_guess(Field<vector_type> &chi, Field<vector_type> &psi) {
+        guess.apply(chi, psi);
+        // If the gauge type is double precision, solve first in single precision
+        if constexpr (std::is_same<double, typename gauge_field::basetype>::value) {
+            hila::out0 << "Starting with single precision inversion\n";
+
+            auto single_precision = gauge.get_single_precision();
+            typename DIRAC_OP::type_flt D_flt(D, single_precision);
+            Field<typename DIRAC_OP::type_flt::vector_type> c, p, t1, t2;
+            c[ALL] = chi[X];
+            p[ALL] = psi[X];
+            CG inverse(D_flt);
+            inverse.apply(c, p);
+
+            D_flt.apply(p, t1);
+            D_flt.dagger(t1, t2);
+            psi[ALL] = p[X];
+        }
+    }
+
+    /// Solve (D^dagger D) psi = chi, starting from the chronological guess.
+    /// The solution is not added to the guess, the caller does it with D psi
+    void invert(Field<vector_type> &chi, Field<vector_type> &psi) {
+        if constexpr (std::is_same<double, typename gauge_field::basetype>::value) {
+            if (mixed_precision) {
+                CG_mixed_precision<DIRAC_OP, gauge_field> inverse(D, gauge);
+                inverse.use_guess(guess, false);
+                inverse.apply(chi, psi);
+                return;
+            }
+        }
+        CG<DIRAC_OP> inverse(D);
+        inverse.use_guess(guess, false);
+        inverse.apply(chi, psi);
+    }
+};
+
 /// Define the action of a pseudofermion for HMC
 ///
 /// Implements methods for calculating the current action
 /// and the force (derivative with respect to the gauge
 /// field).
 ///
-/// Includes an implementation of the MRE initial guess,
+/// Includes a chronological initial guess (solver_guess),
 /// which is calculated in the base of a few previous
 /// solutions. Using this requires a higher accuracy,
 /// since the initial guess is not time reversible.
@@ -27,62 +86,46 @@ class fermion_action : public action_base {
     DIRAC_OP &D;
     Field<vector_type> chi;
 
-    /// We save a few previous invertions to build an initial guess.
-    /// old_chi contains a list of these
-    int MRE_size = 0;
-    std::vector<Field<vector_type>> old_chi_inv;
+    /// We save a few previous invertions to build an initial guess
+    solver_guess<DIRAC_OP> guess;
+    /// Solves with the guess, set solver.mixed_precision for the mixed precision CG
+    pseudofermion_solver<gauge_field, DIRAC_OP> solver;
 
     void setup(int mre_guess_size) {
 #if NDIM > 3
         chi.set_boundary_condition(e_t, hila::bc::ANTIPERIODIC);
         chi.set_boundary_condition(-e_t, hila::bc::ANTIPERIODIC);
 #endif
-        MRE_size = mre_guess_size;
-        old_chi_inv.resize(MRE_size);
-        for (int i = 0; i < MRE_size; i++) {
-            old_chi_inv[i][ALL] = 0;
-        }
+        guess.resize(mre_guess_size);
     }
 
-    fermion_action(DIRAC_OP &d, gauge_field &g) : D(d), gauge(g) {
+    fermion_action(DIRAC_OP &d, gauge_field &g)
+        : D(d), gauge(g), guess(d), solver(gauge, D, guess) {
         chi = 0.0; // Allocates chi and sets it to zero
         setup(0);
     }
 
-    fermion_action(DIRAC_OP &d, gauge_field &g, int mre_guess_size) : D(d), gauge(g) {
+    fermion_action(DIRAC_OP &d, gauge_field &g, int mre_guess_size)
+        : D(d), gauge(g), guess(d), solver(gauge, D, guess) {
         chi = 0.0; // Allocates chi and sets it to zero
         setup(mre_guess_size);
     }
 
-    fermion_action(fermion_action &fa) : gauge(fa.gauge), D(fa.D) {
+    fermion_action(fermion_action &fa)
+        : gauge(fa.gauge), D(fa.D), guess(fa.D), solver(gauge, D, guess) {
         chi = fa.chi; // Copies the field
-        setup(fa.MRE_size);
+        solver.mixed_precision = fa.solver.mixed_precision;
+        setup(fa.guess.size());
     }
 
-    /// Build an initial guess for the fermion matrix inversion
-    /// by inverting first in the limited space of a few previous
-    /// solutions. These are saved in old_chi.
-    void initial_guess(Field<vector_type> &chi, Field<vector_type> &psi) {
-        psi[ALL] = 0;
-        if (MRE_size > 0) {
-            MRE_guess(psi, chi, D, old_chi_inv);
-        }
-        // If the gauge type is double precision, solve first in single precision
-        if constexpr (std::is_same<double, typename gauge_field::basetype>::value) {
-            hila::out0 << "Starting with single precision inversion\n";
-
-            auto single_precision = gauge.get_single_precision();
-            typename DIRAC_OP::type_flt D_flt(D, single_precision);
-            Field<typename DIRAC_OP::type_flt::vector_type> c, p, t1, t2;
-            c[ALL] = chi[X];
-            p[ALL] = psi[X];
-            CG inverse(D_flt);
-            inverse.apply(c, p);
+    /// Print the solver guess statistics of the trajectory
+    void trajectory_report() {
+        guess.report();
+    }
 
-            D_flt.apply(p, t1);
-            D_flt.dagger(t1, t2);
-            psi[ALL] = p[X];
-        }
+    /// The trajectory was rejected, the stored solutions are for the rejected fields
+    void restore_backup() {
+        guess.clear();
     }
 
     /// Return the value of the action with the current
@@ -96,7 +139,7 @@ class fermion_action : public action_base {
         gauge.refresh();
 
         psi = 0;
-        initial_guess(chi, psi);
+        solver.initial_guess(chi, psi);
         inverse.apply(chi, psi);
         onsites(D.par) { action += chi[X].rdot(psi[X]); }
         return action;
@@ -111,7 +154,7 @@ class fermion_action : public action_base {
         gauge.refresh();
 
         psi = 0;
-        initial_guess(chi, psi);
+        solver.initial_guess(chi, psi);
         inverse.apply(chi, psi);
         onsites(D.par) {
             S[X] += chi[X].rdot(psi[X]);
@@ -131,16 +174,6 @@ class fermion_action : public action_base {
         D.dagger(psi, chi);
     }
 
-    /// Add new solution to the list for MRE
-    void save_new_solution(Field<vector_type> &psi) {
-        if (MRE_size > 0) {
-            for (int i = 1; i < MRE_size; i++) {
-                old_chi_inv[i] = old_chi_inv[i - 1];
-            }
-            old_chi_inv[0] = psi;
-        }
-    }
-
     /// Update the momentum with the derivative of the fermion
     /// action
     void force_step(double eps) {
@@ -149,15 +182,13 @@ class fermion_action : public action_base {
         Mpsi.copy_boundary_condition(chi);
         Field<momtype> force[NDIM], force2[NDIM];
 
-        CG<DIRAC_OP> inverse(D);
         gauge.refresh();
 
         hila::out0 << "base force\n";
-        initial_guess(chi, psi);
-        inverse.apply(chi, psi);
-        save_new_solution(psi);
+        solver.invert(chi, psi);
 
         D.apply(psi, Mpsi);
+        guess.add(psi, Mpsi);
 
         D.force(Mpsi, psi, force, 1);
         D.force(psi, Mpsi, force2, -1);
@@ -197,6 +228,8 @@ class Hasenbusch_action_1 : public action_base {
     void action(Field<double> &S) { base_action.action(S); }
     void draw_gaussian_fields() { base_action.draw_gaussian_fields(); }
     void force_step(double eps) { base_action.force_step(eps); }
+    void trajectory_report() { base_action.trajectory_report(); }
+    void restore_backup() { base_action.restore_backup(); }
 };
 
 /// The second Hasenbusch action term, D_h2 = D/(D^dagger + mh).
@@ -214,38 +247,36 @@ class Hasenbusch_action_2 : public action_base {
     double mh;
     Field<vector_type> chi;
 
-    // We save a few previous invertions to build an initial guess.
-    // old_chi contains a list of these
-    int MRE_size = 0;
-    std::vector<Field<vector_type>> old_chi_inv;
+    // We save a few previous invertions to build an initial guess
+    solver_guess<DIRAC_OP> guess;
+    /// Solves with the guess, set solver.mixed_precision for the mixed precision CG
+    pseudofermion_solver<gauge_field, DIRAC_OP> solver;
 
     void setup(int mre_guess_size) {
 #if NDIM > 3
         chi.set_boundary_condition(e_t, hila::bc::ANTIPERIODIC);
         chi.set_boundary_condition(-e_t, hila::bc::ANTIPERIODIC);
 #endif
-        MRE_size = mre_guess_size;
-        old_chi_inv.resize(MRE_size);
-        for (int i = 0; i < MRE_size; i++) {
-            old_chi_inv[i][ALL] = 0;
-        }
+        guess.resize(mre_guess_size);
     }
 
     Hasenbusch_action_2(DIRAC_OP &d, gauge_field &g, double _mh)
-        : mh(_mh), D(d), D_h(d, _mh), gauge(g) {
+        : mh(_mh), D(d), D_h(d, _mh), gauge(g), guess(D), solver(gauge, D, guess) {
         chi = 0.0; // Allocates chi and sets it to zero
         setup(0);
     }
     Hasenbusch_action_2(DIRAC_OP &d, gauge_field &g, double _mh, int mre_guess_size)
-        : mh(_mh), D(d), D_h(d, _mh), gauge(g) {
+        : mh(_mh), D(d), D_h(d, _mh), gauge(g), guess(D), solver(gauge, D, guess) {
         chi = 0.0; // Allocates chi and sets it to zero
         setup(mre_guess_size);
     }
 
     Hasenbusch_action_2(Hasenbusch_action_2 &fa)
-        : mh(fa.mh), D(fa.D), D_h(fa.D_h), gauge(fa.gauge) {
+        : mh(fa.mh), D(fa.D), D_h(fa.D_h), gauge(fa.gauge), guess(D),
+          solver(gauge, D, guess) {
         chi = fa.chi; // Copies the field
-        setup(fa.MRE_size);
+        solver.mixed_precision = fa.solver.mixed_precision;
+        setup(fa.guess.size());
     }
 
     /// Return the value of the action with the current
@@ -308,40 +339,14 @@ class Hasenbusch_action_2 : public action_base {
         D_h.apply(psi, chi);
     }
 
-    /// Build an initial guess for the fermion matrix inversion
-    /// by inverting first in the limited space of a few previous
-    /// solutions. These are saved in old_chi.
-    void initial_guess(Field<vector_type> &chi, Field<vector_type> &psi) {
-        psi[ALL] = 0;
-        if (MRE_size > 0) {
-            MRE_guess(psi, chi, D, old_chi_inv);
-        }
-        // If the gauge type is double precision, solve first in single precision
-        if constexpr (std::is_same<double, typename gauge_field::basetype>::value) {
-            hila::out0 << "Starting with single precision inversion\n";
-
-            auto single_precision = gauge.get_single_precision();
-            typename DIRAC_OP::type_flt D_flt(D, single_precision);
-            Field<typename DIRAC_OP::type_flt::vector_type> c, p, t1, t2;
-            c[ALL] = chi[X];
-            p[ALL] = psi[X];
-            CG inverse(D_flt);
-            inverse.apply(c, p);
-
-            D_flt.apply(p, t1);
-            D_flt.dagger(t1, t2);
-            psi[ALL] = p[X];
-        }
+    /// Print the solver guess statistics of the trajectory
+    void trajectory_report() {
+        guess.report();
     }
 
-    /// Add new solution to the list
-    void save_new_solution(Field<vector_type> &psi) {
-        if (MRE_size > 0) {
-            for (int i = 1; i < MRE_size; i++) {
-                old_chi_inv[i] = old_chi_inv[i - 1];
-            }
-            old_chi_inv[0] = psi;
-        }
+    /// The trajectory was rejected, the stored solutions are for the rejected fields
+    void restore_backup() {
+        guess.clear();
     }
 
     /// Update the momentum with the derivative of the fermion
@@ -354,16 +359,14 @@ class Hasenbusch_action_2 : public action_base {
         Dhchi.copy_boundary_condition(chi);
         Field<momtype> force[NDIM], force2[NDIM];
 
-        CG<DIRAC_OP> inverse(D);
         gauge.refresh();
 
         D_h.dagger(chi, Dhchi);
 
-        initial_guess(Dhchi, psi);
-        inverse.apply(Dhchi, psi);
-        save_new_solution(psi);
+        solver.invert(Dhchi, psi);
 
         D.apply(psi, Mpsi);
+        guess.add(psi, Mpsi);
 
         Mpsi[D.par] = Mpsi[X] - chi[X];
 
@@ -375,4 +378,139 @@ class Hasenbusch_action_2 : public action_base {
     }
 };
 
-#endif
\ No newline at end of file
+
+/// Coefficients of a rational function
+///   r(x) = a0 + sum_i a[i] / (x + b[i])
+/// used in rational_fermion_action.  The coefficients are calculated
+/// beforehand, for example with the Remez algorithm, for the spectral
+/// range of D^dagger D.
+struct rational_approximation {
+    double a0 = 0;
+    std::vector<double> a, b;
+};
+
+/// Rational (RHMC) pseudofermion action
+///   S = chi^dagger r_action(D^dagger D) chi,
+/// where r_action approximates (D^dagger D)^(-power) for a fractional power.
+/// The pseudofermion field is drawn as chi = r_heatbath(D^dagger D) eta,
+/// with r_heatbath approximating (D^dagger D)^(power/2) and eta gaussian.
+///
+/// All poles of a rational function are solved with a single MultiShiftCG.
+template <typename gauge_field, typename DIRAC_OP>
+class rational_fermion_action : public action_base {
+  public:
+    using vector_type = typename DIRAC_OP::vector_type;
+    using momtype = SquareMatrix<gauge_field::N, Complex<typename gauge_field::basetype>>;
+    gauge_field &gauge;
+    DIRAC_OP &D;
+    Field<vector_type> chi;
+
+    /// Rational approximations for the action/force and the heatbath
+    rational_approximation r_action, r_heatbath;
+    /// Accuracy of the multishift solves
+    double accuracy = CG_DEFAULT_ACCURACY;
+
+    void setup() {
+#if NDIM > 3
+        chi.set_boundary_condition(e_t, hila::bc::ANTIPERIODIC);
+        chi.set_boundary_condition(-e_t, hila::bc::ANTIPERIODIC);
+#endif
+        assert(r_action.a.size() == r_action.b.size() &&
+               r_heatbath.a.size() == r_heatbath.b.size() &&
+               "rational approximation coefficient mismatch");
+    }
+
+    rational_fermion_action(DIRAC_OP &d, gauge_field &g, const rational_approximation &ra,
+                            const rational_approximation &rh)
+        : D(d), gauge(g), r_action(ra), r_heatbath(rh) {
+        chi = 0.0; // Allocates chi and sets it to zero
+        setup();
+    }
+
+    rational_fermion_action(rational_fermion_action &fa)
+        : gauge(fa.gauge), D(fa.D), r_action(fa.r_action), r_heatbath(fa.r_heatbath),
+          accuracy(fa.accuracy) {
+        chi = fa.chi; // Copies the field
+        setup();
+    }
+
+    /// out = r(D^dagger D) in
+    void apply_rational(const rational_approximation &r, Field<vector_type> &in,
+                        Field<vector_type> &out) {
+        std::vector<Field<vector_type>> x;
+        MultiShiftCG<DIRAC_OP> inverse(D, r.b, accuracy);
+        inverse.apply(in, x);
+
+        out.copy_boundary_condition(in);
+        out[ALL] = 0;
+        out[D.par] = r.a0 * in[X];
+        hila::multi_axpy(out, r.a, x, D.par);
+    }
+
+    /// Return the value of the action with the current
+    /// field configuration
+    double action() {
+        Field<vector_type> psi;
+        double action = 0;
+
+        gauge.refresh();
+
+        apply_rational(r_action, chi, psi);
+        onsites(D.par) { action += chi[X].rdot(psi[X]); }
+        return action;
+    }
+
+    /// Calculate the action as a field of double precision numbers
+    void action(Field<double> &S) {
+        Field<vector_type> psi;
+
+        gauge.refresh();
+
+        apply_rational(r_action, chi, psi);
+        onsites(D.par) { S[X] += chi[X].rdot(psi[X]); }
+    }
+
+    /// Generate a pseudofermion field with a distribution given
+    /// by the action chi r_action(D_dagger D) chi
+    void draw_gaussian_fields() {
+        Field<vector_type> eta;
+        eta.copy_boundary_condition(chi);
+        gauge.refresh();
+
+        eta[ALL] = 0;
+        onsites(D.par) { eta[X].gaussian_random(); }
+        apply_rational(r_heatbath, eta, chi);
+    }
+
+    /// Update the momentum with the derivative of the fermion
+    /// action.  Each pole contributes the ordinary fermion force
+    /// with psi_i = 1/(D^dagger D + b_i) chi, weighted by a_i.
+    void force_step(double eps) {
+        std::vector<Field<vector_type>> psi;
+        Field<vector_type> Mpsi;
+        Mpsi.copy_boundary_condition(chi);
+        Field<momtype> force[NDIM], force2[NDIM], total_force[NDIM];
+
+        gauge.refresh();
+
+        MultiShiftCG<DIRAC_OP> inverse(D, r_action.b, accuracy);
+        inverse.apply(chi, psi);
+
+        foralldir(dir) total_force[dir][ALL] = 0;
+        for (int i = 0; i < r_action.a.size(); i++) {
+            double weight = -eps * r_action.a[i];
+            D.apply(psi[i], Mpsi);
+
+            D.force(Mpsi, psi[i], force, 1);
+            D.force(psi[i], Mpsi, force2, -1);
+
+            foralldir(dir) {
+                total_force[dir][ALL] =
+                    total_force[dir][X] + weight * (force[dir][X] + force2[dir][X]);
+            }
+        }
+        gauge.add_momentum(total_force);
+    }
+};
+
+#endif
@@ -439,6 +439,51 @@ class gauge_momentum_action : public action_base, public integrator_base {
 
     /// Update the gauge field with momentum
     void step(double eps) { gauge.gauge_update(eps); }
+
+    /* Storage for the force gradient integrator and force monitoring */
+    Field<gauge_mat> momentum_store[NDIM];
+    Field<gauge_mat> gauge_store[NDIM];
+
+    /// Store the momentum and set it to zero
+    void momentum_push() {
+        foralldir(dir) momentum_store[dir] = gauge.momentum[dir];
+        gauge.zero_momentum();
+    }
+
+    /// Restore the stored momentum, adding scale * current momentum
+    void momentum_pop(double scale) {
+        foralldir(dir) {
+            onsites(ALL) {
+                gauge.momentum[dir][X] = momentum_store[dir][X] + scale * gauge.momentum[dir][X];
+            }
+        }
+    }
+
+    /// rms over links and max of the norm of the momentum
+    void momentum_norm(double &rms, double &max) {
+        double sum = 0;
+        Field<double> maxnorm = 0;
+        foralldir(dir) {
+            onsites(ALL) {
+                double n = gauge.momentum[dir][X].algebra_norm();
+                sum += n;
+                if (n > maxnorm[X])
+                    maxnorm[X] = n;
+            }
+        }
+        rms = sqrt(sum / (NDIM * lattice.volume()));
+        max = sqrt(maxnorm.max());
+    }
+
+    /// Store and restore the gauge field
+    void field_push() { foralldir(dir) gauge_store[dir] = gauge.gauge[dir]; }
+    void field_pop() { foralldir(dir) gauge.gauge[dir] = gauge_store[dir]; }
+
+    /// Update the gauge field with momentum
+    void field_update(double eps) { gauge.gauge_update(eps); }
+
+    /// Nothing to report, defined for both bases
+    void trajectory_report() {}
 };
 
 /// The Wilson plaquette action of a gauge field.
@@ -56,6 +56,8 @@ void update_hmc(integrator_type &integrator, int steps, double traj_length) {
             << " exp(-dS) " << edS << ". Acceptance " << accepted << "/" << trajectory
             << " " << (double)accepted / (double)trajectory << "\n";
 
+    integrator.trajectory_report();
+
     gettimeofday(&end, NULL);
     timing = (double)(end.tv_sec - start.tv_sec) + 1e-6 * (end.tv_usec - start.tv_usec);
 
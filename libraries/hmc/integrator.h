@@ -3,6 +3,10 @@
 
 #include <sys/time.h>
 #include <ctime>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
 
 /// Define the standard action term class.
 /// Action terms are used in the HMC algorithm and
@@ -26,6 +30,9 @@ class action_base {
 
     /// Restore the previous backup
     virtual void restore_backup() {}
+
+    /// Print statistics collected during the trajectory
+    virtual void trajectory_report() {}
 };
 
 /// Represents a sum of two action terms. Useful for adding them
@@ -69,6 +76,12 @@ class action_sum : public action_base {
         a1.restore_backup();
         a2.restore_backup();
     }
+
+    /// Print statistics collected during the trajectory
+    void trajectory_report() {
+        a1.trajectory_report();
+        a2.trajectory_report();
+    }
 };
 
 /// Sum operator for creating an action_sum object
@@ -101,6 +114,34 @@ class integrator_base {
 
     /// Run a lower level integrator step
     virtual void step(double eps) {}
+
+    /* The following are needed by the force gradient integrator and force
+       monitoring.  They are implemented by the lowest level (momentum action)
+       and passed down by the levels above it. */
+
+    /// Store the momentum and set it to zero
+    virtual void momentum_push() {}
+
+    /// Restore the stored momentum, adding scale * current momentum
+    virtual void momentum_pop(double scale) {}
+
+    /// rms over links and max of the norm of the momentum
+    virtual void momentum_norm(double &rms, double &max) {
+        rms = max = 0;
+    }
+
+    /// Store and restore the fields updated by the momentum
+    virtual void field_push() {}
+    virtual void field_pop() {}
+
+    /// Update the fields with the momentum, without running lower levels
+    virtual void field_update(double eps) {}
+
+    /// Print the force statistics of this level and all levels below
+    virtual void force_report() {}
+
+    /// Print statistics of the action terms collected during the trajectory
+    virtual void trajectory_report() {}
 };
 
 /// Build integrator hierarchically by adding a force step on
@@ -142,11 +183,83 @@ class action_term_integrator : public integrator_base {
         lower_integrator.restore_backup();
     }
 
-    /// Update the momentum with the gauge field
-    void force_step(double eps) { action_term.force_step(eps); }
+    /// Update the momentum with the gauge field.  When the force is monitored,
+    /// it is evaluated on zero momentum first and then added with eps
+    void force_step(double eps) {
+        if (!monitor) {
+            action_term.force_step(eps);
+        } else {
+            lower_integrator.momentum_push();
+            action_term.force_step(1.0);
+            record_force(eps);
+            lower_integrator.momentum_pop(eps);
+        }
+    }
 
     /// Update the gauge field with momentum
     void momentum_step(double eps) { lower_integrator.step(eps); }
+
+    /// Force gradient update P += eps F(U'), where U' = exp(shift F(U)) U.
+    /// This is the Hessian-free form of the force gradient term (Yin & Mawhinney)
+    void force_gradient_step(double eps, double shift) {
+        lower_integrator.momentum_push();
+        action_term.force_step(1.0);
+        if (monitor)
+            record_force(eps);
+        lower_integrator.field_push();
+        lower_integrator.field_update(shift);
+        lower_integrator.momentum_pop(0.0);
+        action_term.force_step(eps);
+        lower_integrator.field_pop();
+    }
+
+    /// Pass down to the momentum action
+    void momentum_push() { lower_integrator.momentum_push(); }
+    void momentum_pop(double scale) { lower_integrator.momentum_pop(scale); }
+    void momentum_norm(double &rms, double &max) { lower_integrator.momentum_norm(rms, max); }
+    void field_push() { lower_integrator.field_push(); }
+    void field_pop() { lower_integrator.field_pop(); }
+    void field_update(double eps) { lower_integrator.field_update(eps); }
+
+    /// Monitor the force of this level, reported by force_report() with the label
+    void monitor_force(const std::string &name) {
+        monitor = true;
+        label = name;
+    }
+
+    /// Print the force statistics of this level and all levels below.
+    /// eps|F| is the size of the momentum update, useful for tuning the step sizes
+    void force_report() {
+        if (monitor && n_force > 0) {
+            hila::out0 << "FORCE " << label << ": " << n_force << " evaluations, |F| rms "
+                       << sum_rms / n_force << " max " << max_norm << ", eps|F| rms "
+                       << sum_eps_rms / n_force << " max " << max_eps_norm << '\n';
+        }
+        lower_integrator.force_report();
+    }
+
+    /// Print statistics of the action terms collected during the trajectory
+    void trajectory_report() {
+        action_term.trajectory_report();
+        lower_integrator.trajectory_report();
+    }
+
+  private:
+    bool monitor = false;
+    std::string label;
+    int64_t n_force = 0;
+    double sum_rms = 0, sum_eps_rms = 0, max_norm = 0, max_eps_norm = 0;
+
+    // the force is in the momentum now
+    void record_force(double eps) {
+        double rms, max;
+        lower_integrator.momentum_norm(rms, max);
+        n_force++;
+        sum_rms += rms;
+        sum_eps_rms += std::abs(eps) * rms;
+        max_norm = std::max(max_norm, max);
+        max_eps_norm = std::max(max_eps_norm, std::abs(eps) * max);
+    }
 };
 
 /// Define an integration step for a Molecular Dynamics
@@ -197,4 +310,146 @@ class O2_integrator : public action_term_integrator {
     }
 };
 
+/// 4th order Omelyan-Mryglod-Folk integrator (OMF4), 5 force evaluations per step.
+/// Coefficients from Omelyan, Mryglod and Folk, Comput. Phys. Commun. 151 (2003) 272
+class O4_integrator : public action_term_integrator {
+  public:
+    int n = 1;
+
+    O4_integrator(action_base &a, integrator_base &i, int steps)
+        : action_term_integrator(a, i), n(steps) {}
+    O4_integrator(action_base &a, integrator_base &i) : action_term_integrator(a, i) {}
+
+    // Run the integrator update
+    void step(double eps) {
+        constexpr double r1 = 0.08398315262876693;
+        constexpr double r2 = 0.2539785108410595;
+        constexpr double r3 = 0.6822365335719091;
+        constexpr double r4 = -0.03230286765269967;
+
+        force_step(r1 * eps);
+        lower_steps(r2 * eps);
+        force_step(r3 * eps);
+        lower_steps(r4 * eps);
+        force_step((0.5 - r1 - r3) * eps);
+        lower_steps((1 - 2 * (r2 + r4)) * eps);
+        force_step((0.5 - r1 - r3) * eps);
+        lower_steps(r4 * eps);
+        force_step(r3 * eps);
+        lower_steps(r2 * eps);
+        force_step(r1 * eps);
+    }
+
+  private:
+    void lower_steps(double eps) {
+        for (int i = 0; i < n; i++)
+            this->lower_integrator.step(eps / n);
+    }
+};
+
+/// 4th order force gradient integrator (Omelyan / Chin), 3 force evaluations
+/// and one force gradient per step:
+///     F(eps/6) L(eps/2) FG(2eps/3) L(eps/2) F(eps/6)
+/// The force gradient term is evaluated without the Hessian, with one extra
+/// force evaluation on the gauge field shifted by eps^2/24 F.  Only the fields
+/// updated by the momentum action may enter the force of this level
+class force_gradient_integrator : public action_term_integrator {
+  public:
+    int n = 1;
+
+    force_gradient_integrator(action_base &a, integrator_base &i, int steps)
+        : action_term_integrator(a, i), n(steps) {}
+    force_gradient_integrator(action_base &a, integrator_base &i)
+        : action_term_integrator(a, i) {}
+
+    // Run the integrator update
+    void step(double eps) {
+        constexpr double lambda = 2.0 / 3.0;
+        constexpr double xi = 1.0 / 72.0;
+
+        force_step(eps / 6);
+        for (int i = 0; i < n; i++)
+            this->lower_integrator.step(0.5 * eps / n);
+        force_gradient_step(lambda * eps, 2 * xi * eps * eps / lambda);
+        for (int i = 0; i < n; i++)
+            this->lower_integrator.step(0.5 * eps / n);
+        force_step(eps / 6);
+    }
+};
+
+/// The integration schemes available in multiscale_integrator
+enum class integrator_scheme { leapfrog, O2, O4, force_gradient };
+
+/// Compose a nested multiple time scale integrator level by level:
+///
+///     gauge_momentum_action ma(gauge);
+///     multiscale_integrator integrator(ma);
+///     integrator.add_level(ga, integrator_scheme::O4, 1);
+///     integrator.add_level(fa1, integrator_scheme::force_gradient, 4);
+///     integrator.add_level(fa2, integrator_scheme::force_gradient, 2);
+///     integrator.monitor_forces();
+///     ...
+///     update_hmc(integrator, hmc_steps, traj_length);
+///     integrator.force_report();
+///
+/// Each new level is on top of the previous one and takes the given number
+/// of lower level steps per each of its own substeps.  The top level action
+/// should be the most expensive one with the smallest force.
+class multiscale_integrator : public integrator_base {
+  private:
+    integrator_base &bottom;
+    std::vector<std::unique_ptr<action_term_integrator>> levels;
+
+    integrator_base &top() {
+        if (levels.size() == 0)
+            return bottom;
+        return *levels.back();
+    }
+
+  public:
+    /// Construct on top of the momentum action
+    multiscale_integrator(integrator_base &momentum_action) : bottom(momentum_action) {}
+
+    /// Add a level with action term a on top of the current levels
+    action_term_integrator &add_level(action_base &a, integrator_scheme scheme, int steps = 1) {
+        integrator_base &lower = top();
+        switch (scheme) {
+        case integrator_scheme::leapfrog:
+            levels.emplace_back(new leapfrog_integrator(a, lower, steps));
+            break;
+        case integrator_scheme::O2:
+            levels.emplace_back(new O2_integrator(a, lower, steps));
+            break;
+        case integrator_scheme::O4:
+            levels.emplace_back(new O4_integrator(a, lower, steps));
+            break;
+        case integrator_scheme::force_gradient:
+            levels.emplace_back(new force_gradient_integrator(a, lower, steps));
+            break;
+        }
+        return *levels.back();
+    }
+
+    /// Monitor the forces of all levels, labeled "level 1" (lowest) and up
+    void monitor_forces() {
+        for (int i = 0; i < levels.size(); i++)
+            levels[i]->monitor_force("level " + std::to_string(i + 1));
+    }
+
+    double action() { return top().action(); }
+    void draw_gaussian_fields() { top().draw_gaussian_fields(); }
+    void backup_fields() { top().backup_fields(); }
+    void restore_backup() { top().restore_backup(); }
+    void force_step(double eps) { top().force_step(eps); }
+    void step(double eps) { top().step(eps); }
+    void momentum_push() { bottom.momentum_push(); }
+    void momentum_pop(double scale) { bottom.momentum_pop(scale); }
+    void momentum_norm(double &rms, double &max) { bottom.momentum_norm(rms, max); }
+    void field_push() { bottom.field_push(); }
+    void field_pop() { bottom.field_pop(); }
+    void field_update(double eps) { bottom.field_update(eps); }
+    void force_report() { top().force_report(); }
+    void trajectory_report() { top().trajectory_report(); }
+};
+
 #endif
@@ -22,7 +22,18 @@
 #%   EVEN_SITES_FIRST=0      - store sites in logical "typewriter" order, mixing EVEN and ODD
 #%         sites. Default layout stores even lattice sites first, enabling efficient
 #%         looping over parities (EVEN/ODD).
+#%   TILED_LAYOUT=<n>        - store the sites of each rank in tiles of n^NDIM sites
+#%         (needs EVEN_SITES_FIRST).  Experimental, speedup not measured
 #%   NO_INTERLEAVE=1         - turn off compute during MPI communications (default: on)
+#%   LOOP_PROFILE=1          - time every site loop, report hot loops at the end of the run
+#%   LOOP_FUSION=1           - fuse consecutive compatible site loops (default: off).  Changes
+#%         the order of random number calls, not bit-reproducible against unfused code
+#%   FIELD_EXPRESSIONS=1     - evaluate whole-Field arithmetic lazily in one site loop on cpu
+#%         (default: off).  Then 'auto x = f + g;' refers to f and g, it is not a Field
+#%   DIRECTION_ANALYSIS=1    - gather only the reachable directions of loop local direction
+#%         refs, e.g. U[d][X + d] in foralldir(d) (default: off, all directions)
+#%   SPLIT_SITE_LOOPS=1      - loops waiting for gathers run the interior sites in blocks
+#%         and the boundary sites from a list (default: off, per-site mask test)
 #% GPU-relevant options:
 #%   GPU_AWARE_MPI=0         - turn off GPU aware MPI (default: on) 
 #%   GPU_SYNCHRONIZE_TIMERS=1 - Synchronize timers with GPU kernels.
@@ -94,9 +105,13 @@ HILA_OBJECTS = \
 	build/lattice.o \
 	build/map_node_layout.o \
 	build/memalloc.o \
+	build/host_memory_pool.o \
 	build/timing.o \
+	build/loop_profile.o \
+	build/event_trace.o \
 	build/test_gathers.o \
 	build/com_mpi.o \
+	build/com_shm.o \
 	build/fft.o
 
 # Remvoved com_simple.o, require MPI
@@ -122,7 +137,7 @@ endif
 
 # To force a full remake when changing platforms or targets
 CLEANED_GOALS := $(shell echo ${MAKECMDGOALS} | sed -e 's/ /_/g' -e 's/\//+/g' | cut -c1-60)
-LASTMAKE := build/.lastmake.${CLEANED_GOALS}.${ARCH}
+LASTMAKE := build/.lastmake.${CLEANED_GOALS}.${ARCH}$(if $(TILED_LAYOUT),.tiled$(TILED_LAYOUT))
 
 $(LASTMAKE): $(MAKEFILE_LIST)
 	@mkdir -p build
@@ -137,6 +152,10 @@ HILA_OPTS += -DEVEN_SITES_FIRST=0
 endif
 endif
 
+ifdef TILED_LAYOUT
+HILA_OPTS += -DTILED_LAYOUT=$(TILED_LAYOUT)
+endif
+
 ifdef NO_INTERLEAVE
 HILAPP_OPTS += --no-interleave
 endif
@@ -145,6 +164,26 @@ ifdef GPU_SYNCHRONIZE_TIMERS
 HILA_OPTS += -DGPU_SYNCHRONIZE_TIMERS
 endif
 
+ifdef LOOP_PROFILE
+HILAPP_OPTS += -loop-profile
+endif
+
+ifdef LOOP_FUSION
+HILAPP_OPTS += -loop-fusion
+endif
+
+ifdef FIELD_EXPRESSIONS
+HILA_OPTS += -DFIELD_EXPRESSIONS
+endif
+
+ifdef DIRECTION_ANALYSIS
+HILAPP_OPTS += -direction-analysis
+endif
+
+ifdef SPLIT_SITE_LOOPS
+HILAPP_OPTS += -split-site-loops
+endif
+
 ifdef GPU_AWARE_MPI
 ifeq (GPU_AWARE_MPI,0)
 HILA_OPTS += -DGPU_AWARE_MPI=0
@@ -20,7 +20,7 @@ inline void field_storage<T>::set(const T &value, const unsigned i,
 
 template <typename T>
 void field_storage<T>::allocate_field(const lattice_struct &lattice) {
-    fieldbuf = (T *)memalloc(sizeof(T) * lattice.field_alloc_size());
+    fieldbuf = (T *)host_memory_pool_alloc(sizeof(T) * lattice.field_alloc_size());
     if (fieldbuf == nullptr) {
         std::cout << "Failure in Field memory allocation\n";
         exit(1);
@@ -32,7 +32,7 @@ template <typename T>
 void field_storage<T>::free_field() {
 #pragma acc exit data delete (fieldbuf)
     if (fieldbuf != nullptr)
-        free(fieldbuf);
+        host_memory_pool_free(fieldbuf);
     fieldbuf = nullptr;
 }
 
@@ -135,12 +135,12 @@ inline void field_storage<T>::set_element(A &value, const unsigned i,
 
 template <typename T>
 void field_storage<T>::free_mpi_buffer(T *buffer) {
-    std::free(buffer);
+    host_memory_pool_free(buffer);
 }
 
 template <typename T>
 T *field_storage<T>::allocate_mpi_buffer(unsigned n) {
-    return (T *)memalloc(n * sizeof(T));
+    return (T *)host_memory_pool_alloc(n * sizeof(T));
 }
 
 #endif
@@ -194,20 +194,19 @@ template <typename cmplx_t>
 void hila_fft<cmplx_t>::transform() {
 
     // these externs defined in fft.cpp
-    extern unsigned hila_fft_my_columns[NDIM];
     extern hila::timer fft_execute_timer, fft_buffer_timer;
     extern hila_saved_fftplan_t hila_saved_fftplan;
 
     constexpr bool is_float = (sizeof(cmplx_t) == sizeof(Complex<float>));
 
-    int n_columns = hila_fft_my_columns[dir] * elements;
+    int n_columns = my_columns[dir] * elements;
 
     int direction = (fftdir == fft_direction::forward) ? GPUFFT_FORWARD : GPUFFT_INVERSE;
 
     // allocate here fftw plans.  TODO: perhaps store, if plans take appreciable time?
     // Timer will tell the proportional timing
 
-    int batch = hila_fft_my_columns[dir];
+    int batch = my_columns[dir];
     int n_fft = elements;
     // reduce very large batch to smaller, avoid large buffer space
 
@@ -299,7 +298,7 @@ void hila_fft<cmplx_t>::gather_data() {
     pencil_MPI_timer.start();
 
     // post receive and send
-    int n_comms = hila_pencil_comms[dir].size() - 1;
+    int n_comms = pencil_comms[dir].size() - 1;
 
     std::vector<MPI_Request> sendreq(n_comms), recreq(n_comms);
     std::vector<MPI_Status> stat(n_comms);
@@ -318,7 +317,7 @@ void hila_fft<cmplx_t>::gather_data() {
     size_t mpi_type_size;
     MPI_Datatype mpi_type = get_MPI_complex_type<cmplx_t>(mpi_type_size);
 
-    for (auto &fn : hila_pencil_comms[dir]) {
+    for (auto &fn : pencil_comms[dir]) {
         if (fn.node != hila::myrank()) {
 
             size_t siz = fn.recv_buf_size * elements * sizeof(cmplx_t);
@@ -343,7 +342,7 @@ void hila_fft<cmplx_t>::gather_data() {
     }
 
     i = 0;
-    for (auto &fn : hila_pencil_comms[dir]) {
+    for (auto &fn : pencil_comms[dir]) {
         if (fn.node != hila::myrank()) {
 
             cmplx_t *p = send_buf + fn.column_offset * elements;
@@ -370,7 +369,7 @@ void hila_fft<cmplx_t>::gather_data() {
 #ifndef GPU_AWARE_MPI
         i = j = 0;
 
-        for (auto &fn : hila_pencil_comms[dir]) {
+        for (auto &fn : pencil_comms[dir]) {
             if (fn.node != hila::myrank()) {
 
                 size_t siz = fn.recv_buf_size * elements;
@@ -401,7 +400,7 @@ void hila_fft<cmplx_t>::scatter_data() {
     extern hila::timer pencil_MPI_timer;
     pencil_MPI_timer.start();
 
-    int n_comms = hila_pencil_comms[dir].size() - 1;
+    int n_comms = pencil_comms[dir].size() - 1;
 
     std::vector<MPI_Request> sendreq(n_comms), recreq(n_comms);
     std::vector<MPI_Status> stat(n_comms);
@@ -418,7 +417,7 @@ void hila_fft<cmplx_t>::scatter_data() {
 
     gpuStreamSynchronize(0);
 
-    for (auto &fn : hila_pencil_comms[dir]) {
+    for (auto &fn : pencil_comms[dir]) {
         if (fn.node != hila::myrank()) {
 
             size_t n = fn.column_number * elements * lattice.mynode.size[dir] * sizeof(cmplx_t);
@@ -437,7 +436,7 @@ void hila_fft<cmplx_t>::scatter_data() {
 
     i = 0;
     int j = 0;
-    for (auto &fn : hila_pencil_comms[dir]) {
+    for (auto &fn : pencil_comms[dir]) {
         if (fn.node != hila::myrank()) {
 
             size_t n = fn.recv_buf_size * elements * sizeof(cmplx_t);
@@ -463,7 +462,7 @@ void hila_fft<cmplx_t>::scatter_data() {
 
 #ifndef GPU_AWARE_MPI
         i = 0;
-        for (auto &fn : hila_pencil_comms[dir]) {
+        for (auto &fn : pencil_comms[dir]) {
             if (fn.node != hila::myrank()) {
 
                 size_t n = fn.column_number * elements * lattice.mynode.size[dir] * sizeof(cmplx_t);
@@ -516,11 +515,10 @@ template <typename cmplx_t>
 void hila_fft<cmplx_t>::reflect() {
 
     // these externs defined in fft.cpp
-    extern unsigned hila_fft_my_columns[NDIM];
 
     constexpr bool is_float = (sizeof(cmplx_t) == sizeof(Complex<float>));
 
-    int n_columns = hila_fft_my_columns[dir] * elements;
+    int n_columns = my_columns[dir] * elements;
 
     // reduce very large batch to smaller, avoid large buffer space
 
@@ -34,6 +34,13 @@ static_assert(0 && "EVEN_SITES_FIRST must be defined for vectorized code");
 #define VECTOR_SIZE 32
 #endif
 
+// With OPENMP the gathers and placements of field elements are split to threads
+// only if there are at least this many elements - below that starting the threads
+// costs more than it gains
+#ifndef VECTOR_OMP_MIN_ELEMENTS
+#define VECTOR_OMP_MIN_ELEMENTS 4096
+#endif
+
 namespace hila {
 
 // Trivial synchronization
@@ -377,6 +384,102 @@ inline Vec4i operator%(const Vec4i &lhs, const int &rhs) {
 }
 
 // Random numbers
+// In vectorized site loops each lane gets random numbers from its own site, using the
+// per-site generator (implemented in random.cpp).  These overloads are picked up by
+// hila::random(T &) and hila::gaussian_random(T &, double) in random.h, and thus by the
+// random() and gaussian_random() methods of hila types with vector elements.
+
+namespace hila {
+
+void site_random_lanes(double *out, int lanes);
+void site_gaussrand_lanes(double *out, int lanes);
+void site_gaussrand2_lanes(double *out, double *out2, int lanes);
+
+template <typename Vec>
+inline Vec &random_vector_lanes(Vec &v) {
+    using base_t = typename avx_vector_type_info<Vec>::type;
+    constexpr int lanes = avx_vector_type_info<Vec>::elements;
+    double t[lanes];
+    base_t b[lanes];
+    site_random_lanes(t, lanes);
+    for (int i = 0; i < lanes; i++)
+        b[i] = t[i];
+    v.load(b);
+    return v;
+}
+
+template <typename Vec>
+inline Vec &gaussian_random_vector_lanes(Vec &v, double width) {
+    using base_t = typename avx_vector_type_info<Vec>::type;
+    constexpr int lanes = avx_vector_type_info<Vec>::elements;
+    double t[lanes];
+    base_t b[lanes];
+    site_gaussrand_lanes(t, lanes);
+    for (int i = 0; i < lanes; i++)
+        b[i] = t[i] * width;
+    v.load(b);
+    return v;
+}
+
+template <typename Vec>
+inline Vec gaussrand2_vector_lanes(Vec &out2) {
+    using base_t = typename avx_vector_type_info<Vec>::type;
+    constexpr int lanes = avx_vector_type_info<Vec>::elements;
+    double t[lanes], t2[lanes];
+    base_t b[lanes];
+    Vec v;
+    site_gaussrand2_lanes(t, t2, lanes);
+    for (int i = 0; i < lanes; i++)
+        b[i] = t[i];
+    v.load(b);
+    for (int i = 0; i < lanes; i++)
+        b[i] = t2[i];
+    out2.load(b);
+    return v;
+}
+
+inline Vec4d &random(Vec4d &v) {
+    return random_vector_lanes(v);
+}
+inline Vec8d &random(Vec8d &v) {
+    return random_vector_lanes(v);
+}
+inline Vec8f &random(Vec8f &v) {
+    return random_vector_lanes(v);
+}
+inline Vec16f &random(Vec16f &v) {
+    return random_vector_lanes(v);
+}
+
+inline Vec4d &gaussian_random(Vec4d &v, double width = 1.0) {
+    return gaussian_random_vector_lanes(v, width);
+}
+inline Vec8d &gaussian_random(Vec8d &v, double width = 1.0) {
+    return gaussian_random_vector_lanes(v, width);
+}
+inline Vec8f &gaussian_random(Vec8f &v, double width = 1.0) {
+    return gaussian_random_vector_lanes(v, width);
+}
+inline Vec16f &gaussian_random(Vec16f &v, double width = 1.0) {
+    return gaussian_random_vector_lanes(v, width);
+}
+
+inline Vec4d gaussrand2(Vec4d &out2) {
+    return gaussrand2_vector_lanes(out2);
+}
+inline Vec8d gaussrand2(Vec8d &out2) {
+    return gaussrand2_vector_lanes(out2);
+}
+inline Vec8f gaussrand2(Vec8f &out2) {
+    return gaussrand2_vector_lanes(out2);
+}
+inline Vec16f gaussrand2(Vec16f &out2) {
+    return gaussrand2_vector_lanes(out2);
+}
+
+} // namespace hila
+
+// Old mersenne-based vector random numbers
 // Since you cannot specialize by return type,
 // it needs to be a struct...
 
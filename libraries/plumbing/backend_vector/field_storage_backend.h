@@ -64,12 +64,12 @@ using vector_type = typename vectorize_struct<T, hila::vector_info<T>::vector_si
 template <typename T>
 void field_storage<T>::allocate_field(const lattice_struct &lattice) {
     if constexpr (hila::is_vectorizable_type<T>::value) {
-        fieldbuf = (T *)memalloc(
+        fieldbuf = (T *)host_memory_pool_alloc(
             lattice.backend_lattice->get_vectorized_lattice<hila::vector_info<T>::vector_size>()
                 ->field_alloc_size() *
             sizeof(T));
     } else {
-        fieldbuf = (T *)memalloc(sizeof(T) * lattice.field_alloc_size());
+        fieldbuf = (T *)host_memory_pool_alloc(sizeof(T) * lattice.field_alloc_size());
     }
 }
 
@@ -77,7 +77,7 @@ template <typename T>
 void field_storage<T>::free_field() {
 #pragma acc exit data delete (fieldbuf)
     if (fieldbuf != nullptr)
-        free(fieldbuf);
+        host_memory_pool_free(fieldbuf);
     fieldbuf = nullptr;
 }
 
@@ -172,6 +172,7 @@ template <typename T>
 void field_storage<T>::gather_elements(T *RESTRICT buffer, const unsigned *RESTRICT index_list,
                                        int n, const lattice_struct &lattice) const {
 
+#pragma omp parallel for if (n >= VECTOR_OMP_MIN_ELEMENTS)
     for (unsigned j = 0; j < n; j++) {
         buffer[j] = get_element(index_list[j]);
     }
@@ -184,6 +185,7 @@ void field_storage<T>::gather_elements_negated(T *RESTRICT buffer,
                                                const unsigned *RESTRICT index_list, int n,
                                                const lattice_struct &lattice) const {
     if constexpr (hila::has_unary_minus<T>::value) {
+#pragma omp parallel for if (n >= VECTOR_OMP_MIN_ELEMENTS)
         for (unsigned j = 0; j < n; j++) {
             buffer[j] = -get_element(index_list[j]); /// requires unary - !!
         }
@@ -200,6 +202,7 @@ void field_storage<T>::gather_elements_negated(T *RESTRICT buffer,
 template <typename T>
 void field_storage<T>::place_elements(T *RESTRICT buffer, const unsigned *RESTRICT index_list,
                                       int n, const lattice_struct &lattice) {
+#pragma omp parallel for if (n >= VECTOR_OMP_MIN_ELEMENTS)
     for (unsigned j = 0; j < n; j++) {
         set_element(buffer[j], index_list[j]);
     }
@@ -251,6 +254,7 @@ void field_storage<T>::set_local_boundary_elements(Direction dir, Parity par,
                 const int *RESTRICT perm = vector_lattice->boundary_permutation[dir];
 
                 basetype *fp = static_cast<basetype *>(static_cast<void *>(fieldbuf));
+#pragma omp parallel for if ((end - start) * vector_size >= VECTOR_OMP_MIN_ELEMENTS)
                 for (unsigned idx = start; idx < end; idx++) {
                     /// get ptrs to target and source vec elements
                     basetype *RESTRICT t = fp + (idx + offset) * (elements * vector_size);
@@ -274,6 +278,7 @@ void field_storage<T>::set_local_boundary_elements(Direction dir, Parity par,
                 //  (int)antiperiodic << '\n';
                 if (!antiperiodic) {
                     // no boundary permutation, straight copy for all vectors
+#pragma omp parallel for if ((end - start) * vector_size >= VECTOR_OMP_MIN_ELEMENTS)
                     for (unsigned idx = start; idx < end; idx++) {
                         std::memcpy(fieldbuf + (idx + offset) * vector_size,
                                     fieldbuf + vector_lattice->halo_index[dir][idx] * vector_size,
@@ -282,6 +287,7 @@ void field_storage<T>::set_local_boundary_elements(Direction dir, Parity par,
                 } else {
 #ifdef SPECIAL_BOUNDARY_CONDITIONS
                     basetype *fp = static_cast<basetype *>(static_cast<void *>(fieldbuf));
+#pragma omp parallel for if ((end - start) * vector_size >= VECTOR_OMP_MIN_ELEMENTS)
                     for (unsigned idx = start; idx < end; idx++) {
                         /// get ptrs to target and source vec elements
                         basetype *RESTRICT t = fp + (idx + offset) * (elements * vector_size);
@@ -340,6 +346,7 @@ void field_storage<T>::gather_comm_vectors(
     assert(n % vector_size == 0);
 
     if (!antiperiodic) {
+#pragma omp parallel for if (n >= VECTOR_OMP_MIN_ELEMENTS)
         for (unsigned i = 0; i < n; i += vector_size) {
             std::memcpy(buffer + i, fieldbuf + index_list[i], sizeof(T) * vector_size);
 
@@ -349,6 +356,7 @@ void field_storage<T>::gather_comm_vectors(
         }
     } else {
         // copy this as elements
+#pragma omp parallel for if (n >= VECTOR_OMP_MIN_ELEMENTS)
         for (unsigned i = 0; i < n; i += vector_size) {
             basetype *RESTRICT t = static_cast<basetype *>(static_cast<void *>(buffer + i));
             basetype *RESTRICT s =
@@ -380,6 +388,7 @@ void field_storage<T>::place_recv_elements(
     // changed
     T *targetbuf = const_cast<T *>(fieldbuf);
 
+#pragma omp parallel for if (n >= VECTOR_OMP_MIN_ELEMENTS)
     for (unsigned i = 0; i < n; i++) {
         unsigned idx = vlat->recv_list[d][i + start];
 
@@ -395,12 +404,12 @@ void field_storage<T>::place_recv_elements(
 
 template <typename T>
 void field_storage<T>::free_mpi_buffer(T *buffer) {
-    std::free(buffer);
+    host_memory_pool_free(buffer);
 }
 
 template <typename T>
 T *field_storage<T>::allocate_mpi_buffer(unsigned n) {
-    return (T *)memalloc(n * sizeof(T));
+    return (T *)host_memory_pool_alloc(n * sizeof(T));
 }
 
 #endif
\ No newline at end of file
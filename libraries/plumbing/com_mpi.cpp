@@ -3,21 +3,22 @@
 #include "plumbing/lattice.h"
 #include "plumbing/field.h"
 #include "plumbing/com_mpi.h"
+#include "plumbing/com_shm.h"
 #include "plumbing/timing.h"
 
 // declare MPI timers here too - these were externs
 
-hila::timer start_send_timer("MPI start send");
-hila::timer wait_send_timer("MPI wait send");
-hila::timer post_receive_timer("MPI post receive");
-hila::timer wait_receive_timer("MPI wait receive");
-hila::timer synchronize_timer("MPI synchronize");
-hila::timer reduction_timer("MPI reduction");
-hila::timer reduction_wait_timer("MPI reduction wait");
-hila::timer broadcast_timer("MPI broadcast");
-hila::timer send_timer("MPI send field");
-hila::timer drop_comms_timer("MPI wait drop_comms");
-hila::timer partition_sync_timer("partition sync");
+hila::timer start_send_timer("MPI start send", true);
+hila::timer wait_send_timer("MPI wait send", true);
+hila::timer post_receive_timer("MPI post receive", true);
+hila::timer wait_receive_timer("MPI wait receive", true);
+hila::timer synchronize_timer("MPI synchronize", true);
+hila::timer reduction_timer("MPI reduction", true);
+hila::timer reduction_wait_timer("MPI reduction wait", true);
+hila::timer broadcast_timer("MPI broadcast", true);
+hila::timer send_timer("MPI send field", true);
+hila::timer drop_comms_timer("MPI wait drop_comms", true);
+hila::timer partition_sync_timer("partition sync", true);
 
 // let us house the partitions-struct here
 
@@ -190,6 +191,7 @@ void hila::finish_communications() {
     mpi_initialized = false;
     hila::about_to_finish = true;
 
+    hila::shm::finish();
     MPI_Finalize();
 }
 
@@ -0,0 +1,327 @@
+///////////////////////////////////////////
+/// com_shm.cpp - intra-node halo exchange through MPI-3 shared windows
+
+#include "plumbing/defs.h"
+#include "plumbing/lattice.h"
+#include "plumbing/com_mpi.h"
+#include "plumbing/com_shm.h"
+#include "plumbing/timing.h"
+#include <atomic>
+#include <map>
+#include <vector>
+#include <cstring>
+
+hila::timer shm_post_timer("shm halo post", true);
+hila::timer shm_wait_send_timer("shm halo wait send", true);
+hila::timer shm_wait_receive_timer("shm halo wait receive", true);
+
+#if defined(SHM_HALO_EXCHANGE)
+
+/// Mailbox slot, lives in the window of the sender.  The sender writes 'posted',
+/// the receiver 'consumed'.  Both contain the message number + 1, the slot is free
+/// when they are equal.
+struct shm_mailbox_slot {
+    std::atomic<int64_t> posted;
+    std::atomic<int64_t> consumed;
+    size_t offset; // of the buffer from the start of the arena
+    size_t bytes;
+    int tag;
+};
+
+static_assert(std::atomic<int64_t>::is_always_lock_free,
+              "shm halo exchange needs lock-free 64-bit atomics");
+
+// control area is rounded to page size, arena follows
+static constexpr size_t shm_control_size =
+    ((NDIRS * SHM_HALO_SLOTS * sizeof(shm_mailbox_slot) + 4095) / 4096) * 4096;
+static constexpr size_t shm_arena_size = ((size_t)SHM_HALO_BUFFER_MB) * 1024 * 1024;
+static constexpr size_t shm_alignment = 256;
+
+static bool shm_initialized = false;
+static MPI_Comm node_comm = MPI_COMM_NULL;
+static MPI_Win window = MPI_WIN_NULL;
+
+// start of the window of each rank in lattice.mpi_comm_lat, nullptr if not on node
+static std::vector<char *> segment;
+static char *my_arena = nullptr;
+
+// arena bookkeeping: offset -> size
+static std::map<size_t, size_t> free_blocks;
+static std::map<size_t, size_t> used_blocks;
+
+// running message numbers for each direction
+static int64_t send_seq[NDIRS];
+static int64_t recv_seq[NDIRS];
+
+static inline shm_mailbox_slot &mailbox(char *seg, int d, int64_t seq) {
+    return reinterpret_cast<shm_mailbox_slot *>(seg)[d * SHM_HALO_SLOTS + seq % SHM_HALO_SLOTS];
+}
+
+/// Spin until ready() is true.  Keep MPI progressing meanwhile, there may be
+/// inter-node messages which the other ranks are waiting for
+template <typename F>
+static void spin_wait(F ready) {
+    int count = 0;
+    while (!ready()) {
+        if (++count % 1024 == 0) {
+            int flag;
+            MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, lattice.mpi_comm_lat, &flag,
+                       MPI_STATUS_IGNORE);
+        }
+    }
+}
+
+void hila::shm::initialize() {
+    if (shm_initialized || hila::check_input)
+        return;
+    shm_initialized = true;
+
+    MPI_Comm_split_type(lattice.mpi_comm_lat, MPI_COMM_TYPE_SHARED, hila::myrank(),
+                        MPI_INFO_NULL, &node_comm);
+
+    int node_size, node_rank;
+    MPI_Comm_size(node_comm, &node_size);
+    MPI_Comm_rank(node_comm, &node_rank);
+
+    segment.assign(hila::number_of_nodes(), nullptr);
+
+    // do not bother if everybody is alone on the node
+    int shared = (node_size > 1) ? 1 : 0;
+    if (hila::reduce_node_sum(shared) == 0) {
+        MPI_Comm_free(&node_comm);
+        node_comm = MPI_COMM_NULL;
+        return;
+    }
+
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "alloc_shared_noncontig", "true");
+
+    char *base;
+    MPI_Win_allocate_shared(shm_control_size + shm_arena_size, 1, info, node_comm, &base,
+                            &window);
+    MPI_Info_free(&info);
+
+    for (int i = 0; i < NDIRS * SHM_HALO_SLOTS; i++) {
+        shm_mailbox_slot *s = new (base + i * sizeof(shm_mailbox_slot)) shm_mailbox_slot;
+        s->posted.store(0);
+        s->consumed.store(0);
+    }
+    for (int d = 0; d < NDIRS; d++)
+        send_seq[d] = recv_seq[d] = 0;
+
+    my_arena = base + shm_control_size;
+    free_blocks[0] = shm_arena_size;
+
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+
+    // map the windows of the other ranks on the node
+    MPI_Group node_group, lat_group;
+    MPI_Comm_group(node_comm, &node_group);
+    MPI_Comm_group(lattice.mpi_comm_lat, &lat_group);
+    for (int i = 0; i < node_size; i++) {
+        int lat_rank;
+        MPI_Group_translate_ranks(node_group, 1, &i, lat_group, &lat_rank);
+
+        MPI_Aint size;
+        int disp_unit;
+        char *ptr;
+        MPI_Win_shared_query(window, i, &size, &disp_unit, &ptr);
+        segment[lat_rank] = ptr;
+    }
+    MPI_Group_free(&node_group);
+    MPI_Group_free(&lat_group);
+
+    // mailboxes must be initialized before anybody uses them
+    MPI_Barrier(node_comm);
+
+    hila::out0 << "Intra-node halo exchange through shared memory, " << node_size
+               << " ranks on node 0, buffer " << SHM_HALO_BUFFER_MB << " MB/rank\n";
+}
+
+void hila::shm::finish() {
+    if (window != MPI_WIN_NULL) {
+        MPI_Win_unlock_all(window);
+        MPI_Win_free(&window);
+        window = MPI_WIN_NULL;
+        MPI_Comm_free(&node_comm);
+        node_comm = MPI_COMM_NULL;
+    }
+    my_arena = nullptr;
+    free_blocks.clear();
+    used_blocks.clear();
+    segment.clear();
+}
+
+bool hila::shm::is_on_node(int rank) {
+    return my_arena != nullptr && rank != lattice.mynode.rank && segment[rank] != nullptr;
+}
+
+void *hila::shm::allocate(size_t bytes) {
+    if (my_arena == nullptr)
+        return nullptr;
+
+    bytes = ((bytes + shm_alignment - 1) / shm_alignment) * shm_alignment;
+
+    // first fit
+    for (auto it = free_blocks.begin(); it != free_blocks.end(); ++it) {
+        if (it->second >= bytes) {
+            size_t offset = it->first;
+            size_t remaining = it->second - bytes;
+            free_blocks.erase(it);
+            if (remaining > 0)
+                free_blocks[offset + bytes] = remaining;
+            used_blocks[offset] = bytes;
+            return my_arena + offset;
+        }
+    }
+    return nullptr;
+}
+
+bool hila::shm::deallocate(void *ptr) {
+    char *cp = static_cast<char *>(ptr);
+    if (my_arena == nullptr || cp < my_arena || cp >= my_arena + shm_arena_size)
+        return false;
+
+    auto it = used_blocks.find(cp - my_arena);
+    if (it == used_blocks.end()) {
+        hila::out << "Shared memory halo buffer free error - unknown pointer " << ptr << '\n';
+        hila::terminate(1);
+    }
+
+    size_t offset = it->first, size = it->second;
+    used_blocks.erase(it);
+
+    // merge with the neighbouring free blocks
+    auto next = free_blocks.lower_bound(offset);
+    if (next != free_blocks.end() && offset + size == next->first) {
+        size += next->second;
+        next = free_blocks.erase(next);
+    }
+    if (next != free_blocks.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            prev->second += size;
+            return true;
+        }
+    }
+    free_blocks[offset] = size;
+    return true;
+}
+
+bool hila::shm::post(int d, const void *buffer, size_t bytes, int tag, request &req) {
+
+    const char *cp = static_cast<const char *>(buffer);
+    bool in_arena = (cp >= my_arena && cp < my_arena + shm_arena_size);
+
+    shm_post_timer.start();
+
+    req.seq = send_seq[d]++;
+    req.tag = tag;
+
+    char *my_segment = my_arena - shm_control_size;
+    shm_mailbox_slot &s = mailbox(my_segment, d, req.seq);
+
+    // Never wait here for the slot: the receiver frees it only in wait_gather(), and it
+    // may have more than SHM_HALO_SLOTS gathers started before waiting.  If the
+    // previous message in the slot is not yet consumed, the message goes with MPI and
+    // the slot is left untouched.  The receiver finds it with MPI_Iprobe.
+    req.via_mpi = !in_arena || s.consumed.load(std::memory_order_acquire) !=
+                                   s.posted.load(std::memory_order_relaxed);
+
+    if (!req.via_mpi) {
+        s.offset = cp - my_arena;
+        s.bytes = bytes;
+        s.tag = tag;
+        s.posted.store(req.seq + 1, std::memory_order_release);
+    }
+
+    shm_post_timer.stop();
+
+    return !req.via_mpi;
+}
+
+void hila::shm::wait_sent(int d, const request &req) {
+    if (req.via_mpi)
+        return;
+
+    shm_wait_send_timer.start();
+
+    char *my_segment = my_arena - shm_control_size;
+    shm_mailbox_slot &s = mailbox(my_segment, d, req.seq);
+    spin_wait([&]() { return s.consumed.load(std::memory_order_acquire) > req.seq; });
+
+    shm_wait_send_timer.stop();
+}
+
+void hila::shm::expect(int d, int tag, request &req) {
+    req.seq = recv_seq[d]++;
+    req.tag = tag;
+    req.via_mpi = false;
+}
+
+void hila::shm::receive(int d, int from_rank, void *buffer, size_t bytes, request &req) {
+
+    shm_wait_receive_timer.start();
+
+    // The message is either in the mailbox slot (posted == seq + 1, the slot may still
+    // show an earlier message) or it was sent with MPI.  Tags of ongoing gathers are
+    // unique, so a pending MPI message with our tag from from_rank is this one
+    shm_mailbox_slot &s = mailbox(segment[from_rank], d, req.seq);
+    int count = 0;
+    int flag = 0;
+    while (s.posted.load(std::memory_order_acquire) != req.seq + 1) {
+        if (++count % 64 == 0) {
+            MPI_Iprobe(from_rank, req.tag, lattice.mpi_comm_lat, &flag, MPI_STATUS_IGNORE);
+            if (flag)
+                break;
+        }
+    }
+
+    req.via_mpi = (flag != 0);
+    if (req.via_mpi) {
+        MPI_Recv(buffer, (int)bytes, MPI_BYTE, from_rank, req.tag, lattice.mpi_comm_lat,
+                 MPI_STATUS_IGNORE);
+    } else {
+        if (s.tag != req.tag || s.bytes != bytes) {
+            hila::out << "Shared memory halo exchange out of sync: direction " << d << " tag "
+                      << s.tag << " expected " << req.tag << ", size " << s.bytes
+                      << " expected " << bytes << '\n';
+            hila::terminate(1);
+        }
+        std::memcpy(buffer, segment[from_rank] + shm_control_size + s.offset, bytes);
+        s.consumed.store(req.seq + 1, std::memory_order_release);
+    }
+
+    shm_wait_receive_timer.stop();
+}
+
+#else // now no SHM_HALO_EXCHANGE
+
+void hila::shm::initialize() {}
+
+void hila::shm::finish() {}
+
+bool hila::shm::is_on_node(int rank) {
+    return false;
+}
+
+void *hila::shm::allocate(size_t bytes) {
+    return nullptr;
+}
+
+bool hila::shm::deallocate(void *ptr) {
+    return false;
+}
+
+bool hila::shm::post(int d, const void *buffer, size_t bytes, int tag, request &req) {
+    return false;
+}
+
+void hila::shm::wait_sent(int d, const request &req) {}
+
+void hila::shm::expect(int d, int tag, request &req) {}
+
+void hila::shm::receive(int d, int from_rank, void *buffer, size_t bytes, request &req) {}
+
+#endif // SHM_HALO_EXCHANGE
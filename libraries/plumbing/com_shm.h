@@ -0,0 +1,67 @@
+#ifndef COM_SHM_H
+#define COM_SHM_H
+
+#include "plumbing/defs.h"
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// Intra-node halo exchange through MPI-3 shared memory windows
+///
+/// Ranks on the same node (MPI_Comm_split_type(MPI_COMM_TYPE_SHARED)) allocate a
+/// shared window each.  The window holds a mailbox ring for each direction and an
+/// arena, from which the send buffers of fields going to on-node neighbours are
+/// allocated.  The sender packs the boundary to the send buffer as before and posts
+/// it to the mailbox;  the receiver copies the data directly from the sender's buffer
+/// to the halo and marks the mailbox slot consumed.  No MPI messages are involved.
+///
+/// Gathers from neighbours on other nodes use the standard MPI_Isend/Irecv path.
+/// If the arena is full, or the mailbox slot still holds a message the receiver has
+/// not read (more than SHM_HALO_SLOTS gathers started before waiting), the sender
+/// uses MPI for the message.  The receiver finds it with MPI_Iprobe on the tag.
+///
+/// Turn off with -DSHM_HALO_EXCHANGE=0, see params.h
+//////////////////////////////////////////////////////////////////////////////////////
+
+namespace hila {
+namespace shm {
+
+/// State of a shared memory transfer, the counterpart of MPI_Request
+struct request {
+    int64_t seq;  // running number of the message in the direction
+    int tag;      // MPI tag, used for checking and MPI fallback
+    bool via_mpi; // data was sent with MPI
+};
+
+/// Set up the node communicator and the shared window.  Collective over
+/// lattice.mpi_comm_lat
+void initialize();
+
+/// Free the window, called before MPI_Finalize()
+void finish();
+
+/// Is rank (in lattice.mpi_comm_lat) another rank on this node
+bool is_on_node(int rank);
+
+/// Allocate / free send buffer memory from the shared arena.  allocate() returns
+/// nullptr if there's no space, deallocate() false if ptr is not in the arena
+void *allocate(size_t bytes);
+bool deallocate(void *ptr);
+
+/// Sender: post buffer to direction d mailbox.  Never waits.  Returns false if buffer
+/// is not in the shared arena or the mailbox slot is busy, then the caller must send
+/// it with MPI
+bool post(int d, const void *buffer, size_t bytes, int tag, request &req);
+
+/// Sender: wait until the receiver has read the buffer
+void wait_sent(int d, const request &req);
+
+/// Receiver: reserve the next mailbox slot of direction d, called in start_gather
+void expect(int d, int tag, request &req);
+
+/// Receiver: wait for the data from rank from_rank, through the mailbox or MPI, and
+/// copy it to buffer
+void receive(int d, int from_rank, void *buffer, size_t bytes, request &req);
+
+} // namespace shm
+} // namespace hila
+
+#endif
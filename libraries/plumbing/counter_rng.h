@@ -0,0 +1,79 @@
+#ifndef COUNTER_RNG_H_
+#define COUNTER_RNG_H_
+
+#include <cstdint>
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/// Counter-based random number generator Philox4x32-10
+/// (Salmon, Moraes, Dror, Shaw: "Parallel random numbers: as easy as 1, 2, 3", SC11)
+///
+/// The generator is stateless: 128 bits of output are a pure function of the
+/// 128-bit counter and the 64-bit key.  This is used for per-site random numbers
+/// inside site loops:  the key is the global seed, and the counter is built from
+/// the global site index, running site loop number and the draw number at the site.
+/// Thus the random numbers at a site do not depend on the MPI layout, number of
+/// threads or the order in which the sites are visited.
+///
+/// philox4x32_lanes() does the same for several counters at once, with identical key.
+/// It is written so that the compiler can vectorize the lane loops (AVX backend).
+/////////////////////////////////////////////////////////////////////////////////////////
+
+namespace hila {
+
+namespace philox {
+
+constexpr uint32_t mul0 = 0xD2511F53;
+constexpr uint32_t mul1 = 0xCD9E8D57;
+constexpr uint32_t weyl0 = 0x9E3779B9;
+constexpr uint32_t weyl1 = 0xBB67AE85;
+constexpr int rounds = 10;
+
+/// one round of Philox4x32
+inline void round(uint32_t *c, uint32_t k0, uint32_t k1) {
+    uint64_t p0 = (uint64_t)mul0 * c[0];
+    uint64_t p1 = (uint64_t)mul1 * c[2];
+    uint32_t c1 = c[1], c3 = c[3];
+    c[0] = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+    c[1] = (uint32_t)p1;
+    c[2] = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+    c[3] = (uint32_t)p0;
+}
+
+} // namespace philox
+
+/// Philox4x32-10: transform the counter c[4] in place to 4 random 32-bit words
+inline void philox4x32(uint32_t *c, uint32_t k0, uint32_t k1) {
+    for (int r = 0; r < philox::rounds; r++) {
+        philox::round(c, k0, k1);
+        k0 += philox::weyl0;
+        k1 += philox::weyl1;
+    }
+}
+
+/// Lane-parallel version: c[w][lane], w = 0..3.  All lanes use the same key.
+template <int lanes>
+inline void philox4x32_lanes(uint32_t (&c)[4][lanes], uint32_t k0, uint32_t k1) {
+    for (int r = 0; r < philox::rounds; r++) {
+        for (int i = 0; i < lanes; i++) {
+            uint64_t p0 = (uint64_t)philox::mul0 * c[0][i];
+            uint64_t p1 = (uint64_t)philox::mul1 * c[2][i];
+            uint32_t c1 = c[1][i], c3 = c[3][i];
+            c[0][i] = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+            c[1][i] = (uint32_t)p1;
+            c[2][i] = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+            c[3][i] = (uint32_t)p0;
+        }
+        k0 += philox::weyl0;
+        k1 += philox::weyl1;
+    }
+}
+
+/// Convert 2 random 32-bit words to double in [0,1) with 53 random bits
+inline double philox_to_double(uint32_t hi, uint32_t lo) {
+    uint64_t u = ((uint64_t)hi << 32) | lo;
+    return (u >> 11) * (1.0 / 9007199254740992.0);
+}
+
+} // namespace hila
+
+#endif
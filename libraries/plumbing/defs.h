@@ -44,6 +44,7 @@
 // #include "plumbing/mersenne.h"
 #include "plumbing/memalloc.h" // memory allocator
 #include "plumbing/timing.h"
+#include "plumbing/event_trace.h"
 
 
 /// Define __restrict__?  It is non-standard but supported by most (all?) compilers.
@@ -117,6 +118,10 @@ extern bool is_initialized;
 extern bool check_input;
 extern int check_with_nodes;
 
+// parallel_io: binary field files are written/read using MPI-IO.  If false,
+// all i/o goes through rank 0.
+extern bool parallel_io;
+
 enum sort { unsorted, ascending, descending };
 
 void initialize(int argc, char **argv);
@@ -0,0 +1,179 @@
+///////////////////////////////////////////
+/// event_trace.cpp - Chrome trace timeline, see event_trace.h
+
+#include "plumbing/defs.h"
+#include "plumbing/lattice.h"
+#include "plumbing/com_mpi.h"
+#include "plumbing/event_trace.h"
+#include <cstdio>
+#include <fstream>
+#include <unordered_map>
+
+namespace hila {
+
+bool event_trace_on = false;
+
+struct trace_event {
+    double t, dur;
+    uint64_t id;
+    int name;
+    char phase;
+};
+
+static std::string trace_filename;
+static std::vector<trace_event> trace_buffer;
+static int64_t n_recorded = 0; // total number of events, buffer index is n_recorded % size
+static double trace_t0 = 0;
+
+static std::vector<std::string> trace_names;
+static std::unordered_map<std::string, int> trace_name_map;
+
+int trace_name_id(const std::string &name) {
+    auto it = trace_name_map.find(name);
+    if (it != trace_name_map.end())
+        return it->second;
+
+    // name goes as such into json, escape and keep it short
+    std::string jname;
+    for (char c : name.substr(0, 200)) {
+        if (c == '"' || c == '\\')
+            jname += '\\';
+        jname += c;
+    }
+    int id = trace_names.size();
+    trace_names.push_back(jname);
+    trace_name_map[name] = id;
+    return id;
+}
+
+void trace_record(int name, char phase, double t_start, uint64_t id) {
+    if (!event_trace_on)
+        return;
+    trace_event &e = trace_buffer[n_recorded % trace_buffer.size()];
+    double t = hila::gettime();
+    if (phase == 'X') {
+        e.t = t_start;
+        e.dur = t - t_start;
+    } else {
+        e.t = t;
+        e.dur = 0;
+    }
+    e.id = id;
+    e.name = name;
+    e.phase = phase;
+    n_recorded++;
+}
+
+int trace_gather_name(int d, int par_i) {
+    static std::vector<int> ids;
+    if (ids.size() == 0)
+        ids.assign(3 * NDIRS, -1);
+    int &id = ids[3 * d + par_i];
+    if (id < 0) {
+        static const char *parname[3] = {"EVEN", "ODD", "ALL"};
+        id = trace_name_id(std::string("gather ") +
+                           hila::direction_name(static_cast<Direction>(d)) + " " +
+                           parname[par_i]);
+    }
+    return id;
+}
+
+void setup_event_trace(const std::string &filename, int64_t n_events) {
+    if (n_events <= 0) {
+        hila::out0 << "-trace: number of events must be positive\n";
+        hila::terminate(0);
+    }
+    trace_filename = filename;
+    trace_buffer.resize(n_events);
+    n_recorded = 0;
+
+    // common time origin for all ranks, up to the barrier latency
+    MPI_Barrier(lattice.mpi_comm_lat);
+    trace_t0 = hila::gettime();
+
+    event_trace_on = true;
+    hila::out0 << "Event trace to file '" << filename << "', " << n_events
+               << " events per rank\n";
+}
+
+/// The events of this rank as JSON objects, one per line
+static std::string trace_events_json() {
+    std::string s;
+    char line[512];
+    int64_t size = trace_buffer.size();
+    int64_t first = (n_recorded > size) ? n_recorded - size : 0;
+    int rank = hila::myrank();
+
+    for (int64_t i = first; i < n_recorded; i++) {
+        const trace_event &e = trace_buffer[i % size];
+        const char *name = trace_names[e.name].c_str();
+        double ts = 1e6 * (e.t - trace_t0);
+        if (e.phase == 'X') {
+            std::snprintf(line, sizeof(line),
+                          ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":0,\"ts\":%.3f,"
+                          "\"dur\":%.3f}",
+                          name, rank, ts, 1e6 * e.dur);
+        } else {
+            std::snprintf(line, sizeof(line),
+                          ",\n{\"name\":\"%s\",\"cat\":\"gather\",\"ph\":\"%c\",\"id\":\"0x%llx\","
+                          "\"pid\":%d,\"tid\":0,\"ts\":%.3f}",
+                          name, e.phase, (unsigned long long)e.id, rank, ts);
+        }
+        s += line;
+    }
+    if (n_recorded > size) {
+        std::snprintf(line, sizeof(line),
+                      ",\n{\"name\":\"trace buffer overflow, %lld events lost\",\"ph\":\"i\","
+                      "\"s\":\"p\",\"pid\":%d,\"tid\":0,\"ts\":%.3f}",
+                      (long long)first, rank,
+                      1e6 * (trace_buffer[first % size].t - trace_t0));
+        s += line;
+    }
+    return s;
+}
+
+/// Collective: rank 0 receives the events of the other ranks one at a time and
+/// writes them to the trace file
+void write_event_trace() {
+    if (!event_trace_on)
+        return;
+    event_trace_on = false;
+
+    std::string events = trace_events_json();
+
+    if (hila::myrank() == 0) {
+        std::ofstream outf(trace_filename, std::ios::out | std::ios::trunc);
+        if (!outf) {
+            hila::out << "Cannot open event trace file '" << trace_filename << "'\n";
+        }
+        outf << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        outf << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"rank "
+                "0\"}}";
+        outf << events;
+
+        for (int r = 1; r < hila::number_of_nodes(); r++) {
+            int64_t len;
+            MPI_Recv(&len, sizeof(int64_t), MPI_BYTE, r, 0, lattice.mpi_comm_lat,
+                     MPI_STATUS_IGNORE);
+            std::string buf(len, ' ');
+            MPI_Recv(buf.data(), (int)len, MPI_BYTE, r, 1, lattice.mpi_comm_lat,
+                     MPI_STATUS_IGNORE);
+            outf << ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << r
+                 << ",\"args\":{\"name\":\"rank " << r << "\"}}";
+            outf << buf;
+        }
+        outf << "\n]}\n";
+        outf.close();
+
+        hila::out << "Event trace written to '" << trace_filename << "'\n";
+    } else {
+        int64_t len = events.size();
+        MPI_Send(&len, sizeof(int64_t), MPI_BYTE, 0, 0, lattice.mpi_comm_lat);
+        MPI_Send(events.data(), (int)len, MPI_BYTE, 0, 1, lattice.mpi_comm_lat);
+    }
+
+    trace_buffer.clear();
+    trace_buffer.shrink_to_fit();
+}
+
+} // namespace hila
@@ -0,0 +1,44 @@
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include <cstdint>
+#include <string>
+
+namespace hila {
+
+////////////////////////////////////////////////////////////////
+/// Per-rank event timeline, written as Chrome trace JSON (chrome://tracing,
+/// ui.perfetto.dev).  Enabled with command line option
+///
+///     -trace <filename> [<events>]
+///
+/// Events are stored in a ring buffer of <events> entries per rank (default 262144),
+/// when it fills up the oldest events are overwritten.  Recorded are
+///   - every hila::timer start-stop interval (this includes the MPI send/receive/wait
+///     timers, reductions and FFT timers)
+///   - gathers, from start_gather() to the completion in wait_gather(), as async events
+///   - site loops, if hilapp was run with -loop-profile (make LOOP_PROFILE=1)
+///
+/// hila::finishrun() collects the events of all ranks of the lattice to rank 0, which
+/// writes the file.  Rank n is process n in the trace.  Timestamps are relative to a
+/// barrier at the start of the run.
+////////////////////////////////////////////////////////////////
+
+extern bool event_trace_on;
+
+/// Return the id of the event name, adding it to the name table if needed
+int trace_name_id(const std::string &name);
+
+/// Record an event.  phase is 'X' (interval from t_start to now), 'b' or 'e'
+/// (async begin / end with id)
+void trace_record(int name, char phase, double t_start = 0, uint64_t id = 0);
+
+/// Name id of a gather in direction d, parity index par_i
+int trace_gather_name(int d, int par_i);
+
+void setup_event_trace(const std::string &filename, int64_t n_events);
+void write_event_trace();
+
+} // namespace hila
+
+#endif
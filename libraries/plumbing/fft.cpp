@@ -22,15 +22,25 @@ std::vector<pencil_struct> hila_pencil_comms[NDIM];
 unsigned hila_fft_my_columns[NDIM]; // how many columns does this node take care of
 size_t pencil_recv_buf_size[NDIM];
 
+// and the same for the half k-lattice of real-to-complex transforms
+std::vector<pencil_struct> hila_pencil_comms_half[NDIM];
+unsigned hila_fft_my_columns_half[NDIM];
+size_t pencil_recv_buf_size_half[NDIM];
+
 // static variable to hold fft plans
 #if (defined(HIP) || defined(CUDA)) && !defined(HILAPP)
 hila_saved_fftplan_t hila_saved_fftplan;
+#elif defined(USE_FFTW)
+hila_saved_fftwplan_t hila_saved_fftwplan;
 #endif
 
-// Delete saved plans if required - no-op for non-gpu
+// Delete saved plans.  For fftw save the wisdom first, if in use
 void FFT_delete_plans() {
 #if (defined(HIP) || defined(CUDA)) && !defined(HILAPP)
     hila_saved_fftplan.delete_plans();
+#elif defined(USE_FFTW)
+    hila_saved_fftwplan.save_wisdom();
+    hila_saved_fftwplan.delete_plans();
 #endif
 }
 
@@ -53,68 +63,114 @@ size_t pencil_get_buffer_offsets(const Direction dir, const size_t elements,
     return element_offset;
 }
 
-/// THis is to be called before fft to Direction dir
+/// Set up the pencil communication structures to direction dir.  total_columns is the
+/// number of columns (sites / size to dir) on this node.  This is the same for the
+/// lattice and the half k-lattice of the real-to-complex transforms.
 
+static void setup_pencil_comms(Direction dir, size_t total_columns,
+                               std::vector<pencil_struct> &comms, unsigned &my_columns,
+                               size_t &recv_buf_size) {
 
-/////////////////////////////////////////////////////////////////////////////////////
+    comms.resize(lattice.nodes.n_divisions[dir]);
 
-void init_pencil_direction(Direction dir) {
+    int nodenumber = 0;
+    for (const node_info &n : lattice.nodes.nodelist) {
+        bool is_in_column = true;
+        foralldir(d) if (d != dir && n.min[d] != lattice.mynode.min[d]) {
+            is_in_column = false;
+            break; // breaks out of foralldir
+        }
 
-    if (hila_pencil_comms[dir].size() == 0) {
-        // basic structs not yet set, do it here
+        // store the nodes in the comms -list in the right order -
+        // nodes may be reordered by some weird layout
+        if (is_in_column) {
+            pencil_struct fn;
+            fn.node = nodenumber;
+            fn.size_to_dir = n.size[dir];
+            for (int i = 0; i < lattice.nodes.n_divisions[dir]; i++) {
+                if (n.min[dir] == lattice.nodes.divisors[dir][i]) {
+                    comms.at(i) = fn;
+                }
+            }
+        }
+        ++nodenumber;
+    }
 
-        hila_pencil_comms[dir].resize(lattice.nodes.n_divisions[dir]);
+    size_t nodes = comms.size();
 
-        int nodenumber = 0;
-        for (const node_info &n : lattice.nodes.nodelist) {
-            bool is_in_column = true;
-            foralldir(d) if (d != dir && n.min[d] != lattice.mynode.min[d]) {
-                is_in_column = false;
-                break; // breaks out of foralldir
-            }
+    // column offset and number are used for sending
+    size_t i = 0;
+    for (pencil_struct &fn : comms) {
+        fn.column_offset = ((i * total_columns) / nodes) * lattice.mynode.size[dir];
+        fn.column_number =
+            (((i + 1) * total_columns) / nodes) - fn.column_offset / lattice.mynode.size[dir];
 
-            // store the nodes in the hila_pencil_comms -list in the right order -
-            // nodes may be reordered by some weird layout
-            if (is_in_column) {
-                pencil_struct fn;
-                fn.node = nodenumber;
-                fn.size_to_dir = n.size[dir];
-                for (int i = 0; i < lattice.nodes.n_divisions[dir]; i++) {
-                    if (n.min[dir] == lattice.nodes.divisors[dir][i]) {
-                        hila_pencil_comms[dir].at(i) = fn;
-                    }
-                }
-            }
-            ++nodenumber;
+        if (fn.node == hila::myrank()) {
+            my_columns = fn.column_number;
         }
+        i++;
+    }
 
-        size_t total_columns = lattice.mynode.sites / lattice.mynode.size[dir];
+    recv_buf_size = 0;
 
-        size_t nodes = hila_pencil_comms[dir].size();
+    for (pencil_struct &fn : comms) {
+        fn.recv_buf_size = my_columns * fn.size_to_dir;
 
-        // column offset and number are used for sending
-        size_t i = 0;
-        for (pencil_struct &fn : hila_pencil_comms[dir]) {
-            fn.column_offset =
-                ((i * total_columns) / nodes) * lattice.mynode.size[dir];
-            fn.column_number = (((i + 1) * total_columns) / nodes) -
-                               fn.column_offset / lattice.mynode.size[dir];
+        // how big array?
+        if (fn.node != hila::myrank())
+            recv_buf_size += fn.recv_buf_size;
+    }
+}
 
-            if (fn.node == hila::myrank()) {
-                hila_fft_my_columns[dir] = fn.column_number;
-            }
-            i++;
-        }
+/// THis is to be called before fft to Direction dir
 
-        pencil_recv_buf_size[dir] = 0;
+void init_pencil_direction(Direction dir) {
 
-        for (pencil_struct &fn : hila_pencil_comms[dir]) {
-            fn.recv_buf_size = hila_fft_my_columns[dir] * fn.size_to_dir;
+    if (hila_pencil_comms[dir].size() == 0) {
+        // basic structs not yet set, do it here
 
-            // how big array?
-            if (fn.node != hila::myrank())
-                pencil_recv_buf_size[dir] += fn.recv_buf_size;
-        }
+        setup_pencil_comms(dir, lattice.mynode.sites / lattice.mynode.size[dir],
+                           hila_pencil_comms[dir], hila_fft_my_columns[dir],
+                           pencil_recv_buf_size[dir]);
+    }
+}
 
-    } // setup
+//////////////////////////////////////////////////////////////////////////////////////
+/// Half k-lattice of the real-to-complex transform: direction e_x is cut to
+/// k_x = 0 ... size(e_x)/2.  A node gets the k_x values for which 2 k_x is within its
+/// x-range, and the node at the upper x-edge gets also k_x = size(e_x)/2.
+/// Other directions are as in the lattice.  Some nodes may have no k_x values.
+
+void fft_half_node_range(const CoordinateVector &min, const CoordinateVector &size,
+                         CoordinateVector &hmin, CoordinateVector &hsize) {
+    hmin = min;
+    hsize = size;
+
+    int end = min[e_x] + size[e_x];
+    if (end == lattice.size(e_x))
+        end = lattice.size(e_x) / 2 + 1;
+    else
+        end = (end + 1) / 2;
+
+    hmin[e_x] = (min[e_x] + 1) / 2;
+    hsize[e_x] = end - hmin[e_x];
+}
+
+/// Pencils to direction dir != e_x on the half k-lattice
+
+void init_pencil_direction_half(Direction dir) {
+
+    assert(dir != e_x && "No half k-lattice pencils to e_x");
+
+    if (hila_pencil_comms_half[dir].size() == 0) {
+
+        CoordinateVector hmin, hsize;
+        fft_half_node_range(lattice.mynode.min, lattice.mynode.size, hmin, hsize);
+
+        size_t total_columns = 1;
+        foralldir(d) if (d != dir) total_columns *= hsize[d];
+
+        setup_pencil_comms(dir, total_columns, hila_pencil_comms_half[dir],
+                           hila_fft_my_columns_half[dir], pencil_recv_buf_size_half[dir]);
+    }
 }
@@ -54,6 +54,13 @@ struct pencil_struct {
 
 //
 extern std::vector<pencil_struct> hila_pencil_comms[NDIM];
+extern unsigned hila_fft_my_columns[NDIM];
+extern size_t pencil_recv_buf_size[NDIM];
+
+// the same for the half k-lattice of real-to-complex transforms
+extern std::vector<pencil_struct> hila_pencil_comms_half[NDIM];
+extern unsigned hila_fft_my_columns_half[NDIM];
+extern size_t pencil_recv_buf_size_half[NDIM];
 
 /// Build offsets to buffer arrays:
 ///   Fastest Direction = dir, offset 1
@@ -67,6 +74,14 @@ size_t pencil_get_buffer_offsets(const Direction dir, const size_t elements,
 /// Initialize fft direction - defined in fft.cpp
 void init_pencil_direction(Direction d);
 
+/// Range of the half k-lattice of real-to-complex transforms on node with
+/// lattice range min, size - defined in fft.cpp
+void fft_half_node_range(const CoordinateVector &min, const CoordinateVector &size,
+                         CoordinateVector &hmin, CoordinateVector &hsize);
+
+/// Initialize direction d != e_x on the half k-lattice
+void init_pencil_direction_half(Direction d);
+
 // Helper class to transform data
 template <typename T, typename cmplx_t>
 union T_union {
@@ -88,6 +103,12 @@ class hila_fft {
 
     bool only_reflect;
 
+    // pencil structures in use: of the lattice, or of the half k-lattice
+    // in real-to-complex transforms
+    bool half_lattice;
+    std::vector<pencil_struct> *pencil_comms;
+    unsigned *my_columns;
+
     cmplx_t *send_buf;
     cmplx_t *receive_buf;
 
@@ -96,22 +117,43 @@ class hila_fft {
     std::vector<int> rec_size;
 
     // initialize fft, allocate buffers
-    hila_fft(int _elements, fft_direction _fftdir, bool _reflect = false) {
-        extern size_t pencil_recv_buf_size[NDIM];
+    hila_fft(int _elements, fft_direction _fftdir, bool _reflect = false,
+             bool _half_lattice = false) {
 
         elements = _elements;
         fftdir = _fftdir;
         only_reflect = _reflect;
+        half_lattice = _half_lattice;
+
+        size_t *recv_buf_size;
+
+        if (!half_lattice) {
+            local_volume = lattice.mynode.volume();
 
-        local_volume = lattice.mynode.volume();
+            // init dirs here at one go
+            foralldir(d) init_pencil_direction(d);
 
-        // init dirs here at one go
-        foralldir(d) init_pencil_direction(d);
+            pencil_comms = hila_pencil_comms;
+            my_columns = hila_fft_my_columns;
+            recv_buf_size = pencil_recv_buf_size;
+        } else {
+            CoordinateVector hmin, hsize;
+            fft_half_node_range(lattice.mynode.min, lattice.mynode.size, hmin, hsize);
+            local_volume = 1;
+            foralldir(d) local_volume *= hsize[d];
+
+            // e_x is transformed separately
+            foralldir(d) if (d != e_x) init_pencil_direction_half(d);
+
+            pencil_comms = hila_pencil_comms_half;
+            my_columns = hila_fft_my_columns_half;
+            recv_buf_size = pencil_recv_buf_size_half;
+        }
 
         buf_size = 1;
         foralldir(d) {
-            if (pencil_recv_buf_size[d] > buf_size)
-                buf_size = pencil_recv_buf_size[d];
+            if (recv_buf_size[d] > buf_size)
+                buf_size = recv_buf_size[d];
         }
         if (buf_size < local_volume)
             buf_size = local_volume;
@@ -149,12 +191,12 @@ class hila_fft {
         // now in transform itself
         // make_fft_plan();
 
-        rec_p.resize(hila_pencil_comms[dir].size());
-        rec_size.resize(hila_pencil_comms[dir].size());
+        rec_p.resize(pencil_comms[dir].size());
+        rec_size.resize(pencil_comms[dir].size());
 
         cmplx_t *p = receive_buf;
         int i = 0;
-        for (pencil_struct &fn : hila_pencil_comms[dir]) {
+        for (pencil_struct &fn : pencil_comms[dir]) {
 
             if (fn.node != hila::myrank()) {
 
@@ -288,6 +330,10 @@ class hila_fft {
     void scatter_data();
     void gather_data();
 
+    // transform of the half k-lattice data to directions != e_x,
+    // used in real-to-complex transforms
+    void half_lattice_transform(cmplx_t *data, const CoordinateVector &hsize);
+
     ////////////////////////////////////////////////////////////////////////
     /// Do the transform itself (fft or reflect only)
 
@@ -459,6 +505,7 @@ Field<T> Field<T>::FFT(fft_direction fftdir) const {
 /// FFT_real_to_complex:
 /// Field must be a real-valued field, result is a complex-valued field of the same type
 /// Implemented just by doing a FFT with a complex field with im=0;
+/// FFT_real_to_half() below avoids the full complex field.
 /// fft_direction::back gives a complex conjugate of the forward transform
 /// Result is  f(-x) = f(L - x) = f(x)^*
 //////////////////////////////////////////////////////////////////////////////////
@@ -551,6 +598,189 @@ Field<hila::arithmetic_type<T>> Field<T>::FFT_complex_to_real(fft_direction fftd
 }
 
 
+//////////////////////////////////////////////////////////////////////////////////
+/// hila::half_k_field<T> holds the result of the real-to-complex transform of
+/// Field<T>, T = double or float.  Because the transform of a real field has
+/// F(-k) = F(k)^*, only the half k_x = 0 ... lattice.size(e_x)/2 is stored.
+/// The half k-lattice is split to nodes as given by fft_half_node_range(): a node
+/// holds the k_x values for which 2 k_x is in its x-range.
+///
+///   Field<double> f;
+///   hila::half_k_field<double> h;
+///   FFT_real_to_half(f, h);       // forward transform
+///   FFT_half_to_real(h, f);       // and back, f is multiplied by lattice.volume()
+///
+/// Access on this node:
+///   h.for_each([&](const CoordinateVector &k, const Complex<T> &v, int mult) {...})
+///           loops over the stored values.  mult = 2 if the value stands also for
+///           the mirror point -k, which is not stored, and 1 on the planes k_x = 0
+///           and k_x = size(e_x)/2, which are stored in full.
+///   h.is_local(k)     true if F(k) or F(-k) is stored on this node
+///   h.value(k)        F(k) for any such k - conjugate of F(-k) if needed
+///   h[k]              reference to the stored value, 0 <= k_x <= size(e_x)/2
+//////////////////////////////////////////////////////////////////////////////////
+
+namespace hila {
+
+template <typename T>
+class half_k_field {
+  public:
+    /// range of the half k-lattice on this node
+    CoordinateVector min, size;
+    /// the values, e_x goes fastest
+    std::vector<Complex<T>> data;
+
+    half_k_field() {
+        fft_half_node_range(lattice.mynode.min, lattice.mynode.size, min, size);
+        size_t volume = 1;
+        foralldir(d) volume *= size[d];
+        data.resize(volume);
+    }
+
+    /// Is k, 0 <= k_i < lattice.size(i), stored on this node
+    bool is_stored(const CoordinateVector &k) const {
+        foralldir(d) {
+            if (k[d] < min[d] || k[d] >= min[d] + size[d])
+                return false;
+        }
+        return true;
+    }
+
+    size_t index(const CoordinateVector &k) const {
+        size_t i = 0, m = 1;
+        foralldir(d) {
+            i += (k[d] - min[d]) * m;
+            m *= size[d];
+        }
+        return i;
+    }
+
+    Complex<T> &operator[](const CoordinateVector &k) {
+        assert(is_stored(k) && "half_k_field: k not stored on this node");
+        return data[index(k)];
+    }
+
+    const Complex<T> &operator[](const CoordinateVector &k) const {
+        assert(is_stored(k) && "half_k_field: k not stored on this node");
+        return data[index(k)];
+    }
+
+    bool is_local(const CoordinateVector &k) const {
+        CoordinateVector kp, km;
+        foralldir(d) {
+            kp[d] = pmod(k[d], lattice.size(d));
+            km[d] = pmod(-k[d], lattice.size(d));
+        }
+        return is_stored(kp) || is_stored(km);
+    }
+
+    /// F(k) for any k for which is_local(k) is true
+    Complex<T> value(const CoordinateVector &k) const {
+        CoordinateVector kp, km;
+        foralldir(d) {
+            kp[d] = pmod(k[d], lattice.size(d));
+            km[d] = pmod(-k[d], lattice.size(d));
+        }
+        if (is_stored(kp))
+            return data[index(kp)];
+
+        assert(is_stored(km) && "half_k_field: k not on this node");
+        return data[index(km)].conj();
+    }
+
+    /// How many points of the full k-lattice the stored value at k stands for
+    static int multiplicity(const CoordinateVector &k) {
+        if (k[e_x] == 0 || 2 * k[e_x] == lattice.size(e_x))
+            return 1;
+        return 2;
+    }
+
+    /// Call f(k, value, multiplicity) for all values stored on this node
+    template <typename func_t>
+    void for_each(func_t &&f) const {
+        CoordinateVector k = min;
+        for (size_t i = 0; i < data.size(); i++) {
+            f(k, data[i], multiplicity(k));
+
+            foralldir(d) {
+                if (++k[d] < min[d] + size[d])
+                    break;
+                k[d] = min[d];
+            }
+        }
+    }
+};
+
+} // namespace hila
+
+#if defined(USE_FFTW)
+
+//////////////////////////////////////////////////////////////////////////////////
+/// FFT_real_to_half(input, result):
+/// Forward real-to-complex FFT of Field<T> input, T = double or float.
+/// Direction e_x is transformed with fftw r2c, and only the half k_x <= size(e_x)/2
+/// is carried through the other directions.  Thus memory, communication and work are
+/// about half of those in FFT_real_to_complex().  Unnormalized, as FFT_field().
+//////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+void FFT_real_to_half(const Field<T> &input, hila::half_k_field<T> &result) {
+
+    static_assert(std::is_same<T, double>::value || std::is_same<T, float>::value,
+                  "FFT_real_to_half can be applied only to Field<double> or Field<float>");
+
+    assert(lattice.id() == input.fs->lattice_id && "Default lattice mismatch in fft");
+
+    extern hila::timer fft_timer;
+    fft_timer.start();
+
+    {
+        hila_fft_real<T> rfft;
+        rfft.real_to_complex(input, result.data.data());
+    }
+
+    hila_fft<Complex<T>> cfft(1, fft_direction::forward, false, true);
+    cfft.half_lattice_transform(result.data.data(), result.size);
+
+    fft_timer.stop();
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/// FFT_half_to_real(input, result):
+/// Inverse of FFT_real_to_half(), complex-to-real transform.  Unnormalized:
+/// transform + inverse yields the source multiplied by lattice.volume().
+//////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+void FFT_half_to_real(const hila::half_k_field<T> &input, Field<T> &result) {
+
+    static_assert(std::is_same<T, double>::value || std::is_same<T, float>::value,
+                  "FFT_half_to_real can be applied only to Field<double> or Field<float>");
+
+    extern hila::timer fft_timer;
+    fft_timer.start();
+
+    // complex transforms are done in place
+    std::vector<Complex<T>> hbuf = input.data;
+
+    {
+        hila_fft<Complex<T>> cfft(1, fft_direction::back, false, true);
+        cfft.half_lattice_transform(hbuf.data(), input.size);
+    }
+
+    result.check_alloc();
+
+    hila_fft_real<T> rfft;
+    rfft.complex_to_real(hbuf.data(), result);
+
+    result.mark_changed(ALL);
+
+    fft_timer.stop();
+}
+
+#endif
+
+
 //////////////////////////////////////////////////////////////////////////////////
 /// Field<T>::reflect() reflects the field around the desired axis
 /// This is here because it uses similar communications as fft
@@ -7,125 +7,255 @@
 /// This is not a standalone header, it is meant to be #include'd from
 /// fft.h .
 
-/// transform does the actual fft.
-template <typename cmplx_t>
-void hila_fft<cmplx_t>::transform() {
-    assert(0 && "Don't call this!");
-}
-
-template <>
-inline void hila_fft<Complex<double>>::transform() {
-    extern unsigned hila_fft_my_columns[NDIM];
-    extern hila::timer fft_plan_timer, fft_buffer_timer, fft_execute_timer;
-
-    size_t n_fft = hila_fft_my_columns[dir] * elements;
-
-    int transform_dir =
-        (fftdir == fft_direction::forward) ? FFTW_FORWARD : FFTW_BACKWARD;
-
-    fft_plan_timer.start();
-
-    // allocate here fftw plans.  TODO: perhaps store, if plans take appreciable time?
-    // Timer will tell the proportional timing
-
-    fftw_complex *fftwbuf =
-        (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * lattice.size(dir));
-    fftw_plan fftwplan = fftw_plan_dft_1d(lattice.size(dir), fftwbuf, fftwbuf,
-                                          transform_dir, FFTW_ESTIMATE);
-
-    fft_plan_timer.stop();
-
-    for (size_t i = 0; i < n_fft; i++) {
-        // collect stuff from buffers
-
-        fft_buffer_timer.start();
+/// FFTW plans are cached in hila_saved_fftwplan (defined in fft.cpp), keyed by
+/// direction, length, precision, sign, batch count and kind (c2c, r2c or c2r).  One plan transforms all
+/// columns of this node at one go (fftw_plan_many_dft).  The plans stay until
+/// FFT_delete_plans(), which is called in hila::finishrun().
+///
+/// Plans are made with FFTW_ESTIMATE, or with FFTW_MEASURE if FFT_PLAN_MEASURE is
+/// defined.  With FFT_WISDOM_FILE="filename" the wisdom is read from the file before
+/// the first plan and written by rank 0 in FFT_delete_plans().
+
+class hila_saved_fftwplan_t {
+  public:
+    enum class kind_t { c2c, r2c, c2r };
+
+    struct plan_d {
+        fftw_plan plan;
+        fftwf_plan planf;
+        int dir;
+        int size;
+        int batch;
+        int sign;
+        bool is_float;
+        kind_t kind;
+    };
+
+    std::vector<plan_d> plans;
+
+    // contiguous work buffer for the columns, used when the columns are
+    // split in several receive buffers.  Plans are made on this buffer.
+    void *work_buf = nullptr;
+    size_t work_buf_size = 0;
+
+    bool wisdom_loaded = false;
+
+    ~hila_saved_fftwplan_t() {
+        delete_plans();
+    }
 
-        fftw_complex *cp = fftwbuf;
-        for (int j = 0; j < rec_p.size(); j++) {
-            memcpy(cp, rec_p[j] + i * rec_size[j], sizeof(fftw_complex) * rec_size[j]);
-            cp += rec_size[j];
+    void delete_plans() {
+        for (auto &p : plans) {
+            if (p.is_float)
+                fftwf_destroy_plan(p.planf);
+            else
+                fftw_destroy_plan(p.plan);
         }
+        plans.clear();
+        if (work_buf != nullptr)
+            fftw_free(work_buf);
+        work_buf = nullptr;
+        work_buf_size = 0;
+    }
 
-        fft_buffer_timer.stop();
-
-        // do the fft
-        fft_execute_timer.start();
-
-        fftw_execute(fftwplan);
-
-        fft_execute_timer.stop();
-
-        fft_buffer_timer.start();
-
-        cp = fftwbuf;
-        for (int j = 0; j < rec_p.size(); j++) {
-            memcpy(rec_p[j] + i * rec_size[j], cp, sizeof(fftw_complex) * rec_size[j]);
-            cp += rec_size[j];
+    /// return work buffer of at least size bytes.  Old contents are not kept
+    void *get_work_buf(size_t size) {
+        if (size > work_buf_size) {
+            if (work_buf != nullptr)
+                fftw_free(work_buf);
+            work_buf = fftw_malloc(size);
+            work_buf_size = size;
         }
-
-        fft_buffer_timer.stop();
+        return work_buf;
     }
 
-    fftw_destroy_plan(fftwplan);
-    fftw_free(fftwbuf);
-}
-
-template <>
-inline void hila_fft<Complex<float>>::transform() {
-
-    extern hila::timer fft_plan_timer, fft_buffer_timer, fft_execute_timer;
-    extern unsigned hila_fft_my_columns[NDIM];
+    static unsigned plan_flags() {
+#if defined(FFT_PLAN_MEASURE)
+        // plans are used with different arrays, thus FFTW_UNALIGNED
+        return FFTW_MEASURE | FFTW_UNALIGNED;
+#else
+        return FFTW_ESTIMATE | FFTW_UNALIGNED;
+#endif
+    }
 
-    size_t n_fft = hila_fft_my_columns[dir] * elements;
+    void load_wisdom() {
+#if defined(FFT_WISDOM_FILE)
+        if (!wisdom_loaded) {
+            fftw_import_wisdom_from_filename(FFT_WISDOM_FILE);
+            fftwf_import_wisdom_from_filename(FFT_WISDOM_FILE "_float");
+        }
+#endif
+        wisdom_loaded = true;
+    }
 
-    int transform_dir =
-        (fftdir == fft_direction::forward) ? FFTW_FORWARD : FFTW_BACKWARD;
+    void save_wisdom() {
+#if defined(FFT_WISDOM_FILE)
+        if (wisdom_loaded && hila::myrank() == 0) {
+            fftw_export_wisdom_to_filename(FFT_WISDOM_FILE);
+            fftwf_export_wisdom_to_filename(FFT_WISDOM_FILE "_float");
+        }
+#endif
+    }
 
-    fft_plan_timer.start();
+    /// get cached plan or make a new one.  For r2c and c2r the real columns have
+    /// length size and the complex ones size/2 + 1
+    plan_d &get_plan(int dir, int size, int batch, int sign, bool is_float,
+                     kind_t kind = kind_t::c2c) {
 
-    // allocate here fftw plans.  TODO: perhaps store, if plans take appreciable time?
-    // Timer will tell the proportional timing
+        extern hila::timer fft_plan_timer;
 
-    fftwf_complex *fftwbuf =
-        (fftwf_complex *)fftwf_malloc(sizeof(fftwf_complex) * lattice.size(dir));
-    fftwf_plan fftwplan = fftwf_plan_dft_1d(lattice.size(dir), fftwbuf, fftwbuf,
-                                            transform_dir, FFTW_ESTIMATE);
+        for (auto &p : plans) {
+            if (p.dir == dir && p.size == size && p.batch == batch && p.sign == sign &&
+                p.is_float == is_float && p.kind == kind) {
+                return p;
+            }
+        }
 
-    fft_plan_timer.stop();
+        fft_plan_timer.start();
+
+        load_wisdom();
+
+        plan_d p;
+        p.dir = dir;
+        p.size = size;
+        p.batch = batch;
+        p.sign = sign;
+        p.is_float = is_float;
+        p.kind = kind;
+
+        // columns follow each other in the buffer
+        if (kind == kind_t::c2c) {
+            if (is_float) {
+                fftwf_complex *buf =
+                    (fftwf_complex *)get_work_buf(sizeof(fftwf_complex) * size * batch);
+                p.planf = fftwf_plan_many_dft(1, &size, batch, buf, nullptr, 1, size, buf, nullptr,
+                                              1, size, sign, plan_flags());
+            } else {
+                fftw_complex *buf =
+                    (fftw_complex *)get_work_buf(sizeof(fftw_complex) * size * batch);
+                p.plan = fftw_plan_many_dft(1, &size, batch, buf, nullptr, 1, size, buf, nullptr,
+                                            1, size, sign, plan_flags());
+            }
+        } else {
+            // real-complex plans are out-of-place, real columns in the work buffer
+            int hsize = size / 2 + 1;
+            if (is_float) {
+                float *rbuf = (float *)get_work_buf(sizeof(float) * size * batch);
+                fftwf_complex *cbuf =
+                    (fftwf_complex *)fftw_malloc(sizeof(fftwf_complex) * hsize * batch);
+                if (kind == kind_t::r2c)
+                    p.planf = fftwf_plan_many_dft_r2c(1, &size, batch, rbuf, nullptr, 1, size,
+                                                      cbuf, nullptr, 1, hsize, plan_flags());
+                else
+                    p.planf = fftwf_plan_many_dft_c2r(1, &size, batch, cbuf, nullptr, 1, hsize,
+                                                      rbuf, nullptr, 1, size, plan_flags());
+                fftw_free(cbuf);
+            } else {
+                double *rbuf = (double *)get_work_buf(sizeof(double) * size * batch);
+                fftw_complex *cbuf =
+                    (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * hsize * batch);
+                if (kind == kind_t::r2c)
+                    p.plan = fftw_plan_many_dft_r2c(1, &size, batch, rbuf, nullptr, 1, size, cbuf,
+                                                    nullptr, 1, hsize, plan_flags());
+                else
+                    p.plan = fftw_plan_many_dft_c2r(1, &size, batch, cbuf, nullptr, 1, hsize,
+                                                    rbuf, nullptr, 1, size, plan_flags());
+                fftw_free(cbuf);
+            }
+        }
+        plans.push_back(p);
 
-    for (size_t i = 0; i < n_fft; i++) {
-        // collect stuff from buffers
+        fft_plan_timer.stop();
 
-        fft_buffer_timer.start();
+        return plans.back();
+    }
+};
 
-        fftwf_complex *cp = fftwbuf;
-        for (int j = 0; j < rec_p.size(); j++) {
-            memcpy(cp, rec_p[j] + i * rec_size[j], sizeof(fftwf_complex) * rec_size[j]);
-            cp += rec_size[j];
-        }
+inline void hila_fftw_execute(hila_saved_fftwplan_t::plan_d &p, Complex<double> *buf) {
+    fftw_execute_dft(p.plan, (fftw_complex *)buf, (fftw_complex *)buf);
+}
 
-        fft_buffer_timer.stop();
+inline void hila_fftw_execute(hila_saved_fftwplan_t::plan_d &p, Complex<float> *buf) {
+    fftwf_execute_dft(p.planf, (fftwf_complex *)buf, (fftwf_complex *)buf);
+}
 
-        // do the fft
-        fft_execute_timer.start();
+inline void hila_fftw_execute(hila_saved_fftwplan_t::plan_d &p, double *in, Complex<double> *out) {
+    fftw_execute_dft_r2c(p.plan, in, (fftw_complex *)out);
+}
 
-        fftwf_execute(fftwplan);
+inline void hila_fftw_execute(hila_saved_fftwplan_t::plan_d &p, float *in, Complex<float> *out) {
+    fftwf_execute_dft_r2c(p.planf, in, (fftwf_complex *)out);
+}
 
-        fft_execute_timer.stop();
+inline void hila_fftw_execute(hila_saved_fftwplan_t::plan_d &p, Complex<double> *in, double *out) {
+    fftw_execute_dft_c2r(p.plan, (fftw_complex *)in, out);
+}
 
-        fft_buffer_timer.start();
+inline void hila_fftw_execute(hila_saved_fftwplan_t::plan_d &p, Complex<float> *in, float *out) {
+    fftwf_execute_dft_c2r(p.planf, (fftwf_complex *)in, out);
+}
 
-        cp = fftwbuf;
-        for (int j = 0; j < rec_p.size(); j++) {
-            memcpy(rec_p[j] + i * rec_size[j], cp, sizeof(fftwf_complex) * rec_size[j]);
-            cp += rec_size[j];
+/// transform does the actual fft.
+template <typename cmplx_t>
+void hila_fft<cmplx_t>::transform() {
+    extern hila::timer fft_buffer_timer, fft_execute_timer;
+    extern hila_saved_fftwplan_t hila_saved_fftwplan;
+
+    // hila_fft<T> is used also for reflect() of any type, which does not come here
+    if constexpr (!std::is_same<cmplx_t, Complex<double>>::value &&
+                  !std::is_same<cmplx_t, Complex<float>>::value) {
+        assert(0 && "FFT only for Complex<double> or Complex<float>");
+        return;
+    } else {
+
+        constexpr bool is_float = std::is_same<cmplx_t, Complex<float>>::value;
+
+        const int n_fft = my_columns[dir] * elements;
+        const int length = lattice.size(dir);
+
+        if (n_fft == 0)
+            return;
+
+        int transform_dir = (fftdir == fft_direction::forward) ? FFTW_FORWARD : FFTW_BACKWARD;
+
+        auto &plan = hila_saved_fftwplan.get_plan(dir, length, n_fft, transform_dir, is_float);
+
+        if (rec_p.size() == 1) {
+            // the whole column is on this node, columns are contiguous in the buffer
+            fft_execute_timer.start();
+            hila_fftw_execute(plan, rec_p[0]);
+            fft_execute_timer.stop();
+
+        } else {
+            // collect columns to the work buffer, transform and copy back
+            cmplx_t *wrk =
+                (cmplx_t *)hila_saved_fftwplan.get_work_buf(sizeof(cmplx_t) * length * n_fft);
+
+            fft_buffer_timer.start();
+            for (int i = 0; i < n_fft; i++) {
+                cmplx_t *cp = wrk + i * length;
+                for (int j = 0; j < rec_p.size(); j++) {
+                    memcpy(cp, rec_p[j] + i * rec_size[j], sizeof(cmplx_t) * rec_size[j]);
+                    cp += rec_size[j];
+                }
+            }
+            fft_buffer_timer.stop();
+
+            fft_execute_timer.start();
+            hila_fftw_execute(plan, wrk);
+            fft_execute_timer.stop();
+
+            fft_buffer_timer.start();
+            for (int i = 0; i < n_fft; i++) {
+                cmplx_t *cp = wrk + i * length;
+                for (int j = 0; j < rec_p.size(); j++) {
+                    memcpy(rec_p[j] + i * rec_size[j], cp, sizeof(cmplx_t) * rec_size[j]);
+                    cp += rec_size[j];
+                }
+            }
+            fft_buffer_timer.stop();
         }
-
-        fft_buffer_timer.stop();
     }
-
-    fftwf_destroy_plan(fftwplan);
-    fftwf_free(fftwbuf);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -139,14 +269,14 @@ void hila_fft<cmplx_t>::gather_data() {
     pencil_MPI_timer.start();
 
     // post receive and send
-    int n_comms = hila_pencil_comms[dir].size() - 1;
+    int n_comms = pencil_comms[dir].size() - 1;
 
     std::vector<MPI_Request> sendreq(n_comms), recreq(n_comms);
     std::vector<MPI_Status> stat(n_comms);
 
     int i = 0;
     int j = 0;
-    for (auto &fn : hila_pencil_comms[dir]) {
+    for (auto &fn : pencil_comms[dir]) {
         if (fn.node != hila::myrank()) {
 
             size_t siz = fn.recv_buf_size * elements * sizeof(cmplx_t);
@@ -165,7 +295,7 @@ void hila_fft<cmplx_t>::gather_data() {
     }
 
     i = 0;
-    for (auto &fn : hila_pencil_comms[dir]) {
+    for (auto &fn : pencil_comms[dir]) {
         if (fn.node != hila::myrank()) {
 
             cmplx_t *p = send_buf + fn.column_offset * elements;
@@ -198,14 +328,14 @@ void hila_fft<cmplx_t>::scatter_data() {
     extern hila::timer pencil_MPI_timer;
     pencil_MPI_timer.start();
 
-    int n_comms = hila_pencil_comms[dir].size() - 1;
+    int n_comms = pencil_comms[dir].size() - 1;
 
     std::vector<MPI_Request> sendreq(n_comms), recreq(n_comms);
     std::vector<MPI_Status> stat(n_comms);
 
     int i = 0;
 
-    for (auto &fn : hila_pencil_comms[dir]) {
+    for (auto &fn : pencil_comms[dir]) {
         if (fn.node != hila::myrank()) {
             cmplx_t *p = send_buf + fn.column_offset * elements;
             int n = fn.column_number * elements * lattice.mynode.size[dir] * sizeof(cmplx_t);
@@ -219,7 +349,7 @@ void hila_fft<cmplx_t>::scatter_data() {
 
     i = 0;
     int j = 0;
-    for (auto &fn : hila_pencil_comms[dir]) {
+    for (auto &fn : pencil_comms[dir]) {
         if (fn.node != hila::myrank()) {
 
             MPI_Isend(rec_p[j], (int)(fn.recv_buf_size * elements * sizeof(cmplx_t)), MPI_BYTE, fn.node,
@@ -250,10 +380,9 @@ void hila_fft<cmplx_t>::scatter_data() {
 
 template <typename cmplx_t>
 inline void hila_fft<cmplx_t>::reflect() {
-    extern unsigned hila_fft_my_columns[NDIM];
     extern hila::timer fft_plan_timer, fft_buffer_timer, fft_execute_timer;
 
-    const int ncols = hila_fft_my_columns[dir] * elements;
+    const int ncols = my_columns[dir] * elements;
 
     const int length = lattice.size(dir);
 
@@ -284,4 +413,359 @@ inline void hila_fft<cmplx_t>::reflect() {
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////
+/// Half k-lattice of real-to-complex transforms.  Data is held in host memory,
+/// in layout where direction dir goes fastest and then the other directions in order
+/// (like pencil_get_buffer_offsets() with elements = 1).
+///////////////////////////////////////////////////////////////////////////////////
+
+inline void half_lattice_offsets(Direction dir, const CoordinateVector &hsize,
+                                 CoordinateVector &offset) {
+    offset[dir] = 1;
+    int s = hsize[dir];
+    foralldir(d) if (d != dir) {
+        offset[d] = s;
+        s *= hsize[d];
+    }
+}
+
+/// copy half k-lattice data from the layout of dir_in to the layout of dir_out
+template <typename cmplx_t>
+void half_lattice_reshuffle(const cmplx_t *in, Direction dir_in, cmplx_t *out,
+                            Direction dir_out, const CoordinateVector &hsize) {
+
+    extern hila::timer pencil_reshuffle_timer;
+    pencil_reshuffle_timer.start();
+
+    CoordinateVector offset_in, offset_out, v;
+    half_lattice_offsets(dir_in, hsize, offset_in);
+    half_lattice_offsets(dir_out, hsize, offset_out);
+
+    size_t volume = 1;
+    foralldir(d) volume *= hsize[d];
+
+    v.fill(0);
+    for (size_t i = 0; i < volume; i++) {
+        out[offset_out.dot(v)] = in[offset_in.dot(v)];
+
+        // next site, e_x fastest
+        foralldir(d) {
+            if (++v[d] < hsize[d])
+                break;
+            v[d] = 0;
+        }
+    }
+
+    pencil_reshuffle_timer.stop();
+}
+
+/// Complex fft of the half k-lattice data (layout e_x fastest) to all directions
+/// except e_x.  hila_fft must have been constructed with half_lattice = true
+
+template <typename cmplx_t>
+void hila_fft<cmplx_t>::half_lattice_transform(cmplx_t *data, const CoordinateVector &hsize) {
+
+    assert(half_lattice && elements == 1);
+
+    bool first_dir = true;
+    Direction prev_dir = e_x;
+
+    foralldir(dir) {
+        if (dir != e_x) {
+
+            setup_direction(dir);
+
+            if (first_dir) {
+                half_lattice_reshuffle(data, e_x, send_buf, dir, hsize);
+            } else {
+                half_lattice_reshuffle(receive_buf, prev_dir, send_buf, dir, hsize);
+            }
+
+            gather_data();
+
+            transform();
+
+            scatter_data();
+
+            prev_dir = dir;
+            first_dir = false;
+
+            swap_buffers();
+        }
+    }
+
+    if (!first_dir)
+        half_lattice_reshuffle(receive_buf, prev_dir, data, e_x, hsize);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// Real-to-complex and complex-to-real transforms to direction e_x.
+/// The real field is collected to e_x -pencils as in hila_fft<real_t>, transformed
+/// with fftw r2c, and only the k_x = 0 ... size(e_x)/2 half of the result is sent back,
+/// to the nodes of the half k-lattice (see fft_half_node_range()).
+/// complex_to_real() does the inverse.
+//////////////////////////////////////////////////////////////////////////////////////
+
+template <typename real_t>
+class hila_fft_real {
+  public:
+    using cmplx_t = Complex<real_t>;
+
+    // real data pencils
+    hila_fft<real_t> rfft;
+
+    int length, half_length;
+
+    // half k-lattice of this node
+    CoordinateVector hmin, hsize;
+
+    // k_x -ranges of the nodes in the e_x -pencil
+    std::vector<int> half_min, half_size;
+
+    // half spectrum of the columns this node transforms, and MPI buffer
+    std::vector<cmplx_t> columns, mpi_buf;
+
+    hila_fft_real() : rfft(1, fft_direction::forward) {
+
+        rfft.setup_direction(e_x);
+
+        length = lattice.size(e_x);
+        half_length = length / 2 + 1;
+
+        fft_half_node_range(lattice.mynode.min, lattice.mynode.size, hmin, hsize);
+
+        for (auto &fn : hila_pencil_comms[e_x]) {
+            const node_info &n = lattice.nodes.nodelist[fn.node];
+            CoordinateVector m, s;
+            fft_half_node_range(n.min, n.size, m, s);
+            half_min.push_back(m[e_x]);
+            half_size.push_back(s[e_x]);
+        }
+
+        columns.resize(hila_fft_my_columns[e_x] * half_length);
+        mpi_buf.resize(columns.size());
+    }
+
+    /// Real field f to the half k-lattice array hbuf, layout e_x fastest
+    void real_to_complex(const Field<real_t> &f, cmplx_t *hbuf) {
+
+        extern hila::timer fft_buffer_timer, fft_execute_timer;
+        extern hila_saved_fftwplan_t hila_saved_fftwplan;
+
+        constexpr bool is_float = std::is_same<real_t, float>::value;
+        const int ncols = hila_fft_my_columns[e_x];
+
+        rfft.collect_data(f);
+        rfft.gather_data();
+
+        if (ncols > 0) {
+            auto &plan = hila_saved_fftwplan.get_plan(e_x, length, ncols, FFTW_FORWARD, is_float,
+                                                      hila_saved_fftwplan_t::kind_t::r2c);
+
+            real_t *in;
+            if (rfft.rec_p.size() == 1) {
+                in = rfft.rec_p[0];
+            } else {
+                in = (real_t *)hila_saved_fftwplan.get_work_buf(sizeof(real_t) * length * ncols);
+
+                fft_buffer_timer.start();
+                for (int i = 0; i < ncols; i++) {
+                    real_t *rp = in + i * length;
+                    for (int j = 0; j < rfft.rec_p.size(); j++) {
+                        memcpy(rp, rfft.rec_p[j] + i * rfft.rec_size[j],
+                               sizeof(real_t) * rfft.rec_size[j]);
+                        rp += rfft.rec_size[j];
+                    }
+                }
+                fft_buffer_timer.stop();
+            }
+
+            fft_execute_timer.start();
+            hila_fftw_execute(plan, in, columns.data());
+            fft_execute_timer.stop();
+        }
+
+        send_half_columns(hbuf);
+    }
+
+    /// Half k-lattice array hbuf (e_x fastest) to real field f.  hbuf is not modified
+    void complex_to_real(const cmplx_t *hbuf, Field<real_t> &f) {
+
+        extern hila::timer fft_buffer_timer, fft_execute_timer;
+        extern hila_saved_fftwplan_t hila_saved_fftwplan;
+
+        constexpr bool is_float = std::is_same<real_t, float>::value;
+        const int ncols = hila_fft_my_columns[e_x];
+
+        receive_half_columns(hbuf);
+
+        if (ncols > 0) {
+            auto &plan = hila_saved_fftwplan.get_plan(e_x, length, ncols, FFTW_BACKWARD, is_float,
+                                                      hila_saved_fftwplan_t::kind_t::c2r);
+
+            if (rfft.rec_p.size() == 1) {
+                fft_execute_timer.start();
+                hila_fftw_execute(plan, columns.data(), rfft.rec_p[0]);
+                fft_execute_timer.stop();
+            } else {
+                real_t *out =
+                    (real_t *)hila_saved_fftwplan.get_work_buf(sizeof(real_t) * length * ncols);
+
+                fft_execute_timer.start();
+                hila_fftw_execute(plan, columns.data(), out);
+                fft_execute_timer.stop();
+
+                fft_buffer_timer.start();
+                for (int i = 0; i < ncols; i++) {
+                    real_t *rp = out + i * length;
+                    for (int j = 0; j < rfft.rec_p.size(); j++) {
+                        memcpy(rfft.rec_p[j] + i * rfft.rec_size[j], rp,
+                               sizeof(real_t) * rfft.rec_size[j]);
+                        rp += rfft.rec_size[j];
+                    }
+                }
+                fft_buffer_timer.stop();
+            }
+        }
+
+        rfft.scatter_data();
+        rfft.swap_buffers();
+        rfft.save_result(f);
+    }
+
+    /// Send the k_x -ranges of the transformed columns to the nodes of the half k-lattice.
+    /// The nodes get the same columns they sent in gather_data().
+    void send_half_columns(cmplx_t *hbuf) {
+
+        extern hila::timer pencil_MPI_timer, fft_buffer_timer;
+
+        const int ncols = hila_fft_my_columns[e_x];
+        const auto &comms = hila_pencil_comms[e_x];
+
+        // pack the k_x -ranges of the nodes one after another
+        fft_buffer_timer.start();
+        std::vector<cmplx_t *> block(comms.size());
+        cmplx_t *bp = mpi_buf.data();
+        for (int j = 0; j < comms.size(); j++) {
+            block[j] = bp;
+            for (int i = 0; i < ncols; i++) {
+                memcpy(bp, columns.data() + i * half_length + half_min[j],
+                       sizeof(cmplx_t) * half_size[j]);
+                bp += half_size[j];
+            }
+        }
+        fft_buffer_timer.stop();
+
+        pencil_MPI_timer.start();
+
+        int n_comms = comms.size() - 1;
+        std::vector<MPI_Request> sendreq(n_comms), recreq(n_comms);
+        std::vector<MPI_Status> stat(n_comms);
+
+        int i = 0;
+        for (auto &fn : comms) {
+            cmplx_t *p = hbuf + (fn.column_offset / lattice.mynode.size[e_x]) * hsize[e_x];
+            int n = fn.column_number * hsize[e_x] * sizeof(cmplx_t);
+
+            if (fn.node != hila::myrank()) {
+                MPI_Irecv(p, n, MPI_BYTE, fn.node, WRK_SCATTER_TAG, lattice.mpi_comm_lat,
+                          &recreq[i]);
+                i++;
+            }
+        }
+
+        i = 0;
+        int j = 0;
+        for (auto &fn : comms) {
+            int n = ncols * half_size[j] * sizeof(cmplx_t);
+
+            if (fn.node != hila::myrank()) {
+                MPI_Isend(block[j], n, MPI_BYTE, fn.node, WRK_SCATTER_TAG, lattice.mpi_comm_lat,
+                          &sendreq[i]);
+                i++;
+            } else {
+                // own columns directly
+                cmplx_t *p = hbuf + (fn.column_offset / lattice.mynode.size[e_x]) * hsize[e_x];
+                memcpy(p, block[j], n);
+            }
+            j++;
+        }
+
+        if (n_comms > 0) {
+            MPI_Waitall(n_comms, recreq.data(), stat.data());
+            MPI_Waitall(n_comms, sendreq.data(), stat.data());
+        }
+
+        pencil_MPI_timer.stop();
+    }
+
+    /// Inverse of send_half_columns(): collect the half spectrum of the columns
+    void receive_half_columns(const cmplx_t *hbuf) {
+
+        extern hila::timer pencil_MPI_timer, fft_buffer_timer;
+
+        const int ncols = hila_fft_my_columns[e_x];
+        const auto &comms = hila_pencil_comms[e_x];
+
+        pencil_MPI_timer.start();
+
+        int n_comms = comms.size() - 1;
+        std::vector<MPI_Request> sendreq(n_comms), recreq(n_comms);
+        std::vector<MPI_Status> stat(n_comms);
+
+        std::vector<cmplx_t *> block(comms.size());
+        cmplx_t *bp = mpi_buf.data();
+
+        int i = 0;
+        int j = 0;
+        for (auto &fn : comms) {
+            block[j] = bp;
+            int n = ncols * half_size[j] * sizeof(cmplx_t);
+
+            if (fn.node != hila::myrank()) {
+                MPI_Irecv(block[j], n, MPI_BYTE, fn.node, WRK_GATHER_TAG, lattice.mpi_comm_lat,
+                          &recreq[i]);
+                i++;
+            }
+            bp += ncols * half_size[j];
+            j++;
+        }
+
+        i = 0;
+        j = 0;
+        for (auto &fn : comms) {
+            const cmplx_t *p =
+                hbuf + (fn.column_offset / lattice.mynode.size[e_x]) * hsize[e_x];
+            int n = fn.column_number * hsize[e_x] * sizeof(cmplx_t);
+
+            if (fn.node != hila::myrank()) {
+                MPI_Isend((void *)p, n, MPI_BYTE, fn.node, WRK_GATHER_TAG, lattice.mpi_comm_lat,
+                          &sendreq[i]);
+                i++;
+            } else {
+                memcpy(block[j], p, n);
+            }
+            j++;
+        }
+
+        if (n_comms > 0) {
+            MPI_Waitall(n_comms, recreq.data(), stat.data());
+            MPI_Waitall(n_comms, sendreq.data(), stat.data());
+        }
+
+        pencil_MPI_timer.stop();
+
+        // and unpack to columns
+        fft_buffer_timer.start();
+        for (j = 0; j < comms.size(); j++) {
+            for (i = 0; i < ncols; i++) {
+                memcpy(columns.data() + i * half_length + half_min[j],
+                       block[j] + i * half_size[j], sizeof(cmplx_t) * half_size[j]);
+            }
+        }
+        fft_buffer_timer.stop();
+    }
+};
+
+
 #endif
\ No newline at end of file
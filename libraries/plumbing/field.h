@@ -21,6 +21,7 @@
 #include "plumbing/backend_vector/vector_types.h"
 
 #include "plumbing/com_mpi.h"
+#include "plumbing/com_shm.h"
 
 
 // This is a marker for hilapp -- will be removed by it
@@ -33,6 +34,9 @@ template <typename T>
 void ensure_field_operators_exist();
 
 #include "plumbing/ensure_loop_functions.h"
+#ifdef FIELD_EXPRESSIONS
+#include "plumbing/field_expr.h"
+#endif
 
 /**
  * @class Field
@@ -90,6 +94,9 @@ class Field {
 
         MPI_Request receive_request[3][NDIRS];
         MPI_Request send_request[3][NDIRS];
+        // intra-node shared memory transfers
+        hila::shm::request shm_receive_request[3][NDIRS];
+        hila::shm::request shm_send_request[3][NDIRS];
 #ifndef VANILLA
         // vanilla needs no special receive buffers
         T *receive_buffer[NDIRS];
@@ -117,7 +124,7 @@ class Field {
          */
         void free_communication() {
             for (int d = 0; d < NDIRS; d++) {
-                if (send_buffer[d] != nullptr)
+                if (send_buffer[d] != nullptr && !hila::shm::deallocate(send_buffer[d]))
                     payload.free_mpi_buffer(send_buffer[d]);
 #ifndef VANILLA
                 if (receive_buffer[d] != nullptr)
@@ -346,6 +353,24 @@ class Field {
         rhs.fs = nullptr;
     }
 
+#ifdef FIELD_EXPRESSIONS
+    /**
+     * @internal
+     * @brief Construct a new Field from a Field expression, e.g. `Field<MyType> f = g + 2*h;`
+     * The expression is evaluated in one site loop, see field_expr.h
+     * @tparam E expression type
+     * @param expr
+     */
+    template <typename E,
+              std::enable_if_t<hila::is_field_expr<E>::value &&
+                                   (hila::is_assignable<T &, typename E::value_type>::value ||
+                                    std::is_convertible<typename E::value_type, T>::value),
+                               int> = 0>
+    Field(const E &expr) : Field() {
+        hila::assign_field_expr(*this, expr);
+    }
+#endif
+
     ~Field() {
         free();
 
@@ -834,6 +859,32 @@ class Field {
         return *this;
     }
 
+#ifdef FIELD_EXPRESSIONS
+    /**
+     * @brief Assignment from a Field expression
+     * @details Operators + - * / and methods conj(), dagger(), real(), imag() acting on Fields
+     * return expressions, which are evaluated here in a single site loop without temporary
+     * Fields:
+     *
+     * \code{.cpp}
+     * f = g + a * h.conj();   // equivalent to f[ALL] = g[X] + a * conj(h[X]);
+     * \endcode
+     *
+     * @tparam E expression type
+     * @param expr
+     * @return Field<T>& Assigned field
+     */
+    template <typename E,
+              std::enable_if_t<hila::is_field_expr<E>::value &&
+                                   (hila::is_assignable<T &, typename E::value_type>::value ||
+                                    std::is_convertible<typename E::value_type, T>::value),
+                               int> = 0>
+    Field<T> &operator=(const E &expr) {
+        hila::assign_field_expr(*this, expr);
+        return *this;
+    }
+#endif
+
     /**
      * @brief Addition assignment operator
      * @details Addition assignmen operator can be called in the following ways as long as types are
@@ -1027,6 +1078,84 @@ class Field {
         return *this;
     }
 
+#ifdef FIELD_EXPRESSIONS
+    /**
+     * @internal
+     * @brief += with a Field expression, evaluated in one loop as f = f + (expr)
+     *
+     * @tparam E expression type
+     * @param rhs expression
+     * @return Field<T>&
+     */
+    template <typename E, typename Ed = std::decay_t<E>,
+              std::enable_if_t<hila::is_field_expr<Ed>::value &&
+                                   std::is_convertible<hila::type_plus<T, typename Ed::value_type>,
+                                                       T>::value,
+                               int> = 0>
+    Field<T> &operator+=(E &&rhs) {
+        auto expr = hila::make_field_expr<hila::expr_plus>(*this, std::forward<E>(rhs));
+        hila::assign_field_expr(*this, expr);
+        return *this;
+    }
+
+    /**
+     * @internal
+     * @brief -= with a Field expression, evaluated in one loop as f = f - (expr)
+     *
+     * @tparam E expression type
+     * @param rhs expression
+     * @return Field<T>&
+     */
+    template <typename E, typename Ed = std::decay_t<E>,
+              std::enable_if_t<hila::is_field_expr<Ed>::value &&
+                                   std::is_convertible<hila::type_minus<T, typename Ed::value_type>,
+                                                       T>::value,
+                               int> = 0>
+    Field<T> &operator-=(E &&rhs) {
+        auto expr = hila::make_field_expr<hila::expr_minus>(*this, std::forward<E>(rhs));
+        hila::assign_field_expr(*this, expr);
+        return *this;
+    }
+
+    /**
+     * @internal
+     * @brief *= with a Field expression, evaluated in one loop as f = f * (expr)
+     *
+     * @tparam E expression type
+     * @param rhs expression
+     * @return Field<T>&
+     */
+    template <typename E, typename Ed = std::decay_t<E>,
+              std::enable_if_t<hila::is_field_expr<Ed>::value &&
+                                   std::is_convertible<hila::type_mul<T, typename Ed::value_type>,
+                                                       T>::value,
+                               int> = 0>
+    Field<T> &operator*=(E &&rhs) {
+        auto expr = hila::make_field_expr<hila::expr_mul>(*this, std::forward<E>(rhs));
+        hila::assign_field_expr(*this, expr);
+        return *this;
+    }
+
+    /**
+     * @internal
+     * @brief /= with a Field expression, evaluated in one loop as f = f / (expr)
+     *
+     * @tparam E expression type
+     * @param rhs expression
+     * @return Field<T>&
+     */
+    template <typename E, typename Ed = std::decay_t<E>,
+              std::enable_if_t<hila::is_field_expr<Ed>::value &&
+                                   std::is_convertible<hila::type_div<T, typename Ed::value_type>,
+                                                       T>::value,
+                               int> = 0>
+    Field<T> &operator/=(E &&rhs) {
+        auto expr = hila::make_field_expr<hila::expr_div>(*this, std::forward<E>(rhs));
+        hila::assign_field_expr(*this, expr);
+        return *this;
+    }
+#endif
+
     // Unary + and -
 
     /**
@@ -1041,13 +1170,22 @@ class Field {
     /**
      * @brief Unary - operator, acts as negation to all field elements
      *
-     * @return Field<T> Returns negated version of itself
+     * @return Field expression of the negated field, see field_expr.h
      */
+#ifdef FIELD_EXPRESSIONS
+    auto operator-() const & {
+        return hila::make_field_expr<hila::expr_negate>(*this);
+    }
+    auto operator-() && {
+        return hila::make_field_expr<hila::expr_negate>(std::move(*this));
+    }
+#else
     Field<T> operator-() const {
         Field<T> f;
         f[ALL] = -(*this)[X];
         return f;
     }
+#endif
 
     /**
      * @brief Field comparison operator.
@@ -1102,6 +1240,68 @@ class Field {
         return sqrt(squarenorm());
     }
 
+#ifdef FIELD_EXPRESSIONS
+    /**
+     * @brief Returns field with all elements conjugated depending how conjugate is defined for type
+     * @details The result is a Field expression (see field_expr.h), which is evaluated when
+     * assigned to a Field, e.g. `g = f.conj() * f;` is a single site loop.
+     *
+     * @return Field expression
+     */
+    auto conj() const & {
+        return hila::make_field_expr<hila::expr_conj>(*this);
+    }
+    auto conj() && {
+        return hila::make_field_expr<hila::expr_conj>(std::move(*this));
+    }
+
+    /**
+     * @brief Returns dagger or Hermitian conjugate of Field depending on how it is
+     * defined for Field type T
+     *
+     * @return Field expression
+     */
+    template <typename R = T, typename A = decltype(::dagger(std::declval<R>()))>
+    auto dagger() const & {
+        return hila::make_field_expr<hila::expr_dagger>(*this);
+    }
+    template <typename R = T, typename A = decltype(::dagger(std::declval<R>()))>
+    auto dagger() && {
+        return hila::make_field_expr<hila::expr_dagger>(std::move(*this));
+    }
+
+    /**
+     * @brief Returns real part of Field
+     *
+     * @tparam R Field current type
+     * @tparam A Field real part type
+     * @return Field expression, convertible to Field<A>
+     */
+    template <typename R = T, typename A = decltype(::real(std::declval<R>()))>
+    auto real() const & {
+        return hila::make_field_expr<hila::expr_real>(*this);
+    }
+    template <typename R = T, typename A = decltype(::real(std::declval<R>()))>
+    auto real() && {
+        return hila::make_field_expr<hila::expr_real>(std::move(*this));
+    }
+
+    /**
+     * @brief Returns imaginary part of Field
+     *
+     * @tparam R Field current type
+     * @tparam A Field imaginary part type
+     * @return Field expression, convertible to Field<A>
+     */
+    template <typename R = T, typename A = decltype(::imag(std::declval<R>()))>
+    auto imag() const & {
+        return hila::make_field_expr<hila::expr_imag>(*this);
+    }
+    template <typename R = T, typename A = decltype(::imag(std::declval<R>()))>
+    auto imag() && {
+        return hila::make_field_expr<hila::expr_imag>(std::move(*this));
+    }
+#else
     /**
      * @brief Returns field with all elements conjugated depending how conjugate is defined for type
      *
@@ -1153,6 +1353,7 @@ class Field {
         f[ALL] = ::imag((*this)[X]);
         return f;
     }
+#endif
     /** @} */
 
     // Communication routines. These are all internal.
@@ -1393,6 +1594,10 @@ class Field {
     void read(std::ifstream &inputfile);
     void read(const std::string &filename);
 
+    // Collective MPI-IO write/read of the field at byte offset of an open file
+    void write_parallel(MPI_File &fh, MPI_Offset offset) const;
+    void read_parallel(MPI_File &fh, MPI_Offset offset);
+
     void write_subvolume(std::ofstream &outputfile, const CoordinateVector &cmin,
                          const CoordinateVector &cmax, int precision = 6) const;
     void write_subvolume(const std::string &filenname, const CoordinateVector &cmin,
@@ -1472,6 +1677,44 @@ class Field {
 
 }; // End of class Field<>
 
+#ifdef FIELD_EXPRESSIONS
+///////////////////////////////
+// operators +-*/
+// These return Field expressions (field_expr.h), which are evaluated in a single site loop
+// when assigned to a Field.  The operators accept Field and expression operands, and scalars
+// with at least one Field operand.  They rely on SFINAE, OK if the operation
+// is defined for the elements, e.g. hila::type_plus<A,B> exists for Field<A> + Field<B>.
+
+/// operator +: sum of Fields, Field expressions and scalars
+template <typename L, typename R,
+          std::enable_if_t<hila::is_field_expr_binary_op<hila::expr_plus, L, R>::value, int> = 0>
+auto operator+(L &&lhs, R &&rhs) {
+    return hila::make_field_expr<hila::expr_plus>(std::forward<L>(lhs), std::forward<R>(rhs));
+}
+
+/// operator -: difference of Fields, Field expressions and scalars
+template <typename L, typename R,
+          std::enable_if_t<hila::is_field_expr_binary_op<hila::expr_minus, L, R>::value, int> = 0>
+auto operator-(L &&lhs, R &&rhs) {
+    return hila::make_field_expr<hila::expr_minus>(std::forward<L>(lhs), std::forward<R>(rhs));
+}
+
+/// operator *: product of Fields, Field expressions and scalars
+template <typename L, typename R,
+          std::enable_if_t<hila::is_field_expr_binary_op<hila::expr_mul, L, R>::value, int> = 0>
+auto operator*(L &&lhs, R &&rhs) {
+    return hila::make_field_expr<hila::expr_mul>(std::forward<L>(lhs), std::forward<R>(rhs));
+}
+
+/// operator /: division of Fields, Field expressions and scalars
+template <typename L, typename R,
+          std::enable_if_t<hila::is_field_expr_binary_op<hila::expr_div, L, R>::value, int> = 0>
+auto operator/(L &&lhs, R &&rhs) {
+    return hila::make_field_expr<hila::expr_div>(std::forward<L>(lhs), std::forward<R>(rhs));
+}
+
+#else
+
 ///////////////////////////////
 // operators +-*/
 // these operators rely on SFINAE, OK if field_hila::type_plus<A,B> exists i.e. A+B is
@@ -1743,6 +1986,8 @@ auto operator/(Field<A> lhs, const B &rhs) {
     return lhs;
 }
 
+#endif
+
 namespace hila {
 
 /**
@@ -1862,6 +2107,32 @@ double norm(const Field<T> &arg) {
     return sqrt(squarenorm(arg));
 }
 
+#ifdef FIELD_EXPRESSIONS
+// conj, dagger, real and imag of Fields and Field expressions return expressions too
+template <typename F,
+          std::enable_if_t<hila::is_field_expr_unary_op<hila::expr_conj, F>::value, int> = 0>
+auto conj(F &&arg) {
+    return hila::make_field_expr<hila::expr_conj>(std::forward<F>(arg));
+}
+
+template <typename F,
+          std::enable_if_t<hila::is_field_expr_unary_op<hila::expr_dagger, F>::value, int> = 0>
+auto dagger(F &&arg) {
+    return hila::make_field_expr<hila::expr_dagger>(std::forward<F>(arg));
+}
+
+template <typename F,
+          std::enable_if_t<hila::is_field_expr_unary_op<hila::expr_real, F>::value, int> = 0>
+auto real(F &&arg) {
+    return hila::make_field_expr<hila::expr_real>(std::forward<F>(arg));
+}
+
+template <typename F,
+          std::enable_if_t<hila::is_field_expr_unary_op<hila::expr_imag, F>::value, int> = 0>
+auto imag(F &&arg) {
+    return hila::make_field_expr<hila::expr_imag>(std::forward<F>(arg));
+}
+#else
 template <typename T>
 Field<T> conj(const Field<T> &arg) {
     return arg.conj();
@@ -1881,7 +2152,7 @@ template <typename T, typename A = decltype(::imag(std::declval<T>()))>
 Field<A> imag(const Field<T> &arg) {
     return arg.imag();
 }
-
+#endif
 
 template <typename A, typename B, typename R = decltype(std::declval<A>() - std::declval<B>())>
 double squarenorm_relative(const Field<A> &a, const Field<B> &b) {
@@ -315,6 +315,10 @@ dir_mask_t Field<T>::start_gather(Direction d, Parity p) const {
 
     int par_i = static_cast<int>(par) - 1; // index to dim-3 arrays
 
+    if (hila::event_trace_on)
+        hila::trace_record(hila::trace_gather_name((int)d, par_i), 'b', 0,
+                           (reinterpret_cast<uint64_t>(fs) << 5) + 3 * (int)d + par_i);
+
     constexpr size_t size = sizeof(T);
 
     T *receive_buffer;
@@ -338,14 +342,20 @@ dir_mask_t Field<T>::start_gather(Direction d, Parity p) const {
             hila::terminate(1);
         }
 
-        post_receive_timer.start();
+        if (hila::shm::is_on_node(from_node.rank)) {
+            // neighbour on the same node, data is read in wait_gather
+            hila::shm::expect(d, tag, fs->shm_receive_request[par_i][d]);
+        } else {
+
+            post_receive_timer.start();
 
-        // c++ version does not return errors
-        // was mpi_type
-        MPI_Irecv(receive_buffer, (int)n, MPI_BYTE, from_node.rank, tag, lattice.mpi_comm_lat,
-                  &fs->receive_request[par_i][d]);
+            // c++ version does not return errors
+            // was mpi_type
+            MPI_Irecv(receive_buffer, (int)n, MPI_BYTE, from_node.rank, tag,
+                      lattice.mpi_comm_lat, &fs->receive_request[par_i][d]);
 
-        post_receive_timer.stop();
+            post_receive_timer.stop();
+        }
     }
 
     if (to_node.rank != hila::myrank() && boundary_need_to_communicate(-d)) {
@@ -353,6 +363,9 @@ dir_mask_t Field<T>::start_gather(Direction d, Parity p) const {
 
         unsigned sites = to_node.n_sites(par);
 
+        // send buffer to a neighbour on the same node is in shared memory, if there's room
+        if (fs->send_buffer[d] == nullptr && hila::shm::is_on_node(to_node.rank))
+            fs->send_buffer[d] = (T *)hila::shm::allocate(to_node.sites * size);
         if (fs->send_buffer[d] == nullptr)
             fs->send_buffer[d] = fs->payload.allocate_mpi_buffer(to_node.sites);
 
@@ -370,13 +383,18 @@ dir_mask_t Field<T>::start_gather(Direction d, Parity p) const {
         // gpuDeviceSynchronize();
 #endif
 
-        start_send_timer.start();
+        // post() returns false if send_buffer is not in shared memory, then use MPI
+        if (!hila::shm::is_on_node(to_node.rank) ||
+            !hila::shm::post(d, send_buffer, n, tag, fs->shm_send_request[par_i][d])) {
 
-        // was mpi_type
-        MPI_Isend(send_buffer, (int)n, MPI_BYTE, to_node.rank, tag, lattice.mpi_comm_lat,
-                  &fs->send_request[par_i][d]);
+            start_send_timer.start();
 
-        start_send_timer.stop();
+            // was mpi_type
+            MPI_Isend(send_buffer, (int)n, MPI_BYTE, to_node.rank, tag, lattice.mpi_comm_lat,
+                      &fs->send_request[par_i][d]);
+
+            start_send_timer.stop();
+        }
     }
 
     // and do the boundary shuffle here, after MPI has started
@@ -455,13 +473,24 @@ void Field<T>::wait_gather(Direction d, Parity p) const {
 
         int par_i = (int)par - 1;
 
+        bool shm_receive = false;
+
         if (from_node.rank != hila::myrank() && boundary_need_to_communicate(d)) {
-            wait_receive_timer.start();
 
-            MPI_Status status;
-            MPI_Wait(&fs->receive_request[par_i][d], &status);
+            if (hila::shm::is_on_node(from_node.rank)) {
+                // copy directly from the send buffer of the neighbour
+                hila::shm::receive(d, from_node.rank, fs->get_receive_buffer(d, par, from_node),
+                                   from_node.n_sites(par) * sizeof(T),
+                                   fs->shm_receive_request[par_i][d]);
+                shm_receive = !fs->shm_receive_request[par_i][d].via_mpi;
+            } else {
+                wait_receive_timer.start();
+
+                MPI_Status status;
+                MPI_Wait(&fs->receive_request[par_i][d], &status);
 
-            wait_receive_timer.stop();
+                wait_receive_timer.stop();
+            }
 
 #if !defined(VANILLA) && !defined(MPI_BENCHMARK_TEST) 
             fs->place_comm_elements(d, par, fs->get_receive_buffer(d, par, from_node), from_node);
@@ -470,17 +499,27 @@ void Field<T>::wait_gather(Direction d, Parity p) const {
 
         // then wait for the sends
         if (to_node.rank != hila::myrank() && boundary_need_to_communicate(-d)) {
-            wait_send_timer.start();
-            MPI_Status status;
-            MPI_Wait(&fs->send_request[par_i][d], &status);
-            wait_send_timer.stop();
+            if (hila::shm::is_on_node(to_node.rank) && !fs->shm_send_request[par_i][d].via_mpi) {
+                hila::shm::wait_sent(d, fs->shm_send_request[par_i][d]);
+            } else {
+                wait_send_timer.start();
+                MPI_Status status;
+                MPI_Wait(&fs->send_request[par_i][d], &status);
+                wait_send_timer.stop();
+            }
         }
 
         // Mark the parity gathered from Direction dir
         mark_gathered(d, par);
 
+        if (hila::event_trace_on)
+            hila::trace_record(hila::trace_gather_name((int)d, par_i), 'e', 0,
+                               (reinterpret_cast<uint64_t>(fs) << 5) + 3 * (int)d + par_i);
+
         // Keep count of communications
         lattice.n_gather_done += 1;
+        if (shm_receive)
+            lattice.n_gather_shm += 1;
 
         par = opp_parity(par); // flip if 2 loops
     }
@@ -0,0 +1,493 @@
+/**
+ * @file field_expr.h
+ * @brief Lazily evaluated arithmetic expressions of whole Fields
+ * @details Included from field.h when FIELD_EXPRESSIONS is defined (see params.h).  Then the
+ * operators + - * / and the conj/dagger/real/imag helpers acting on Field variables do not
+ * evaluate immediately, they return a light expression object which records the operands.
+ * The expression is evaluated in a single site loop when it is assigned to a Field:
+ *
+ * \code{.cpp}
+ * Field<Complex<double>> a, b, c, d;
+ * . . .
+ * a = b + 2.0 * c.conj() - d;    // one loop, no temporary Fields
+ * \endcode
+ *
+ * This is equivalent to `a[ALL] = b[X] + 2.0 * ::conj(c[X]) - d[X];`.  The loop is an ordinary
+ * onsites() loop (see field_expr_loop() below), which hilapp transforms like any other.
+ * The site loops are written out for 1 - 4 Field operands;
+ * if an expression contains more Field variables, the larger subexpression is first
+ * evaluated to a temporary Field.
+ *
+ * Lvalue Field operands are referenced, rvalue Fields (function return values) are moved
+ * into the expression object.  Thus an expression must not outlive the Field variables it
+ * refers to: do not store it in an `auto` variable, but convert it to a Field.  Note that
+ * `auto x = f + g;` is an expression, not a Field, and sees later changes of f and g.
+ */
+#ifndef FIELD_EXPR_H
+#define FIELD_EXPR_H
+
+#include <tuple>
+#include <type_traits>
+
+template <typename T>
+class Field;
+
+namespace hila {
+
+/// Maximum number of Field operands evaluated in one loop
+constexpr int field_expr_max_fields = 4;
+
+//////////////////////////////////////////////////////////////////////////////
+/// Operations in the expressions.  apply() is called at each site, with element
+/// types (possibly vectorized) as arguments.
+
+struct expr_plus {
+    template <typename A, typename B>
+    static inline auto apply(const A &a, const B &b) -> decltype(a + b) {
+        return a + b;
+    }
+};
+
+struct expr_minus {
+    template <typename A, typename B>
+    static inline auto apply(const A &a, const B &b) -> decltype(a - b) {
+        return a - b;
+    }
+};
+
+struct expr_mul {
+    template <typename A, typename B>
+    static inline auto apply(const A &a, const B &b) -> decltype(a * b) {
+        return a * b;
+    }
+};
+
+struct expr_div {
+    template <typename A, typename B>
+    static inline auto apply(const A &a, const B &b) -> decltype(a / b) {
+        return a / b;
+    }
+};
+
+struct expr_negate {
+    template <typename A>
+    static inline auto apply(const A &a) -> decltype(-a) {
+        return -a;
+    }
+};
+
+struct expr_conj {
+    template <typename A>
+    static inline auto apply(const A &a) -> decltype(::conj(a)) {
+        return ::conj(a);
+    }
+};
+
+struct expr_dagger {
+    template <typename A>
+    static inline auto apply(const A &a) -> decltype(::dagger(a)) {
+        return ::dagger(a);
+    }
+};
+
+struct expr_real {
+    template <typename A>
+    static inline auto apply(const A &a) -> decltype(::real(a)) {
+        return ::real(a);
+    }
+};
+
+struct expr_imag {
+    template <typename A>
+    static inline auto apply(const A &a) -> decltype(::imag(a)) {
+        return ::imag(a);
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// Evaluators: the site-level part of the expressions.  These contain only the
+/// scalar operands, and can be copied into the loop as is.  eval<I>(v...) gets the
+/// values of all Field operands of the expression at a site, the subexpression uses
+/// the ones starting from index I.
+
+template <int I, typename V0, typename... V>
+inline decltype(auto) expr_arg(const V0 &v0, const V &...v) {
+    if constexpr (I == 0)
+        return v0;
+    else
+        return expr_arg<I - 1>(v...);
+}
+
+struct field_expr_field_eval {
+    template <int I, typename... V>
+    inline decltype(auto) eval(const V &...v) const {
+        return expr_arg<I>(v...);
+    }
+};
+
+template <typename S>
+struct field_expr_scalar_eval {
+    S val;
+
+    template <int I, typename... V>
+    inline const S &eval(const V &...v) const {
+        return val;
+    }
+};
+
+template <typename Op, typename L>
+struct field_expr_unary_eval {
+    L l;
+
+    template <int I, typename... V>
+    inline auto eval(const V &...v) const {
+        return Op::apply(l.template eval<I>(v...));
+    }
+};
+
+template <typename Op, typename L, typename R, int nl>
+struct field_expr_binary_eval {
+    L l;
+    R r;
+
+    template <int I, typename... V>
+    inline auto eval(const V &...v) const {
+        return Op::apply(l.template eval<I>(v...), r.template eval<I + nl>(v...));
+    }
+};
+
+/// Top level evaluator, called in the site loop with the Field elements
+template <typename E>
+struct field_expr_evaluator {
+    E e;
+
+    template <typename... V>
+    inline auto operator()(const V &...v) const {
+        return e.template eval<0>(v...);
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// Expression operands ("leaves")
+
+/// Lvalue Field, referenced
+template <typename A>
+struct field_expr_ref {
+    using value_type = A;
+    static constexpr int n_fields = 1;
+
+    const Field<A> *f;
+
+    explicit field_expr_ref(const Field<A> &fld) : f(&fld) {}
+
+    auto fields() const {
+        return std::make_tuple(f);
+    }
+    field_expr_field_eval evaluator() const {
+        return {};
+    }
+};
+
+/// Rvalue Field, owned by the expression
+template <typename A>
+struct field_expr_owned {
+    using value_type = A;
+    static constexpr int n_fields = 1;
+
+    Field<A> f;
+
+    explicit field_expr_owned(Field<A> &&fld) : f(std::move(fld)) {}
+
+    auto fields() const {
+        return std::make_tuple(&f);
+    }
+    field_expr_field_eval evaluator() const {
+        return {};
+    }
+};
+
+/// Scalar, same value at all sites
+template <typename S>
+struct field_expr_scalar {
+    using value_type = S;
+    static constexpr int n_fields = 0;
+
+    S val;
+
+    explicit field_expr_scalar(const S &v) : val(v) {}
+
+    std::tuple<> fields() const {
+        return {};
+    }
+    field_expr_scalar_eval<S> evaluator() const {
+        return {val};
+    }
+};
+
+template <typename L>
+struct field_expr_methods;
+
+/// Unary operation node
+template <typename Op, typename L>
+struct field_expr_unary : field_expr_methods<field_expr_unary<Op, L>> {
+    using value_type = std::decay_t<decltype(Op::apply(std::declval<typename L::value_type>()))>;
+    static constexpr int n_fields = L::n_fields;
+
+    L l;
+
+    explicit field_expr_unary(L &&a) : l(std::move(a)) {}
+
+    auto fields() const {
+        return l.fields();
+    }
+    auto evaluator() const {
+        return field_expr_unary_eval<Op, decltype(l.evaluator())>{l.evaluator()};
+    }
+};
+
+/// Binary operation node
+template <typename Op, typename L, typename R>
+struct field_expr_binary : field_expr_methods<field_expr_binary<Op, L, R>> {
+    using value_type = std::decay_t<decltype(Op::apply(std::declval<typename L::value_type>(),
+                                                       std::declval<typename R::value_type>()))>;
+    static constexpr int n_fields = L::n_fields + R::n_fields;
+
+    L l;
+    R r;
+
+    field_expr_binary(L &&a, R &&b) : l(std::move(a)), r(std::move(b)) {}
+
+    auto fields() const {
+        return std::tuple_cat(l.fields(), r.fields());
+    }
+    auto evaluator() const {
+        return field_expr_binary_eval<Op, decltype(l.evaluator()), decltype(r.evaluator()),
+                                      L::n_fields>{l.evaluator(), r.evaluator()};
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// Type utilities
+
+template <typename T>
+struct is_field_expr : std::false_type {};
+template <typename Op, typename L>
+struct is_field_expr<field_expr_unary<Op, L>> : std::true_type {};
+template <typename Op, typename L, typename R>
+struct is_field_expr<field_expr_binary<Op, L, R>> : std::true_type {};
+
+template <typename T>
+struct is_field_var : std::false_type {};
+template <typename A>
+struct is_field_var<Field<A>> : std::true_type {};
+
+/// True for Field variables and Field expressions
+template <typename T>
+struct is_field_operand
+    : std::integral_constant<bool, is_field_var<std::decay_t<T>>::value ||
+                                       is_field_expr<std::decay_t<T>>::value> {};
+
+/// Expression leaf or node type for operand T (as deduced by a forwarding reference)
+template <typename T, typename Enable = void>
+struct field_expr_operand_struct {
+    using type = field_expr_scalar<std::decay_t<T>>;
+};
+
+template <typename T>
+struct field_expr_operand_struct<T, std::enable_if_t<is_field_expr<std::decay_t<T>>::value>> {
+    using type = std::decay_t<T>;
+};
+
+template <typename A>
+struct field_expr_operand_struct<Field<A> &> {
+    using type = field_expr_ref<A>;
+};
+template <typename A>
+struct field_expr_operand_struct<const Field<A> &> {
+    using type = field_expr_ref<A>;
+};
+template <typename A>
+struct field_expr_operand_struct<Field<A>> {
+    using type = field_expr_owned<A>;
+};
+
+template <typename T>
+using field_expr_operand = typename field_expr_operand_struct<T>::type;
+
+// A forwarding reference deduces T = X& for lvalues and T = X for rvalues.  Use the
+// const-stripped X for rvalues, so that e.g. temporary Fields are moved into the expression
+template <typename T>
+using field_expr_operand_t = field_expr_operand<std::conditional_t<
+    std::is_lvalue_reference<T>::value, T, std::remove_cv_t<std::remove_reference_t<T>>>>;
+
+/// Element type of the operand: Field<A> -> A, scalar S -> S
+template <typename T>
+using field_expr_value_type = typename field_expr_operand_t<T>::value_type;
+
+template <typename Op, typename L, typename R, typename Enable = void>
+struct is_valid_element_op : std::false_type {};
+
+template <typename Op, typename L, typename R>
+struct is_valid_element_op<
+    Op, L, R,
+    std::void_t<decltype(Op::apply(std::declval<field_expr_value_type<L>>(),
+                                   std::declval<field_expr_value_type<R>>()))>> : std::true_type {};
+
+template <typename Op, typename L, typename Enable = void>
+struct is_valid_element_unary_op : std::false_type {};
+
+template <typename Op, typename L>
+struct is_valid_element_unary_op<
+    Op, L, std::void_t<decltype(Op::apply(std::declval<field_expr_value_type<L>>()))>>
+    : std::true_type {};
+
+template <typename L, typename R>
+struct has_field_operand
+    : std::integral_constant<bool, is_field_operand<L>::value || is_field_operand<R>::value> {};
+
+/// Does Op(L, R) make a valid Field expression?  At least one of the operands must be a
+/// Field or a Field expression, and the operation must be defined for the elements.
+/// std::conjunction checks the elements only for Field operands, which avoids recursing
+/// into these operators when the element operators are resolved
+template <typename Op, typename L, typename R>
+using is_field_expr_binary_op =
+    std::conjunction<has_field_operand<L, R>, is_valid_element_op<Op, L, R>>;
+
+template <typename Op, typename L>
+using is_field_expr_unary_op =
+    std::conjunction<is_field_operand<L>, is_valid_element_unary_op<Op, L>>;
+
+//////////////////////////////////////////////////////////////////////////////
+/// Construct expressions
+
+template <typename T>
+field_expr_operand_t<T> to_field_expr(T &&a) {
+    return field_expr_operand_t<T>(std::forward<T>(a));
+}
+
+/// Evaluate expression e to a Field, which becomes an owned operand
+template <typename E>
+field_expr_owned<typename E::value_type> materialize_field_expr(E &&e) {
+    return field_expr_owned<typename E::value_type>(Field<typename E::value_type>(e));
+}
+
+/// Binary node from operands which are already leaves or nodes.  Keeps the number of
+/// Field operands at most field_expr_max_fields, by evaluating the larger side first
+template <typename Op, typename L, typename R>
+auto make_field_expr_binary(L &&l, R &&r) {
+    if constexpr (L::n_fields + R::n_fields <= field_expr_max_fields) {
+        return field_expr_binary<Op, L, R>(std::move(l), std::move(r));
+    } else if constexpr (L::n_fields >= R::n_fields) {
+        return make_field_expr_binary<Op>(materialize_field_expr(std::move(l)), std::move(r));
+    } else {
+        return make_field_expr_binary<Op>(std::move(l), materialize_field_expr(std::move(r)));
+    }
+}
+
+template <typename Op, typename L, typename R>
+auto make_field_expr(L &&l, R &&r) {
+    return make_field_expr_binary<Op>(to_field_expr(std::forward<L>(l)),
+                                      to_field_expr(std::forward<R>(r)));
+}
+
+template <typename Op, typename L>
+auto make_field_expr(L &&l) {
+    using operand = field_expr_operand_t<L>;
+    return field_expr_unary<Op, operand>(to_field_expr(std::forward<L>(l)));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// Evaluation loops, one for each number of Field operands.  These are ordinary
+/// site loops for hilapp, with the evaluator as a loop constant
+
+template <typename T, typename Ev, typename A>
+void field_expr_loop(Field<T> &res, const Ev &ev, const Field<A> &a) {
+    onsites(ALL) res[X] = ev(a[X]);
+}
+
+template <typename T, typename Ev, typename A, typename B>
+void field_expr_loop(Field<T> &res, const Ev &ev, const Field<A> &a, const Field<B> &b) {
+    onsites(ALL) res[X] = ev(a[X], b[X]);
+}
+
+template <typename T, typename Ev, typename A, typename B, typename C>
+void field_expr_loop(Field<T> &res, const Ev &ev, const Field<A> &a, const Field<B> &b,
+                     const Field<C> &c) {
+    onsites(ALL) res[X] = ev(a[X], b[X], c[X]);
+}
+
+template <typename T, typename Ev, typename A, typename B, typename C, typename D>
+void field_expr_loop(Field<T> &res, const Ev &ev, const Field<A> &a, const Field<B> &b,
+                     const Field<C> &c, const Field<D> &d) {
+    onsites(ALL) res[X] = ev(a[X], b[X], c[X], d[X]);
+}
+
+/// Assign expression e to Field res
+template <typename T, typename E>
+void assign_field_expr(Field<T> &res, const E &e) {
+    static_assert(E::n_fields >= 1 && E::n_fields <= field_expr_max_fields,
+                  "Internal error: wrong number of Fields in Field expression");
+
+    field_expr_evaluator<decltype(e.evaluator())> ev{e.evaluator()};
+    std::apply([&](const auto *...f) { field_expr_loop(res, ev, *f...); }, e.fields());
+}
+
+/// Member functions shared by the expression nodes, so that e.g. (a + b).conj() works
+template <typename E>
+struct field_expr_methods {
+    auto conj() const & {
+        return make_field_expr<expr_conj>(static_cast<const E &>(*this));
+    }
+    auto conj() && {
+        return make_field_expr<expr_conj>(std::move(static_cast<E &>(*this)));
+    }
+
+    auto dagger() const & {
+        return make_field_expr<expr_dagger>(static_cast<const E &>(*this));
+    }
+    auto dagger() && {
+        return make_field_expr<expr_dagger>(std::move(static_cast<E &>(*this)));
+    }
+
+    auto real() const & {
+        return make_field_expr<expr_real>(static_cast<const E &>(*this));
+    }
+    auto real() && {
+        return make_field_expr<expr_real>(std::move(static_cast<E &>(*this)));
+    }
+
+    auto imag() const & {
+        return make_field_expr<expr_imag>(static_cast<const E &>(*this));
+    }
+    auto imag() && {
+        return make_field_expr<expr_imag>(std::move(static_cast<E &>(*this)));
+    }
+
+    auto operator-() const & {
+        return make_field_expr<expr_negate>(static_cast<const E &>(*this));
+    }
+    auto operator-() && {
+        return make_field_expr<expr_negate>(std::move(static_cast<E &>(*this)));
+    }
+
+    /// Evaluate to a Field, e.g. for passing the expression to a function template
+    /// taking Field<T> arguments
+    template <typename R = E>
+    Field<typename R::value_type> eval() const {
+        return Field<typename R::value_type>(static_cast<const E &>(*this));
+    }
+
+    /// Comparison with a Field, evaluates the expression first
+    template <typename S>
+    bool operator==(const Field<S> &rhs) const {
+        return eval() == rhs;
+    }
+    template <typename S>
+    bool operator!=(const Field<S> &rhs) const {
+        return !(eval() == rhs);
+    }
+};
+
+} // namespace hila
+
+#endif
@@ -70,6 +70,69 @@ bool close_file(const std::string &filename, S &fstream) {
     return !error;
 }
 
+//////////////////////////////////////////////////////////////////////////////////
+/// Parallel i/o: all ranks open the file with MPI-IO and write/read their own
+/// sublattice directly.  The site order in the file is the same global x-fastest
+/// order as in the rank 0 stream routines, thus the files are identical.
+
+inline bool open_parallel_file(const std::string &filename, MPI_File &fh, bool write) {
+    int mode = write ? (MPI_MODE_WRONLY | MPI_MODE_CREATE) : MPI_MODE_RDONLY;
+    int ok =
+        (MPI_File_open(lattice.mpi_comm_lat, filename.c_str(), mode, MPI_INFO_NULL, &fh) ==
+         MPI_SUCCESS);
+
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, lattice.mpi_comm_lat);
+    if (!ok) {
+        hila::out0 << "ERROR in opening file " << filename << '\n';
+        hila::terminate(write ? 4 : 5);
+    }
+
+    // truncate, as std::ios::trunc does
+    if (write)
+        MPI_File_set_size(fh, 0);
+
+    return ok;
+}
+
+inline bool close_parallel_file(const std::string &filename, MPI_File &fh) {
+    int ok = (MPI_File_close(&fh) == MPI_SUCCESS);
+
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, lattice.mpi_comm_lat);
+    if (!ok) {
+        hila::out0 << "ERROR in reading/writing file " << filename << '\n';
+        hila::terminate(3);
+    }
+    return ok;
+}
+
+/// MPI types for parallel i/o: etype is one field element of size bytes, filetype
+/// the sublattice of this rank within the global lattice, x running fastest
+inline void parallel_io_types(size_t size, MPI_Datatype &etype, MPI_Datatype &filetype) {
+    int gsizes[NDIM], lsizes[NDIM], starts[NDIM];
+    foralldir(d) {
+        gsizes[d] = lattice.size(d);
+        lsizes[d] = lattice.mynode.size[d];
+        starts[d] = lattice.mynode.min[d];
+    }
+
+    MPI_Type_contiguous((int)size, MPI_BYTE, &etype);
+    MPI_Type_commit(&etype);
+    MPI_Type_create_subarray(NDIM, gsizes, lsizes, starts, MPI_ORDER_FORTRAN, etype, &filetype);
+    MPI_Type_commit(&filetype);
+}
+
+/// Local site indices in the order the sites of this rank appear in the file
+inline std::vector<unsigned> parallel_io_index_list() {
+    std::vector<unsigned> index_list(lattice.mynode.sites);
+    CoordinateVector c;
+    for (size_t i = 0; i < lattice.mynode.sites; i++) {
+        foralldir(d) c[d] =
+            (i / lattice.mynode.size_factor[d]) % lattice.mynode.size[d] + lattice.mynode.min[d];
+        index_list[i] = lattice.site_index(c);
+    }
+    return index_list;
+}
+
 } // namespace hila
 
 //////////////////////////////////////////////////////////////////////////////////
@@ -110,13 +173,36 @@ void Field<T>::write(std::ofstream &outputfile, bool binary, int precision) cons
     std::free(buffer);
 }
 
+/// Write the field to an open MPI-IO file starting at byte offset.
+/// Collective, all ranks must call this
+template <typename T>
+void Field<T>::write_parallel(MPI_File &fh, MPI_Offset offset) const {
+    std::vector<unsigned> index_list = hila::parallel_io_index_list();
+    std::vector<T> buffer(index_list.size());
+    fs->payload.gather_elements(buffer.data(), index_list.data(), index_list.size(), lattice);
+
+    MPI_Datatype etype, filetype;
+    hila::parallel_io_types(sizeof(T), etype, filetype);
+    MPI_File_set_view(fh, offset, etype, filetype, "native", MPI_INFO_NULL);
+    MPI_File_write_all(fh, buffer.data(), (int)buffer.size(), etype, MPI_STATUS_IGNORE);
+    MPI_Type_free(&filetype);
+    MPI_Type_free(&etype);
+}
+
 /// Write the Field to a named file replacing the file
 template <typename T>
 void Field<T>::write(const std::string &filename, bool binary, int precision) const {
-    std::ofstream outputfile;
-    hila::open_output_file(filename, outputfile, binary);
-    write(outputfile, binary, precision);
-    hila::close_file(filename, outputfile);
+    if (binary && hila::parallel_io) {
+        MPI_File fh;
+        hila::open_parallel_file(filename, fh, true);
+        write_parallel(fh, 0);
+        hila::close_parallel_file(filename, fh);
+    } else {
+        std::ofstream outputfile;
+        hila::open_output_file(filename, outputfile, binary);
+        write(outputfile, binary, precision);
+        hila::close_file(filename, outputfile);
+    }
 }
 
 /// Write a list of fields into an output stream
@@ -174,13 +260,42 @@ void Field<T>::read(std::ifstream &inputfile) {
     std::free(buffer);
 }
 
+/// Read the field from an open MPI-IO file starting at byte offset.
+/// Collective, all ranks must call this
+template <typename T>
+void Field<T>::read_parallel(MPI_File &fh, MPI_Offset offset) {
+    if (!this->is_allocated())
+        this->allocate();
+
+    mark_changed(ALL);
+
+    std::vector<unsigned> index_list = hila::parallel_io_index_list();
+    std::vector<T> buffer(index_list.size());
+
+    MPI_Datatype etype, filetype;
+    hila::parallel_io_types(sizeof(T), etype, filetype);
+    MPI_File_set_view(fh, offset, etype, filetype, "native", MPI_INFO_NULL);
+    MPI_File_read_all(fh, buffer.data(), (int)buffer.size(), etype, MPI_STATUS_IGNORE);
+    MPI_Type_free(&filetype);
+    MPI_Type_free(&etype);
+
+    fs->payload.place_elements(buffer.data(), index_list.data(), index_list.size(), lattice);
+}
+
 // Read Field contents from the beginning of a file
 template <typename T>
 void Field<T>::read(const std::string &filename) {
-    std::ifstream inputfile;
-    hila::open_input_file(filename, inputfile);
-    read(inputfile);
-    hila::close_file(filename, inputfile);
+    if (hila::parallel_io) {
+        MPI_File fh;
+        hila::open_parallel_file(filename, fh, false);
+        read_parallel(fh, 0);
+        hila::close_parallel_file(filename, fh);
+    } else {
+        std::ifstream inputfile;
+        hila::open_input_file(filename, inputfile);
+        read(inputfile);
+        hila::close_file(filename, inputfile);
+    }
 }
 
 // Read a list of fields from an input stream
@@ -131,10 +131,17 @@ class GaugeField {
     }
 
     void write(const std::string &filename) const {
-        std::ofstream outputfile;
-        hila::open_output_file(filename, outputfile);
-        write(outputfile);
-        hila::close_file(filename, outputfile);
+        if (hila::parallel_io) {
+            MPI_File fh;
+            hila::open_parallel_file(filename, fh, true);
+            write_parallel(fh, 0);
+            hila::close_parallel_file(filename, fh);
+        } else {
+            std::ofstream outputfile;
+            hila::open_output_file(filename, outputfile);
+            write(outputfile);
+            hila::close_file(filename, outputfile);
+        }
     }
 
     void read(std::ifstream &inputfile) {
@@ -144,77 +151,112 @@ class GaugeField {
     }
 
     void read(const std::string &filename) {
-        std::ifstream inputfile;
-        hila::open_input_file(filename, inputfile);
-        read(inputfile);
-        hila::close_file(filename, inputfile);
+        if (hila::parallel_io) {
+            MPI_File fh;
+            hila::open_parallel_file(filename, fh, false);
+            read_parallel(fh, 0);
+            hila::close_parallel_file(filename, fh);
+        } else {
+            std::ifstream inputfile;
+            hila::open_input_file(filename, inputfile);
+            read(inputfile);
+            hila::close_file(filename, inputfile);
+        }
+    }
+
+    /// Collective MPI-IO write/read of all directions, one after another from offset
+    void write_parallel(MPI_File &fh, MPI_Offset offset) const {
+        foralldir(d) {
+            fdir[d].write_parallel(fh, offset);
+            offset += lattice.volume() * sizeof(T);
+        }
+    }
+
+    void read_parallel(MPI_File &fh, MPI_Offset offset) {
+        foralldir(d) {
+            fdir[d].read_parallel(fh, offset);
+            offset += lattice.volume() * sizeof(T);
+        }
     }
 
     /// config_write writes the gauge field to file, with additional "verifying" header
 
     void config_write(const std::string &filename) const {
-        std::ofstream outputfile;
-        hila::open_output_file(filename, outputfile);
-
-        // write header
-        if (hila::myrank() == 0) {
-            int64_t f = config_flag;
-            outputfile.write(reinterpret_cast<char *>(&f), sizeof(int64_t));
-            f = NDIM;
-            outputfile.write(reinterpret_cast<char *>(&f), sizeof(int64_t));
-            f = sizeof(T);
-            outputfile.write(reinterpret_cast<char *>(&f), sizeof(int64_t));
-
-            foralldir(d) {
-                f = lattice.size(d);
-                outputfile.write(reinterpret_cast<char *>(&f), sizeof(int64_t));
-            }
+        int64_t header[3 + NDIM];
+        header[0] = config_flag;
+        header[1] = NDIM;
+        header[2] = sizeof(T);
+        foralldir(d) header[3 + d] = lattice.size(d);
+
+        if (hila::parallel_io) {
+            MPI_File fh;
+            hila::open_parallel_file(filename, fh, true);
+            if (hila::myrank() == 0)
+                MPI_File_write_at(fh, 0, header, sizeof(header), MPI_BYTE, MPI_STATUS_IGNORE);
+
+            write_parallel(fh, sizeof(header));
+            hila::close_parallel_file(filename, fh);
+
+        } else {
+            std::ofstream outputfile;
+            hila::open_output_file(filename, outputfile);
+
+            // write header
+            if (hila::myrank() == 0)
+                outputfile.write(reinterpret_cast<char *>(header), sizeof(header));
+
+            write(outputfile);
+            hila::close_file(filename, outputfile);
         }
-
-        write(outputfile);
-        hila::close_file(filename, outputfile);
     }
 
     void config_read(const std::string &filename) {
         std::ifstream inputfile;
-        hila::open_input_file(filename, inputfile);
-        std::string conferr("CONFIG ERROR in file " + filename + ": ");
+        MPI_File fh;
+        int64_t header[3 + NDIM] = {0};
 
         // read header
-        bool ok = true;
-        int64_t f;
-        if (hila::myrank() == 0) {
-            inputfile.read(reinterpret_cast<char *>(&f), sizeof(int64_t));
-            ok = (f == config_flag);
-            if (!ok)
-                hila::out0 << conferr << "wrong id, should be " << config_flag << " is " << f
-                           << '\n';
+        if (hila::parallel_io) {
+            hila::open_parallel_file(filename, fh, false);
+            if (hila::myrank() == 0)
+                MPI_File_read_at(fh, 0, header, sizeof(header), MPI_BYTE, MPI_STATUS_IGNORE);
+        } else {
+            hila::open_input_file(filename, inputfile);
+            if (hila::myrank() == 0)
+                inputfile.read(reinterpret_cast<char *>(header), sizeof(header));
         }
 
-        if (ok && hila::myrank() == 0) {
-            inputfile.read(reinterpret_cast<char *>(&f), sizeof(int64_t));
-            ok = (f == NDIM);
-            if (!ok)
-                hila::out0 << conferr << "wrong dimensionality, should be " << NDIM << " is " << f
-                           << '\n';
-        }
+        bool ok = true;
+        if (hila::myrank() == 0) {
+            std::string conferr("CONFIG ERROR in file " + filename + ": ");
 
-        if (ok && hila::myrank() == 0) {
-            inputfile.read(reinterpret_cast<char *>(&f), sizeof(int64_t));
-            ok = (f == sizeof(T));
+            ok = (header[0] == config_flag);
             if (!ok)
-                hila::out0 << conferr << "wrong size of field element, should be " << sizeof(T)
-                           << " is " << f << '\n';
-        }
+                hila::out0 << conferr << "wrong id, should be " << config_flag << " is "
+                           << header[0] << '\n';
 
-        if (ok && hila::myrank() == 0) {
+            if (ok) {
+                ok = (header[1] == NDIM);
+                if (!ok)
+                    hila::out0 << conferr << "wrong dimensionality, should be " << NDIM
+                               << " is " << header[1] << '\n';
+            }
 
-            foralldir(d) {
-                inputfile.read(reinterpret_cast<char *>(&f), sizeof(int64_t));
-                ok = ok && (f == lattice.size(d));
+            if (ok) {
+                ok = (header[2] == sizeof(T));
                 if (!ok)
-                    hila::out0 << conferr << "incorrect lattice dimension " << hila::prettyprint(d)
-                               << " is " << f << " should be " << lattice.size(d) << '\n';
+                    hila::out0 << conferr << "wrong size of field element, should be "
+                               << sizeof(T) << " is " << header[2] << '\n';
+            }
+
+            if (ok) {
+                foralldir(d) {
+                    ok = ok && (header[3 + d] == lattice.size(d));
+                    if (!ok)
+                        hila::out0 << conferr << "incorrect lattice dimension "
+                                   << hila::prettyprint(d) << " is " << header[3 + d]
+                                   << " should be " << lattice.size(d) << '\n';
+                }
             }
         }
 
@@ -222,8 +264,13 @@ class GaugeField {
             hila::terminate(1);
         }
 
-        read(inputfile);
-        hila::close_file(filename, inputfile);
+        if (hila::parallel_io) {
+            read_parallel(fh, sizeof(header));
+            hila::close_parallel_file(filename, fh);
+        } else {
+            read(inputfile);
+            hila::close_file(filename, inputfile);
+        }
     }
 };
 
@@ -10,6 +10,7 @@
 #include "datatypes/cmplx.h"
 #include "datatypes/matrix.h"
 #include "datatypes/sun_matrix.h"
+#include "datatypes/sun_compressed.h"
 #include "datatypes/u1.h"
 #include "datatypes/su2.h"
 
@@ -21,7 +22,9 @@
 #include "plumbing/field_io.h"
 #include "plumbing/reduction.h"
 #include "plumbing/reductionvector.h"
+#include "plumbing/multi_dot.h"
 #include "plumbing/site_select.h"
+#include "plumbing/loop_profile.h"
 
 #if __has_include("hila_signatures.h")
 #include "hila_signatures.h"
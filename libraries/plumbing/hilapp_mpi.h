@@ -40,12 +40,35 @@ typedef struct ompi_status_public_t MPI_Status;
 typedef void *MPI_Comm;
 typedef int MPI_Fint;
 typedef void *MPI_Errhandler;
+typedef void *MPI_File;
+typedef void *MPI_Info;
+typedef long long MPI_Offset;
+typedef void *MPI_Win;
+typedef void *MPI_Group;
+typedef long MPI_Aint;
 #define MPI_IN_PLACE nullptr
 #define MPI_COMM_WORLD nullptr
 #define MPI_STATUS_IGNORE nullptr
 #define MPI_ERRORS_RETURN nullptr
 #define MPI_REQUEST_NULL nullptr
 #define MPI_SUCCESS 1
+#define MPI_INFO_NULL nullptr
+#define MPI_COMM_NULL nullptr
+#define MPI_WIN_NULL nullptr
+#define MPI_ANY_SOURCE (-1)
+#define MPI_ANY_TAG (-1)
+#define MPI_UNDEFINED (-32766)
+#define MPI_COMM_TYPE_SHARED 1
+#define MPI_MODE_NOCHECK 1024
+
+enum MPI_file_mode : int {
+    MPI_MODE_RDONLY = 2,
+    MPI_MODE_RDWR = 8,
+    MPI_MODE_WRONLY = 4,
+    MPI_MODE_CREATE = 1
+};
+
+enum MPI_array_order : int { MPI_ORDER_C, MPI_ORDER_FORTRAN };
 
 enum MPI_thread_level : int {
     MPI_THREAD_SINGLE,
@@ -78,6 +101,18 @@ int MPI_Comm_size(MPI_Comm comm, int *size);
 
 int MPI_Comm_split(MPI_Comm comm, int color, int key, MPI_Comm *newcomm);
 
+int MPI_Comm_split_type(MPI_Comm comm, int split_type, int key, MPI_Info info,
+                        MPI_Comm *newcomm);
+
+int MPI_Comm_free(MPI_Comm *comm);
+
+int MPI_Comm_group(MPI_Comm comm, MPI_Group *group);
+
+int MPI_Group_translate_ranks(MPI_Group group1, int n, const int ranks1[], MPI_Group group2,
+                              int ranks2[]);
+
+int MPI_Group_free(MPI_Group *group);
+
 int MPI_Comm_set_errhandler(MPI_Comm comm, MPI_Errhandler errhandler);
 
 int MPI_Bcast(void *buffer, int count, MPI_Datatype datatype, int root, MPI_Comm comm);
@@ -119,6 +154,8 @@ int MPI_Cancel(MPI_Request *request);
 
 int MPI_Test(MPI_Request *request, int *flag, MPI_Status *status);
 
+int MPI_Iprobe(int source, int tag, MPI_Comm comm, int *flag, MPI_Status *status);
+
 int MPI_Test_cancelled(const MPI_Status *status, int *flag);
 
 int MPI_Request_free(MPI_Request *request);
@@ -129,4 +166,54 @@ MPI_Fint MPI_Comm_c2f(MPI_Comm comm);
 
 int MPI_Finalize();
 
+int MPI_Info_create(MPI_Info *info);
+
+int MPI_Info_set(MPI_Info info, const char *key, const char *value);
+
+int MPI_Info_free(MPI_Info *info);
+
+int MPI_Win_allocate_shared(MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm comm,
+                            void *baseptr, MPI_Win *win);
+
+int MPI_Win_shared_query(MPI_Win win, int rank, MPI_Aint *size, int *disp_unit, void *baseptr);
+
+int MPI_Win_lock_all(int assert, MPI_Win win);
+
+int MPI_Win_unlock_all(MPI_Win win);
+
+int MPI_Win_sync(MPI_Win win);
+
+int MPI_Win_free(MPI_Win *win);
+
+int MPI_Type_contiguous(int count, MPI_Datatype oldtype, MPI_Datatype *newtype);
+
+int MPI_Type_create_subarray(int ndims, const int sizes[], const int subsizes[],
+                             const int starts[], int order, MPI_Datatype oldtype,
+                             MPI_Datatype *newtype);
+
+int MPI_Type_commit(MPI_Datatype *datatype);
+
+int MPI_Type_free(MPI_Datatype *datatype);
+
+int MPI_File_open(MPI_Comm comm, const char *filename, int amode, MPI_Info info, MPI_File *fh);
+
+int MPI_File_close(MPI_File *fh);
+
+int MPI_File_set_size(MPI_File fh, MPI_Offset size);
+
+int MPI_File_set_view(MPI_File fh, MPI_Offset disp, MPI_Datatype etype, MPI_Datatype filetype,
+                      const char *datarep, MPI_Info info);
+
+int MPI_File_write_all(MPI_File fh, const void *buf, int count, MPI_Datatype datatype,
+                       MPI_Status *status);
+
+int MPI_File_read_all(MPI_File fh, void *buf, int count, MPI_Datatype datatype,
+                      MPI_Status *status);
+
+int MPI_File_write_at(MPI_File fh, MPI_Offset offset, const void *buf, int count,
+                      MPI_Datatype datatype, MPI_Status *status);
+
+int MPI_File_read_at(MPI_File fh, MPI_Offset offset, void *buf, int count,
+                     MPI_Datatype datatype, MPI_Status *status);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,196 @@
+///////////////////////////////////////////
+/// host_memory_pool.cpp - size class memory pool for fields on cpu targets
+
+#include "plumbing/defs.h"
+#include "plumbing/memalloc.h"
+#include <unordered_map>
+#include <vector>
+#include <map>
+#include <cassert>
+
+#if defined(OPENMP)
+#include <omp.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////
+/// Host memory pool
+/// Field storage and MPI buffers are allocated and freed very often (temporary
+/// fields in expressions, local fields in library functions).  Instead of returning
+/// the memory to the system, freed blocks are kept in free lists sorted by size class
+/// and handed out again for the next allocation of the same class.
+///
+/// Size classes are powers of 2 split in 4 steps, thus at most 25% waste.
+/// Allocations below HOST_MEMORY_POOL_MIN_SIZE are all in the same class.
+///
+/// With OpenMP a fresh block is touched first in a static parallel loop, thus
+/// the pages land on the NUMA domains of the threads which use them in site loops.
+///
+/// The pool is not thread safe: fields and buffers are allocated and freed by the
+/// master thread outside parallel regions, which is asserted.
+///
+/// If the system runs out of memory the free blocks are released and the allocation
+/// is tried again.  hila::finishrun() releases the free blocks.
+///
+/// Turn off with -DHOST_MEMORY_POOL=0, then these fall back to memalloc/free.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef HOST_MEMORY_POOL_MIN_SIZE
+#define HOST_MEMORY_POOL_MIN_SIZE 256
+#endif
+
+#if defined(HOST_MEMORY_POOL)
+
+// statistics
+static size_t n_allocs = 0;
+static size_t n_hits = 0;
+static size_t n_misses = 0;
+static size_t current_used_size = 0;
+static size_t max_used_size = 0;
+static size_t current_pool_size = 0; // sum of in use + free blocks
+static size_t max_pool_size = 0;
+
+// free blocks by class size, and the class size of blocks in use
+static std::map<size_t, std::vector<void *>> free_blocks;
+static std::unordered_map<void *, size_t> in_use_blocks;
+
+/// Round the request to the size class
+static size_t size_class(size_t req_size) {
+    if (req_size <= HOST_MEMORY_POOL_MIN_SIZE)
+        return HOST_MEMORY_POOL_MIN_SIZE;
+
+    // highest power of 2 <= req_size
+    size_t p2 = HOST_MEMORY_POOL_MIN_SIZE;
+    while (2 * p2 <= req_size)
+        p2 *= 2;
+
+    // and 4 steps between p2 and 2*p2
+    size_t step = p2 / 4;
+    return ((req_size + step - 1) / step) * step;
+}
+
+/// Allocate like memalloc(), but return nullptr on failure
+static void *try_memalloc(size_t size) {
+#ifndef ALIGNED_MEMALLOC
+    return std::malloc(size);
+#else
+    // size classes are multiples of 32
+    void *p;
+    if (posix_memalign(&p, (size_t)32, size) != 0)
+        return nullptr;
+    return p;
+#endif
+}
+
+/// Fresh memory: first touch with the threads which will use it
+static void first_touch(void *ptr, size_t size) {
+#if defined(OPENMP)
+    char *cp = static_cast<char *>(ptr);
+    const size_t page = 4096;
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < size; i += page) {
+        cp[i] = 0;
+    }
+#endif
+}
+
+void *host_memory_pool_alloc(size_t req_size) {
+
+    size_t size = size_class(req_size);
+    void *ptr;
+
+#if defined(OPENMP)
+    assert(!omp_in_parallel() && "host memory pool used inside omp parallel region");
+#endif
+
+    n_allocs++;
+
+    auto it = free_blocks.find(size);
+    if (it != free_blocks.end() && it->second.size() > 0) {
+        n_hits++;
+        ptr = it->second.back();
+        it->second.pop_back();
+    } else {
+        n_misses++;
+        ptr = try_memalloc(size);
+        if (ptr == nullptr) {
+            // out of memory: release the free blocks and retry, memalloc() reports failure
+            host_memory_pool_purge();
+            ptr = memalloc(size);
+        }
+        first_touch(ptr, size);
+        current_pool_size += size;
+        if (current_pool_size > max_pool_size)
+            max_pool_size = current_pool_size;
+    }
+
+    in_use_blocks[ptr] = size;
+    current_used_size += size;
+    if (current_used_size > max_used_size)
+        max_used_size = current_used_size;
+
+    return ptr;
+}
+
+void host_memory_pool_free(void *ptr) {
+    if (ptr == nullptr)
+        return;
+
+#if defined(OPENMP)
+    assert(!omp_in_parallel() && "host memory pool used inside omp parallel region");
+#endif
+
+    auto it = in_use_blocks.find(ptr);
+    if (it == in_use_blocks.end()) {
+        hila::out << "Host memory pool free error - unknown pointer " << ptr << '\n';
+        hila::terminate(1);
+    }
+
+    size_t size = it->second;
+    in_use_blocks.erase(it);
+    current_used_size -= size;
+
+    free_blocks[size].push_back(ptr);
+}
+
+/// Release free blocks to the system
+void host_memory_pool_purge() {
+    for (auto &fb : free_blocks) {
+        for (void *p : fb.second) {
+            std::free(p);
+            current_pool_size -= fb.first;
+        }
+        fb.second.clear();
+    }
+}
+
+void host_memory_pool_report() {
+    if (hila::myrank() == 0) {
+        hila::out << "\nHost memory pool statistics from node 0:\n";
+        hila::out << "   # of allocations " << n_allocs << ", from pool " << n_hits
+                  << ", new " << n_misses;
+        if (n_allocs > 0)
+            hila::out << " (hit rate " << 100.0 * n_hits / n_allocs << "%)";
+        hila::out << '\n';
+        hila::out << "   Current pool size " << ((double)current_pool_size) / (1024 * 1024)
+                  << " MB, maximum " << ((double)max_pool_size) / (1024 * 1024) << " MB\n";
+        hila::out << "   Maximum memory use " << ((double)max_used_size) / (1024 * 1024)
+                  << " MB\n\n";
+    }
+}
+
+#else // now no HOST_MEMORY_POOL
+
+void *host_memory_pool_alloc(size_t req_size) {
+    return memalloc(req_size);
+}
+
+void host_memory_pool_free(void *ptr) {
+    if (ptr != nullptr)
+        std::free(ptr);
+}
+
+void host_memory_pool_purge() {}
+
+void host_memory_pool_report() {}
+
+#endif // HOST_MEMORY_POOL
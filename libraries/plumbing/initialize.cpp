@@ -10,6 +10,11 @@ bool hila::about_to_finish = false;
 bool hila::is_initialized = false;
 bool hila::check_input = false;
 int hila::check_with_nodes;
+#if defined(PARALLEL_IO)
+bool hila::parallel_io = true;
+#else
+bool hila::parallel_io = false;
+#endif
 logger_class hila::log;
 
 void setup_partitions();
@@ -129,6 +134,22 @@ void hila::initialize(int argc, char **argv) {
                            "Can be repeated many times, each overrides only one input entry.",
                            "<key> <value>", 2);
 
+    hila::cmdline.add_flag("-parallel_io",
+                           "binary field files with MPI-IO (on) or through rank 0 (off).\n"
+                           "Default is on, unless compiled with -DPARALLEL_IO=0",
+                           "<on/off>", 1);
+
+    hila::cmdline.add_flag("-timer_stats",
+                           "timer report gives also min/mean/max over ranks (on).\n"
+                           "Default is off",
+                           "<on/off>", 1);
+
+    hila::cmdline.add_flag("-trace",
+                           "write Chrome trace timeline of timers, gathers and loops to\n"
+                           "<filename> (chrome://tracing or ui.perfetto.dev).\n"
+                           "<events>: ring buffer size per rank, default 262144",
+                           "<filename> [<events>]");
+
     // Init command line - after MPI has been started, so
     // that all nodes do this. First feed argc and argv to the
     // global cmdline class instance and parse for the preset flags.
@@ -204,6 +225,9 @@ void hila::initialize(int argc, char **argv) {
 #endif
 #ifdef SPECIAL_BOUNDARY_CONDITIONS
         hila::out0 << " SPECIAL_BOUNDARY_CONDITIONS";
+#endif
+#ifdef TILED_LAYOUT
+        hila::out0 << " TILED_LAYOUT=" << TILED_LAYOUT;
 #endif
         hila::out0 << '\n';
 
@@ -223,6 +247,24 @@ void hila::initialize(int argc, char **argv) {
         hila::out0 << "Input file from command line: " << hila::cmdline.get_string("-i") << "\n";
     }
 
+    int pio = get_onoff("-parallel_io");
+    if (pio != 0)
+        hila::parallel_io = (pio > 0);
+    if (hila::parallel_io)
+        hila::out0 << "Field i/o: parallel MPI-IO\n";
+    else
+        hila::out0 << "Field i/o: through rank 0\n";
+
+    if (get_onoff("-timer_stats") > 0)
+        hila::timer_statistics = true;
+
+    if (hila::cmdline.flag_present("-trace")) {
+        int64_t n_events = 262144;
+        if (hila::cmdline.flag_set("-trace") > 1)
+            n_events = hila::cmdline.get_int("-trace", 1);
+        hila::setup_event_trace(hila::cmdline.get_string("-trace"), n_events);
+    }
+
 #if defined(OPENMP)
     hila::out0 << "Using option OPENMP - with " << omp_get_max_threads() << " threads\n";
 #endif
@@ -297,6 +339,8 @@ void hila::error(const std::string &msg) {
  */
 void hila::finishrun() {
     report_timers();
+    hila::report_loop_profile();
+    hila::write_event_trace();
 
     for (const lattice_struct *latp : lattices) {
 
@@ -307,6 +351,10 @@ void hila::finishrun() {
         if (gathers + avoided > 0) {
             hila::out0 << " COMMS from node 0: " << gathers << " done, " << avoided << "("
                        << 100.0 * avoided / (avoided + gathers) << "%) optimized away\n";
+            if (latp->n_gather_shm > 0)
+                hila::out0 << " COMMS from node 0: " << latp->n_gather_shm << " of "
+                           << gathers << " received through intra-node shared memory, "
+                           << gathers - latp->n_gather_shm << " with MPI\n";
         } else {
             hila::out0 << " No communications done from node 0\n";
         }
@@ -315,6 +363,9 @@ void hila::finishrun() {
 
 #if defined(CUDA) || defined(HIP)
     gpuMemPoolReport();
+#else
+    host_memory_pool_report();
+    host_memory_pool_purge();
 #endif
 
     if (hila::partitions.number() > 1) {
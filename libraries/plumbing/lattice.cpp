@@ -53,6 +53,9 @@ void lattice_struct::setup(const CoordinateVector &siz) {
     // Initialize wait_array structures - has to be after std gathers()
     initialize_wait_arrays();
 
+    // shared memory windows for on-node neighbours, done once
+    hila::shm::initialize();
+
 #ifdef SPECIAL_BOUNDARY_CONDITIONS
     // do this after std. boundary is done
     init_special_boundaries();
@@ -131,7 +134,96 @@ bool lattice_struct::is_on_mynode(const CoordinateVector &loc) const {
 /// Note: loc really has to be on this node
 ///////////////////////////////////////////////////////////////////////
 
-#ifndef SUBNODE_LAYOUT
+#if defined(TILED_LAYOUT)
+
+///////////////////////////////////////////////////////////////////////
+/// Tiled layout: the node is divided into tiles of TILED_LAYOUT^NDIM sites
+/// (smaller at the upper edges).  The tiles are in x-fastest order, and
+/// the sites inside a tile too.  Even sites come first, then odd.
+///
+/// On the face of the node to Direction d the sites are in the same order
+/// as on the opposite face of the neighbour node, because the nodes have the
+/// same tiling in the other directions.  The nn-communication setup relies on this.
+///////////////////////////////////////////////////////////////////////
+
+/// Call f(loc) for the sites of the box (min, size) in tiled order, stop if f returns false
+template <typename F>
+static void walk_tiled_order(const CoordinateVector &min, const CoordinateVector &size, F f) {
+    CoordinateVector ntiles, t, tmin, tsize, l;
+    size_t tiles = 1;
+    foralldir(d) {
+        ntiles[d] = (size[d] + TILED_LAYOUT - 1) / TILED_LAYOUT;
+        tiles *= ntiles[d];
+        t[d] = 0;
+    }
+
+    for (size_t n = 0; n < tiles; n++) {
+        size_t vol = 1;
+        foralldir(d) {
+            tmin[d] = min[d] + t[d] * TILED_LAYOUT;
+            tsize[d] = std::min(TILED_LAYOUT, size[d] - t[d] * TILED_LAYOUT);
+            vol *= tsize[d];
+        }
+        l = tmin;
+        for (size_t i = 0; i < vol; i++) {
+            if (!f(l))
+                return;
+            foralldir(d) {
+                if (++l[d] < tmin[d] + tsize[d])
+                    break;
+                l[d] = tmin[d];
+            }
+        }
+        foralldir(d) {
+            if (++t[d] < ntiles[d])
+                break;
+            t[d] = 0;
+        }
+    }
+}
+
+/// x-fastest index of loc on the node box (min, size)
+static inline unsigned node_lexicographic_index(const CoordinateVector &loc,
+                                                const CoordinateVector &min,
+                                                const CoordinateVector &size) {
+    unsigned i = loc[NDIM - 1] - min[NDIM - 1];
+    for (int dir = NDIM - 2; dir >= 0; dir--)
+        i = i * size[dir] + loc[dir] - min[dir];
+    return i;
+}
+
+unsigned lattice_struct::site_index(const CoordinateVector &loc) const {
+    return mynode.tiled_index[node_lexicographic_index(loc, mynode.min, mynode.size)];
+}
+
+///////////////////////////////////////////////////////////////////////
+/// give site index for nodeid sites.  There is no table for other nodes,
+/// walk through the sites: O(node volume)
+///////////////////////////////////////////////////////////////////////
+
+unsigned lattice_struct::site_index(const CoordinateVector &loc, const unsigned nodeid) const {
+    if (nodeid == mynode.rank)
+        return site_index(loc);
+
+    const node_info &ni = nodes.nodelist[nodeid];
+    unsigned n_even = 0, n_odd = 0;
+    walk_tiled_order(ni.min, ni.size, [&](const CoordinateVector &l) {
+        if (l == loc)
+            return false;
+        if (l.parity() == EVEN)
+            n_even++;
+        else
+            n_odd++;
+        return true;
+    });
+
+    if (loc.parity() == EVEN)
+        return n_even;
+    else
+        return n_odd + ni.evensites;
+}
+
+#elif !defined(SUBNODE_LAYOUT)
 
 unsigned lattice_struct::site_index(const CoordinateVector &loc) const {
 
@@ -374,6 +466,20 @@ void lattice_struct::node_struct::setup(node_info &ni, lattice_struct &lattice)
     // map site indexes to locations -- coordinates array
     // after the above site_index should work
 
+#ifdef TILED_LAYOUT
+    // site indices in tiled order, even sites first
+    tiled_index.resize(sites);
+    unsigned n_even = 0, n_odd = 0;
+    walk_tiled_order(min, size, [&](const CoordinateVector &l) {
+        unsigned i = node_lexicographic_index(l, min, size);
+        if (l.parity() == EVEN)
+            tiled_index[i] = n_even++;
+        else
+            tiled_index[i] = evensites + n_odd++;
+        return true;
+    });
+#endif
+
 #ifdef EVEN_SITES_FIRST
     coordinates.resize(sites);
     CoordinateVector l = min;
@@ -608,6 +714,46 @@ void lattice_struct::initialize_wait_arrays() {
 }
 
 
+/************************************************************************/
+
+/* Interior blocks are cut to at most this many sites, so that an OpenMP
+ * loop over the blocks balances the work also when the interior is one
+ * contiguous range
+ */
+#define SITE_SPLIT_MAX_BLOCK 256
+
+const lattice_struct::site_split_struct &lattice_struct::site_split(Parity par,
+                                                                  dir_mask_t mask) const {
+    if (site_splits.size() == 0)
+        site_splits.resize(4 << (2 * NDIM));
+
+    site_split_struct &split = site_splits[((int)par << (2 * NDIM)) + mask];
+    if (split.is_set)
+        return split;
+
+    split.n_interior = 0;
+    unsigned begin = loop_begin(par);
+    for (unsigned i = loop_begin(par); i < loop_end(par); i++) {
+        bool is_boundary = (wait_arr_[i] & mask) != 0;
+        if (is_boundary)
+            split.boundary.push_back(i);
+        if (i > begin && (is_boundary || i - begin == SITE_SPLIT_MAX_BLOCK)) {
+            split.interior.push_back({begin, i});
+            split.n_interior += i - begin;
+        }
+        if (is_boundary || i - begin >= SITE_SPLIT_MAX_BLOCK)
+            begin = is_boundary ? i + 1 : i;
+    }
+    if (loop_end(par) > begin) {
+        split.interior.push_back({begin, loop_end(par)});
+        split.n_interior += loop_end(par) - begin;
+    }
+
+    split.is_set = true;
+    return split;
+}
+
+
 #ifdef SPECIAL_BOUNDARY_CONDITIONS
 
 /////////////////////////////////////////////////////////////////////
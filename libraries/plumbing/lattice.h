@@ -81,6 +81,11 @@ class lattice_struct {
         std::vector<CoordinateVector> coordinates;
 #endif
 
+#ifdef TILED_LAYOUT
+        // site index of the site at node local x-fastest index
+        std::vector<unsigned> tiled_index;
+#endif
+
         Vector<NDIM, unsigned> size_factor; // components: 1, size[0], size[0]*size[1], ...
 
         void setup(node_info &ni, lattice_struct &lattice);
@@ -205,6 +210,20 @@ class lattice_struct {
     /// implement waiting using mask_t - unsigned char is good for up to 4 dim.
     dir_mask_t *RESTRICT wait_arr_;
 
+    /// Sites of a loop split by the gathers it waits for, see site_split().
+    /// Interior sites have all neighbours in the masked directions on this node,
+    /// they are stored as contiguous index blocks [begin, end).  Boundary sites
+    /// need some of the gathered data, stored as an index list.
+    struct site_split_struct {
+        struct block {
+            unsigned begin, end;
+        };
+        std::vector<block> interior;
+        std::vector<unsigned> boundary;
+        unsigned n_interior;
+        bool is_set = false;
+    };
+
 #ifdef SPECIAL_BOUNDARY_CONDITIONS
     /// special boundary pointers are needed only in cases neighbour
     /// pointers must be modified (new halo elements). That is known only during
@@ -373,11 +392,18 @@ class lattice_struct {
     /* MPI functions and variables. Define here in lattice? */
     void initialize_wait_arrays();
 
+    /// Interior and boundary sites of parity par for the gathers in dir_mask,
+    /// built on first use.  Used by the loops hilapp generates to overlap
+    /// communication with computation
+    const site_split_struct &site_split(Parity par, dir_mask_t mask) const;
+
 
     MPI_Comm mpi_comm_lat;
 
     // Guarantee 64 bits for these - 32 can overflow!
     int64_t n_gather_done = 0, n_gather_avoided = 0;
+    // of n_gather_done, received through intra-node shared memory
+    int64_t n_gather_shm = 0;
 
 
     /// Return the coordinates of a site, where 1st dim (x) runs fastest etc.
@@ -397,6 +423,10 @@ class lattice_struct {
     int id() const {
         return l_label;
     }
+
+  private:
+    /// site_split() cache, index (parity, mask)
+    mutable std::vector<site_split_struct> site_splits;
 };
 
 /// global handle to lattice
@@ -0,0 +1,160 @@
+///////////////////////////////////////////
+/// loop_profile.cpp - per site loop profiling, see loop_profile.h
+
+#include "plumbing/defs.h"
+#include "plumbing/lattice.h"
+#include "plumbing/com_mpi.h"
+#include "plumbing/timing.h"
+#include "plumbing/loop_profile.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+// gather waits go through these timers (com_mpi.cpp, com_shm.cpp)
+extern hila::timer shm_wait_receive_timer;
+
+namespace hila {
+
+// list of loops seen, function-static to avoid initialization order problems
+static std::vector<loop_profile_entry *> &loop_profile_list() {
+    static std::vector<loop_profile_entry *> list;
+    return list;
+}
+
+/// Time spent so far waiting for gathers
+static double gather_wait_time() {
+    return wait_receive_timer.value().time + shm_wait_receive_timer.value().time;
+}
+
+loop_profile_entry::loop_profile_entry(const char *f, int l) {
+    file = f;
+    line = l;
+    count = 0;
+    time = gather_wait = bytes = 0;
+    split_count = 0;
+    interior_time = interior_sites = split_sites = 0;
+    loop_profile_list().push_back(this);
+}
+
+loop_profile_scope::loop_profile_scope(loop_profile_entry &e, size_t bytes_per_site, Parity par)
+    : entry(e) {
+
+    if (par == ALL)
+        sites = lattice.mynode.sites;
+    else if (par == EVEN)
+        sites = lattice.mynode.evensites;
+    else
+        sites = lattice.mynode.oddsites;
+    entry.bytes += (double)bytes_per_site * sites;
+
+#ifdef GPU_SYNCHRONIZE_TIMERS
+    gpuStreamSynchronize(0);
+#endif
+
+    wait_start = gather_wait_time();
+    t_start = hila::gettime();
+}
+
+loop_profile_scope::~loop_profile_scope() {
+
+#ifdef GPU_SYNCHRONIZE_TIMERS
+    gpuStreamSynchronize(0);
+#endif
+
+    entry.time += hila::gettime() - t_start;
+    entry.gather_wait += gather_wait_time() - wait_start;
+    entry.count++;
+
+    if (event_trace_on) {
+        if (entry.trace_id < 0)
+            entry.trace_id =
+                trace_name_id(std::string("loop ") + entry.file + ":" + std::to_string(entry.line));
+        trace_record(entry.trace_id, 'X', t_start);
+    }
+}
+
+void loop_profile_scope::interior_done(size_t n_interior) {
+    entry.split_count++;
+    entry.interior_time += hila::gettime() - t_start;
+    entry.interior_sites += n_interior;
+    entry.split_sites += sites;
+}
+
+int64_t loop_profile_calls(const char *file) {
+    int64_t n = 0;
+    for (auto *e : loop_profile_list()) {
+        if (std::strcmp(e->file, file) == 0)
+            n += e->count;
+    }
+    return n;
+}
+
+void report_loop_profile() {
+    auto &list = loop_profile_list();
+    if (hila::myrank() != 0 || list.size() == 0)
+        return;
+
+    // template instantiations of the same loop are combined
+    std::map<std::pair<std::string, int>, loop_profile_entry> loops;
+    double total = 0;
+    for (auto *e : list) {
+        if (e->count == 0)
+            continue;
+        auto key = std::make_pair(std::string(e->file), e->line);
+        auto it = loops.find(key);
+        if (it == loops.end()) {
+            loops.emplace(key, *e);
+        } else {
+            it->second.count += e->count;
+            it->second.time += e->time;
+            it->second.gather_wait += e->gather_wait;
+            it->second.bytes += e->bytes;
+            it->second.split_count += e->split_count;
+            it->second.interior_time += e->interior_time;
+            it->second.interior_sites += e->interior_sites;
+            it->second.split_sites += e->split_sites;
+        }
+        total += e->time;
+    }
+
+    // sort by time, through an index list (hila::swap would make std::sort on
+    // entry pointers ambiguous)
+    std::vector<const loop_profile_entry *> entries;
+    for (auto &l : loops)
+        entries.push_back(&l.second);
+    std::vector<int> order(entries.size());
+    for (int i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(),
+              [&](int a, int b) { return entries[a]->time > entries[b]->time; });
+
+    char line[240], overlap[40];
+    hila::out << "SITE LOOP PROFILE, rank 0, " << entries.size() << " loops, total "
+              << total << " s (" << 100.0 * total / hila::gettime() << "% of run time)\n";
+    hila::out << "loop                                   calls     time(s)  "
+                 "fraction  time/call(ms)  gather wait(s)  GB/s  interior%  overlap%\n";
+    hila::out << "-----------------------------------------------------------------------"
+                 "----------------------------------------------------\n";
+    for (int i : order) {
+        const loop_profile_entry *e = entries[i];
+        std::string where = std::string(e->file) + ":" + std::to_string(e->line);
+        if (where.size() > 34)
+            where = "..." + where.substr(where.size() - 31);
+        // gather wait of the split loops is (nearly) all after the interior
+        if (e->split_count > 0)
+            std::snprintf(overlap, 40, " %10.1f %9.1f",
+                          100.0 * e->interior_sites / e->split_sites,
+                          100.0 * e->interior_time / (e->interior_time + e->gather_wait));
+        else
+            std::snprintf(overlap, 40, " %10s %9s", "-", "-");
+        std::snprintf(line, 240, "%-34s %10ld %11.4f %9.4f %14.5f %15.4f %9.3f%s\n",
+                      where.c_str(), (long)e->count, e->time, total > 0 ? e->time / total : 0,
+                      1e3 * e->time / e->count, e->gather_wait,
+                      e->time > 0 ? 1e-9 * e->bytes / e->time : 0, overlap);
+        hila::out << line;
+    }
+    hila::out << "-----------------------------------------------------------------------"
+                 "----------------------------------------------------\n";
+}
+
+} // namespace hila
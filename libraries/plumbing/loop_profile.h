@@ -0,0 +1,69 @@
+#ifndef LOOP_PROFILE_H
+#define LOOP_PROFILE_H
+
+#include "plumbing/defs.h"
+#include "plumbing/coordinates.h"
+
+namespace hila {
+
+////////////////////////////////////////////////////////////////
+/// Automatic site loop profiling.
+///
+/// When hilapp is run with option -loop-profile (make LOOP_PROFILE=1) each
+/// generated site loop is wrapped in
+///
+///     static hila::loop_profile_entry _prof_("file.cpp", line);
+///     hila::loop_profile_scope _prof_scope_(_prof_, bytes_per_site, parity);
+///
+/// The entry accumulates call count, wall clock time, gather wait time (time spent
+/// in wait_gather() during the loop) and the number of bytes touched.  The bytes
+/// per site are counted from the element sizes of the fields read (locally and
+/// from each neighbour direction) and written in the loop.
+///
+/// Loops which overlap gathers with computation call interior_done() after the
+/// interior sites, before waiting for the gathers.  For these the report shows the
+/// fraction of sites in the interior and the overlap efficiency, the time spent on the
+/// interior relative to the interior time plus the gather wait: 100% means the
+/// communication was completely hidden.
+///
+/// hila::finishrun() calls report_loop_profile(), which lists the loops of rank 0
+/// ordered by time, with the achieved bandwidth.  With '-trace <file>' each loop call
+/// is also an event in the timeline (see event_trace.h).
+////////////////////////////////////////////////////////////////
+
+struct loop_profile_entry {
+    const char *file;
+    int line;
+    int64_t count;
+    double time, gather_wait, bytes;
+    // loops with interior/boundary split: calls, interior time and sites, all sites
+    int64_t split_count;
+    double interior_time, interior_sites, split_sites;
+    int trace_id = -1; // name in the event trace
+
+    loop_profile_entry(const char *file, int line);
+};
+
+class loop_profile_scope {
+  private:
+    loop_profile_entry &entry;
+    double t_start, wait_start;
+    size_t sites;
+
+  public:
+    loop_profile_scope(loop_profile_entry &e, size_t bytes_per_site, Parity par);
+    ~loop_profile_scope();
+
+    /// interior sites of the loop done, gather wait follows
+    void interior_done(size_t n_interior);
+};
+
+void report_loop_profile();
+
+/// Number of calls of the profiled site loops in source file 'file' (name without
+/// path) on this rank.  0 if hilapp was not run with -loop-profile
+int64_t loop_profile_calls(const char *file);
+
+} // namespace hila
+
+#endif
@@ -12,6 +12,13 @@
 void *memalloc(std::size_t size);
 void *memalloc(std::size_t size, const char *filename, const unsigned line);
 
+/// Host memory pool for fields and MPI buffers on cpu targets (host_memory_pool.cpp).
+/// Memory from host_memory_pool_alloc() must be freed with host_memory_pool_free()
+void *host_memory_pool_alloc(std::size_t req_size);
+void host_memory_pool_free(void *ptr);
+void host_memory_pool_purge();
+void host_memory_pool_report();
+
 /// d_malloc allocates memory from "device": either from cpu or from gpu,
 /// depending on the target.  Free with d_free()
 void *d_malloc(std::size_t size);
@@ -0,0 +1,189 @@
+#ifndef MULTI_DOT_H
+#define MULTI_DOT_H
+
+#include "hila.h"
+
+//////////////////////////////////////////////////////////////////////////////////
+/// Fused inner products and linear combinations of several fields
+///
+///   auto G = hila::multi_dot(a, b, par);    // G[i][j] = sum_X a[i][X].dot(b[j][X])
+///   auto G = hila::multi_rdot(a, b, par);   // G[i][j] = sum_X real(a[i][X].dot(b[j][X]))
+///   hila::multi_axpy(y, c, x, par);         // y[X] += sum_i c[i] * x[i][X]
+///
+/// a, b and x are std::vector<Field<T>> or std::vector<const Field<T> *>.
+///
+/// hilapp does not allow the field in a site loop to depend on a loop-local
+/// variable, thus the fields are handled in tiles of MULTI_DOT_TILE x MULTI_DOT_TILE
+/// (MULTI_DOT_TILE for axpy) fields per site loop.  A Gram matrix of n vectors takes
+/// (n/4)^2 sweeps instead of n^2, and all tiles go into one delayed ReductionVector,
+/// i.e. there is only one allreduce.  Partial tiles repeat the last field, the
+/// extra products are computed from cached data and discarded.
+//////////////////////////////////////////////////////////////////////////////////
+
+#define MULTI_DOT_TILE 4
+
+namespace hila {
+
+namespace multi_dot_detail {
+
+/// dot or its real part, depending on the result type
+template <typename R, typename T>
+inline R dot_element(const T &a, const T &b) {
+    if constexpr (std::is_same<R, double>::value)
+        return ::real(a.dot(b));
+    else
+        return a.dot(b);
+}
+
+template <typename T>
+std::vector<const Field<T> *> pointers(const std::vector<Field<T>> &f) {
+    std::vector<const Field<T> *> p(f.size());
+    for (int i = 0; i < f.size(); i++)
+        p[i] = &f[i];
+    return p;
+}
+
+/// Products of the tile of a starting from ia and b starting from ib, added to
+/// rv[offset...offset + MULTI_DOT_TILE^2)
+template <typename R, typename T>
+void dot_tile(const std::vector<const Field<T> *> &a, int ia,
+              const std::vector<const Field<T> *> &b, int ib, ReductionVector<R> &rv,
+              int offset, Parity par) {
+
+    int la = a.size() - 1, lb = b.size() - 1;
+    const Field<T> &a0 = *a[ia];
+    const Field<T> &a1 = *a[std::min(ia + 1, la)];
+    const Field<T> &a2 = *a[std::min(ia + 2, la)];
+    const Field<T> &a3 = *a[std::min(ia + 3, la)];
+    const Field<T> &b0 = *b[ib];
+    const Field<T> &b1 = *b[std::min(ib + 1, lb)];
+    const Field<T> &b2 = *b[std::min(ib + 2, lb)];
+    const Field<T> &b3 = *b[std::min(ib + 3, lb)];
+
+    onsites(par) {
+        T x0 = a0[X], x1 = a1[X], x2 = a2[X], x3 = a3[X];
+        T y = b0[X];
+        rv[offset + 0] += dot_element<R>(x0, y);
+        rv[offset + 4] += dot_element<R>(x1, y);
+        rv[offset + 8] += dot_element<R>(x2, y);
+        rv[offset + 12] += dot_element<R>(x3, y);
+        y = b1[X];
+        rv[offset + 1] += dot_element<R>(x0, y);
+        rv[offset + 5] += dot_element<R>(x1, y);
+        rv[offset + 9] += dot_element<R>(x2, y);
+        rv[offset + 13] += dot_element<R>(x3, y);
+        y = b2[X];
+        rv[offset + 2] += dot_element<R>(x0, y);
+        rv[offset + 6] += dot_element<R>(x1, y);
+        rv[offset + 10] += dot_element<R>(x2, y);
+        rv[offset + 14] += dot_element<R>(x3, y);
+        y = b3[X];
+        rv[offset + 3] += dot_element<R>(x0, y);
+        rv[offset + 7] += dot_element<R>(x1, y);
+        rv[offset + 11] += dot_element<R>(x2, y);
+        rv[offset + 15] += dot_element<R>(x3, y);
+    }
+}
+
+template <typename R, typename T>
+std::vector<std::vector<R>> gram(const std::vector<const Field<T> *> &a,
+                                 const std::vector<const Field<T> *> &b, Parity par) {
+
+    constexpr int tile = MULTI_DOT_TILE;
+    static_assert(tile == 4, "dot_tile() is written out for MULTI_DOT_TILE 4");
+
+    int na = a.size(), nb = b.size();
+    std::vector<std::vector<R>> res(na, std::vector<R>(nb, 0));
+    if (na == 0 || nb == 0)
+        return res;
+
+    int ta = (na + tile - 1) / tile, tb = (nb + tile - 1) / tile;
+
+    ReductionVector<R> rv(ta * tb * tile * tile);
+    rv.allreduce(true).delayed(true);
+    rv = 0;
+
+    for (int i = 0; i < ta; i++)
+        for (int j = 0; j < tb; j++) {
+            dot_tile(a, i * tile, b, j * tile, rv, (i * tb + j) * tile * tile, par);
+        }
+
+    rv.reduce();
+
+    for (int i = 0; i < na; i++)
+        for (int j = 0; j < nb; j++) {
+            int t = (i / tile) * tb + j / tile;
+            res[i][j] = rv[t * tile * tile + (i % tile) * tile + j % tile];
+        }
+    return res;
+}
+
+} // namespace multi_dot_detail
+
+
+/// Complex inner products of all pairs, G[i][j] = sum_X a[i][X].dot(b[j][X])
+template <typename T>
+std::vector<std::vector<Complex<double>>> multi_dot(const std::vector<const Field<T> *> &a,
+                                                    const std::vector<const Field<T> *> &b,
+                                                    Parity par = ALL) {
+    return multi_dot_detail::gram<Complex<double>>(a, b, par);
+}
+
+template <typename T>
+std::vector<std::vector<Complex<double>>> multi_dot(const std::vector<Field<T>> &a,
+                                                    const std::vector<Field<T>> &b,
+                                                    Parity par = ALL) {
+    return multi_dot(multi_dot_detail::pointers(a), multi_dot_detail::pointers(b), par);
+}
+
+/// Real parts of the inner products, G[i][j] = sum_X real(a[i][X].dot(b[j][X]))
+template <typename T>
+std::vector<std::vector<double>> multi_rdot(const std::vector<const Field<T> *> &a,
+                                            const std::vector<const Field<T> *> &b,
+                                            Parity par = ALL) {
+    return multi_dot_detail::gram<double>(a, b, par);
+}
+
+template <typename T>
+std::vector<std::vector<double>> multi_rdot(const std::vector<Field<T>> &a,
+                                            const std::vector<Field<T>> &b,
+                                            Parity par = ALL) {
+    return multi_rdot(multi_dot_detail::pointers(a), multi_dot_detail::pointers(b), par);
+}
+
+/// y[X] += sum_i c[i] * x[i][X] on parity par.  c is real or complex
+template <typename T, typename S>
+void multi_axpy(Field<T> &y, const std::vector<S> &c, const std::vector<const Field<T> *> &x,
+                Parity par = ALL) {
+
+    constexpr int tile = MULTI_DOT_TILE;
+    static_assert(tile == 4, "multi_axpy() is written out for MULTI_DOT_TILE 4");
+    assert(c.size() == x.size() && "multi_axpy: coefficient and field counts differ");
+
+    int n = x.size();
+    for (int i = 0; i < n; i += tile) {
+        int l = n - 1;
+        const Field<T> &x0 = *x[i];
+        const Field<T> &x1 = *x[std::min(i + 1, l)];
+        const Field<T> &x2 = *x[std::min(i + 2, l)];
+        const Field<T> &x3 = *x[std::min(i + 3, l)];
+        S c0 = c[i];
+        S c1 = (i + 1 <= l) ? c[i + 1] : 0;
+        S c2 = (i + 2 <= l) ? c[i + 2] : 0;
+        S c3 = (i + 3 <= l) ? c[i + 3] : 0;
+
+        onsites(par) {
+            y[X] += c0 * x0[X] + c1 * x1[X] + c2 * x2[X] + c3 * x3[X];
+        }
+    }
+}
+
+template <typename T, typename S>
+void multi_axpy(Field<T> &y, const std::vector<S> &c, const std::vector<Field<T>> &x,
+                Parity par = ALL) {
+    multi_axpy(y, c, multi_dot_detail::pointers(x), par);
+}
+
+} // namespace hila
+
+#endif
@@ -50,6 +50,19 @@
 #undef EVEN_SITES_FIRST
 #endif
 
+/// TILED_LAYOUT
+/// With -DTILED_LAYOUT=n the sites of each MPI rank are stored in hypercubic tiles
+/// of n^NDIM sites (smaller at the upper edges of the rank), tiles and the sites
+/// inside them in x-fastest order, even sites first.  Then the neighbours in all
+/// directions are closer in memory; the effect on loop speed has not been measured,
+/// compare e.g. bench_links with and without.  Needs EVEN_SITES_FIRST, not available
+/// with the vector (SUBNODE_LAYOUT) layout.
+#ifdef TILED_LAYOUT
+#if !defined(EVEN_SITES_FIRST) || defined(SUBNODE_LAYOUT)
+static_assert(0 && "TILED_LAYOUT needs EVEN_SITES_FIRST and cannot be used with vector layout");
+#endif
+#endif
+
 /// NODE_LAYOUT_TRIVIAL or NODE_LAYOUT_BLOCK determine how MPI ranks are laid out on logical
 /// lattice.  TRIVIAL lays out the lattice on logical order where x-direction runs fastest etc.
 /// if NODE_LAYOUT_BLOCK is defined, NODE_LAYOUT_BLOCK consecutive MPI ranks are laid out so that
@@ -71,10 +84,73 @@
 #define WRITE_BUFFER_SIZE 2000000
 #endif
 
+/// PARALLEL_IO
+/// Binary Field and GaugeField files are written and read with MPI-IO, all ranks
+/// accessing their own part of the file.  The file format is not changed.
+/// Use -DPARALLEL_IO=0 to make rank 0 stream i/o the default; it can also be chosen
+/// at run time with '-parallel_io off'
+#ifndef PARALLEL_IO
+#define PARALLEL_IO
+#elif PARALLEL_IO == 0
+#undef PARALLEL_IO
+#endif
+
 
 // boundary conditions are "off" by default -- no need to do anything here
 // #ifndef SPECIAL_BOUNDARY_CONDITIONS
 
+/// FFT_PLAN_MEASURE
+/// On cpu targets FFTW plans are cached, thus it can pay off to spend more time
+/// planning.  -DFFT_PLAN_MEASURE makes plans with FFTW_MEASURE instead of FFTW_ESTIMATE.
+/// FFT_WISDOM_FILE
+/// With -DFFT_WISDOM_FILE=\"filename\" FFTW wisdom is read from the file (and
+/// "filename_float") and saved there at the end of the run.
+
+/// HOST_MEMORY_POOL
+/// On cpu targets fields and MPI buffers are allocated from a memory pool, which
+/// recycles freed blocks.  Turn off by using -DHOST_MEMORY_POOL=0 in Makefile
+#if !defined(CUDA) && !defined(HIP)
+#ifndef HOST_MEMORY_POOL
+#define HOST_MEMORY_POOL
+#elif HOST_MEMORY_POOL == 0
+#undef HOST_MEMORY_POOL
+#endif
+#endif
+
+/// SHM_HALO_EXCHANGE
+/// On cpu targets the halo exchange between ranks on the same node goes through
+/// MPI-3 shared memory windows instead of MPI messages.  Turn off by using
+/// -DSHM_HALO_EXCHANGE=0 in Makefile.
+/// SHM_HALO_BUFFER_MB: size of the shared send buffer arena / rank (in MB)
+/// SHM_HALO_SLOTS: max number of ongoing shared memory messages / direction
+#if !defined(CUDA) && !defined(HIP)
+#ifndef SHM_HALO_EXCHANGE
+#define SHM_HALO_EXCHANGE
+#elif SHM_HALO_EXCHANGE == 0
+#undef SHM_HALO_EXCHANGE
+#endif
+#endif
+
+#ifndef SHM_HALO_BUFFER_MB
+#define SHM_HALO_BUFFER_MB 128
+#endif
+
+#ifndef SHM_HALO_SLOTS
+#define SHM_HALO_SLOTS 64
+#endif
+
+/// FIELD_EXPRESSIONS
+/// If defined, whole-Field arithmetic (f = a + b * c.conj()) returns Field expressions on cpu
+/// targets, evaluated in one site loop when assigned, see field_expr.h.  Off by default, turn
+/// on by using -DFIELD_EXPRESSIONS in Makefile (FIELD_EXPRESSIONS=1 in make).  Not used on GPU targets, where every operator
+/// is evaluated to a new Field.
+#if defined(FIELD_EXPRESSIONS) && FIELD_EXPRESSIONS == 0
+#undef FIELD_EXPRESSIONS
+#endif
+#if defined(CUDA) || defined(HIP)
+#undef FIELD_EXPRESSIONS
+#endif
+
 ///////////////////////////////////////////////////////////////////////////
 // Special defines for GPU targets
 #if defined(CUDA) || defined(HIP)
@@ -6,6 +6,8 @@
 
 #include <random>
 
+#include "plumbing/counter_rng.h"
+
 // #ifndef OPENMP
 
 // static variable which holds the random state
@@ -17,10 +19,151 @@ static std::uniform_real_distribution<double> real_rnd_dist(0.0, 1.0);
 
 // #endif
 
+/////////////////////////////////////////////////////////////////////////
+// Per-site counter-based generator used inside site loops.
+// The key is the (unshuffled) seed, identical on all ranks, and the counter is
+//   ( global site index (64 bits), site loop number (low 32 bits), draw number / 2 )
+// Upper bits of the loop number are mixed into the key.
+// Each Philox block gives 2 doubles, draw number n uses words 2*(n%2), 2*(n%2)+1.
+
+#define MAX_SITE_RNG_LANES 16
+
+static uint64_t site_rng_key = 0;
+static uint64_t site_rng_loop_count = 0;
+static bool site_rng_in_loop = false;
+
+namespace {
+struct site_rng_state {
+    uint64_t site[MAX_SITE_RNG_LANES];
+    uint32_t block[4][MAX_SITE_RNG_LANES];
+    double gauss_second[MAX_SITE_RNG_LANES];
+    int lanes;
+    uint32_t draw;
+    bool has_gauss_second;
+};
+} // namespace
+
+// each thread has its own site
+static thread_local site_rng_state site_rng;
+
+template <int lanes>
+static inline void site_rng_lane_blocks(uint32_t k0, uint32_t k1) {
+    uint32_t c[4][lanes];
+    for (int i = 0; i < lanes; i++) {
+        c[0][i] = (uint32_t)site_rng.site[i];
+        c[1][i] = (uint32_t)(site_rng.site[i] >> 32);
+        c[2][i] = (uint32_t)site_rng_loop_count;
+        c[3][i] = site_rng.draw / 2;
+    }
+    hila::philox4x32_lanes<lanes>(c, k0, k1);
+    for (int w = 0; w < 4; w++)
+        for (int i = 0; i < lanes; i++)
+            site_rng.block[w][i] = c[w][i];
+}
+
+static void site_rng_new_block() {
+    uint32_t k0 = (uint32_t)site_rng_key;
+    uint32_t k1 = (uint32_t)(site_rng_key >> 32) ^ (uint32_t)(site_rng_loop_count >> 32);
+
+    switch (site_rng.lanes) {
+    case 4:
+        site_rng_lane_blocks<4>(k0, k1);
+        break;
+    case 8:
+        site_rng_lane_blocks<8>(k0, k1);
+        break;
+    case 16:
+        site_rng_lane_blocks<16>(k0, k1);
+        break;
+    default:
+        for (int i = 0; i < site_rng.lanes; i++) {
+            uint32_t c[4] = {(uint32_t)site_rng.site[i], (uint32_t)(site_rng.site[i] >> 32),
+                             (uint32_t)site_rng_loop_count, site_rng.draw / 2};
+            hila::philox4x32(c, k0, k1);
+            for (int w = 0; w < 4; w++)
+                site_rng.block[w][i] = c[w];
+        }
+    }
+}
+
+// Uniform random numbers in [0,1) to all lanes
+static inline void site_rng_uniform(double *out, int lanes) {
+    if ((site_rng.draw & 1) == 0)
+        site_rng_new_block();
+    int w = 2 * (site_rng.draw & 1);
+    for (int i = 0; i < lanes; i++)
+        out[i] = hila::philox_to_double(site_rng.block[w][i], site_rng.block[w + 1][i]);
+    site_rng.draw++;
+}
+
+void hila::begin_site_rng_loop() {
+    site_rng_loop_count++;
+    site_rng_in_loop = true;
+}
+
+void hila::end_site_rng_loop() {
+    site_rng_in_loop = false;
+}
+
+void hila::set_site_rng(unsigned idx) {
+    site_rng.lanes = 1;
+    site_rng.site[0] = SiteIndex(lattice.coordinates(idx)).value;
+    site_rng.draw = 0;
+    site_rng.has_gauss_second = false;
+}
+
+void hila::set_site_rng_vector(unsigned vidx, int vector_size) {
+    assert(vector_size <= MAX_SITE_RNG_LANES);
+    site_rng.lanes = vector_size;
+    for (int i = 0; i < vector_size; i++)
+        site_rng.site[i] = SiteIndex(lattice.coordinates(vidx * vector_size + i)).value;
+    site_rng.draw = 0;
+    site_rng.has_gauss_second = false;
+}
+
+/**
+ *@details Used by the vector types (AVX) in vectorized site loops.  lanes must be
+ * the vector size given in set_site_rng_vector().
+ */
+void hila::site_random_lanes(double *out, int lanes) {
+    assert(lanes == site_rng.lanes && "vector length mismatch in site random numbers");
+    site_rng_uniform(out, lanes);
+}
+
+/**
+ *@details Box-Muller as in hila::gaussrand2(), lane by lane
+ */
+void hila::site_gaussrand2_lanes(double *out, double *out2, int lanes) {
+    assert(lanes == site_rng.lanes && "vector length mismatch in site random numbers");
+    double phi[MAX_SITE_RNG_LANES], urnd[MAX_SITE_RNG_LANES];
+    site_rng_uniform(phi, lanes);
+    site_rng_uniform(urnd, lanes);
+    for (int i = 0; i < lanes; i++) {
+        double r = sqrt(-::log(1.0 - urnd[i]) * 2.0);
+        out2[i] = r * cos(2.0 * M_PI * phi[i]);
+        out[i] = r * sin(2.0 * M_PI * phi[i]);
+    }
+}
+
+void hila::site_gaussrand_lanes(double *out, int lanes) {
+    if (site_rng.has_gauss_second) {
+        site_rng.has_gauss_second = false;
+        for (int i = 0; i < lanes; i++)
+            out[i] = site_rng.gauss_second[i];
+    } else {
+        site_gaussrand2_lanes(out, site_rng.gauss_second, lanes);
+        site_rng.has_gauss_second = true;
+    }
+}
 
 // In GPU code hila::random() defined in hila_gpu.cpp
 #if !defined(CUDA) && !defined(HIP)
 double hila::random() {
+    if (site_rng_in_loop) {
+        double r[MAX_SITE_RNG_LANES];
+        site_rng_uniform(r, site_rng.lanes);
+        return r[0];
+    }
     return real_rnd_dist(mersenne_twister_gen);
 }
 
@@ -112,6 +255,10 @@ void hila::seed_random(uint64_t seed, bool device_init) {
     if (hila::partitions.number() > 1)
         seed = seed ^ ((static_cast<uint64_t>(hila::partitions.mylattice())) << 28);
 
+    // key of the per-site generator is the same on all ranks
+    site_rng_key = seed;
+    site_rng_loop_count = 0;
+
 #ifndef SITERAND
 
     hila::out0 << "Using node random numbers, seed for node 0: " << seed << std::endl;
@@ -214,6 +361,12 @@ double hila::gaussrand2(double &out2) {
 double hila::gaussrand() {
     static double second;
     static bool draw_new = true;
+    if (site_rng_in_loop) {
+        // inside site loop, use the (thread local) site generator
+        double r[MAX_SITE_RNG_LANES];
+        hila::site_gaussrand_lanes(r, site_rng.lanes);
+        return r[0];
+    }
     if (draw_new) {
         draw_new = false;
         return hila::gaussrand2(second);
@@ -82,11 +82,61 @@ double gaussrand();
 #pragma hila contains_rng loop_function
 double gaussrand2(double &out2);
 
+/**
+ *@brief `hila::gaussrand2` for other floating point types than double, e.g. float
+ */
+template <typename T, std::enable_if_t<std::is_floating_point<T>::value, int> = 0>
+T gaussrand2(T &out2) {
+    double d;
+    T r = hila::gaussrand2(d);
+    out2 = d;
+    return r;
+}
+
 /**
  *@brief Check if RNG is initialized, do what the name says.
  */  
 void check_that_rng_is_initialized();
 
+/////////////////////////////////////////////////////////////////////////////////////////////////
+// Per-site random numbers in site loops (non-GPU targets)
+//
+// Inside onsites() loops hila::random() and hila::gaussrand() use a counter-based generator
+// (Philox4x32-10, see counter_rng.h), keyed by the seed and the global site index and the running
+// number of the site loop.  The random numbers do not depend on the MPI layout, number of
+// OpenMP threads or vectorization, and loops with random numbers can be run in parallel.
+// Outside site loops the host generator (std::mt19937_64) is used as before.
+//
+// The calls below are inserted by hilapp, they are not meant to be used in user code.
+
+/**
+ *@brief Start a site loop using random numbers, advances the site loop counter
+ *@details Not thread safe: inside '#pragma hila omp_parallel_region' hilapp calls this and
+ * end_site_rng_loop() in omp single
+ */
+void begin_site_rng_loop();
+
+/**
+ *@brief End of a site loop using random numbers, random() returns to the host generator
+ */
+void end_site_rng_loop();
+
+/**
+ *@brief Set the per-site generator (of the current thread) to site with node index idx
+ */
+void set_site_rng(unsigned idx);
+
+/**
+ *@brief Vectorized loops: set the generator to the sites of vector index vidx.
+ *       Lane i of the vector is site vidx*vector_size + i.
+ */
+void set_site_rng_vector(unsigned vidx, int vector_size);
+
+// Fill lanes of vectorized site loops with uniform [0,1) or gaussian random numbers
+void site_random_lanes(double *out, int lanes);
+void site_gaussrand_lanes(double *out, int lanes);
+void site_gaussrand2_lanes(double *out, double *out2, int lanes);
+
 /**
  *@brief Template function `const T & hila::random(T & var)`
  *       sets the argument to a random value, and return a constant reference to it.
@@ -64,6 +64,9 @@ namespace hila {
 ///                            bin the square norm of k-space field f
 ///   std::vector<double> spectraldensity(const Field<T> &f)
 ///                            FFT real-space field f and bin the result in squarenorm
+///   bin_k_field(const half_k_field<T> &h), bin_k_field_squarenorm(const half_k_field<T> &h)
+///                            same for the result of FFT_real_to_half(), the mirror
+///                            points -k are included
 ///
 ///   double k(int b)                  return the average k within bin b
 ///   long count(int b)                return the number of points within bin b
@@ -224,6 +227,61 @@ class k_binning {
     }
 
 
+    /// Bin the half k-lattice field from FFT_real_to_half().  The result is the same
+    /// as binning the full complex field: value at mirror point -k is F(k)^*, and
+    /// -k falls in the same bin
+
+    template <typename T>
+    std::vector<Complex<T>> bin_k_field(const half_k_field<T> &f) {
+
+        binning_timer.start();
+
+        if (k_avg.size() != par.bins)
+            sd_calculate_bin_info();
+
+        std::vector<Complex<T>> s(par.bins, 0);
+
+        f.for_each([&](const CoordinateVector &k, const Complex<T> &v, int mult) {
+            int b = sd_get_k_bin(k, par);
+            if (b >= 0 && b < par.bins) {
+                if (mult == 2)
+                    s[b] += 2 * v.real();
+                else
+                    s[b] += v;
+            }
+        });
+
+        hila::reduce_node_sum(s.data(), par.bins, false);
+
+        binning_timer.stop();
+
+        return s;
+    }
+
+    template <typename T>
+    std::vector<double> bin_k_field_squarenorm(const half_k_field<T> &f) {
+
+        binning_timer.start();
+
+        if (k_avg.size() != par.bins)
+            sd_calculate_bin_info();
+
+        std::vector<double> s(par.bins, 0);
+
+        f.for_each([&](const CoordinateVector &k, const Complex<T> &v, int mult) {
+            int b = sd_get_k_bin(k, par);
+            if (b >= 0 && b < par.bins) {
+                s[b] += mult * v.squarenorm();
+            }
+        });
+
+        hila::reduce_node_sum(s.data(), par.bins, false);
+
+        binning_timer.stop();
+
+        return s;
+    }
+
     //////////////////////////////////////////////////////////////////////////////////
     /// Spectral density
     /// This version takes in complex field
@@ -238,12 +296,21 @@ class k_binning {
     }
 
     //////////////////////////////////////////////////////////////////////////////////
-    /// interface for real fields - an extra copy which could be avoided
+    /// interface for real fields.  Field<double> and Field<float> use the
+    /// real-to-complex transform with fftw, others an extra copy which could be avoided
     template <typename T, std::enable_if_t<!hila::contains_complex<T>::value, int> = 0>
     std::vector<double> spectraldensity(const Field<T> &f) {
 
         using cmplx_t = Complex<hila::arithmetic_type<T>>;
 
+#if defined(USE_FFTW)
+        if constexpr (std::is_same<T, double>::value || std::is_same<T, float>::value) {
+            half_k_field<T> h;
+            FFT_real_to_half(f, h);
+
+            return bin_k_field_squarenorm(h);
+        } else
+#endif
         if constexpr (sizeof(T) % sizeof(Complex<hila::arithmetic_type<T>>) == 0) {
             // real field, size is even -- cast the field to pseudo-complex
             // This works because layouts are compatible in all archs - if this changes
@@ -10,6 +10,7 @@
 //////////////////////////////////////////////////////////////////
 
 #include "com_mpi.h"
+#include "lattice.h"
 
 // these includes need to be outside namespace hila
 #include <csignal>
@@ -27,6 +28,9 @@ static double start_time = -1.0;
 // store all timers in use
 std::vector<timer *> timer_list = {};
 
+// print cross-rank timer statistics in report_timers()
+bool timer_statistics = false;
+
 // initialize timer to this timepoint
 void timer::init(const char *tag) {
     if (tag != nullptr)
@@ -90,6 +94,12 @@ double timer::stop() {
     double e = hila::gettime();
     t_total += (e - t_start);
     count++;
+
+    if (event_trace_on) {
+        if (trace_id < 0)
+            trace_id = trace_name_id(label.size() > 0 ? label : "timer");
+        trace_record(trace_id, 'X', t_start);
+    }
     return e;
 }
 
@@ -157,6 +167,121 @@ void report_timers() {
             hila::out << "No timers defined\n";
         }
     }
+
+    if (timer_statistics && hila::number_of_nodes() > 1)
+        report_timer_statistics();
+}
+
+/////////////////////////////////////////////////////////////////
+/// Timer statistics over the ranks of the lattice.  The timers are matched by
+/// label to the timer list of rank 0 (n:th timer with the same label to the n:th),
+/// timers which rank 0 has not started are not shown.  Collective.
+
+static void print_timer_statistics_line(const std::string &label, double tmin, double tmean,
+                                        double tmax, int maxrank) {
+    char line[202];
+    std::snprintf(line, 200, "%-20s: %12.5f %12.5f %12.5f %8d %9.3f\n", label.c_str(), tmin,
+                  tmean, tmax, maxrank, tmean > 0 ? tmax / tmean : 1.0);
+    hila::out << line;
+}
+
+void report_timer_statistics() {
+
+    // labels of rank 0, separated by newlines
+    std::string labels;
+    if (hila::myrank() == 0) {
+        for (auto tp : timer_list) {
+            labels += tp->get_label();
+            labels += '\n';
+        }
+    }
+    hila::broadcast(labels);
+
+    std::vector<std::string> label_list;
+    for (size_t start = 0, end; (end = labels.find('\n', start)) != std::string::npos;
+         start = end + 1) {
+        label_list.push_back(labels.substr(start, end - start));
+    }
+    int n = label_list.size();
+    if (n == 0)
+        return;
+
+    // value of the matching timer on this rank, 0 if not found.  Timers with
+    // unbalanced start/stop are flagged with -1 and left out
+    std::vector<double> tval(n, 0.0);
+    std::vector<int> is_comm(n, 0), err(n, 0);
+    std::vector<bool> used(timer_list.size(), false);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < timer_list.size(); j++) {
+            if (!used[j] && timer_list[j]->get_label() == label_list[i]) {
+                used[j] = true;
+                tval[i] = timer_list[j]->value().time;
+                is_comm[i] = timer_list[j]->is_comm_timer();
+                err[i] = timer_list[j]->has_error();
+                break;
+            }
+        }
+    }
+
+    std::vector<double> tmin(n), tsum(n);
+    std::vector<int> terr(n);
+    struct double_int {
+        double val;
+        int rank;
+    };
+    std::vector<double_int> tloc(n), tmax(n);
+    for (int i = 0; i < n; i++) {
+        tloc[i].val = tval[i];
+        tloc[i].rank = hila::myrank();
+    }
+
+    MPI_Reduce(tval.data(), tmin.data(), n, MPI_DOUBLE, MPI_MIN, 0, lattice.mpi_comm_lat);
+    MPI_Reduce(tval.data(), tsum.data(), n, MPI_DOUBLE, MPI_SUM, 0, lattice.mpi_comm_lat);
+    MPI_Reduce(tloc.data(), tmax.data(), n, MPI_DOUBLE_INT, MPI_MAXLOC, 0, lattice.mpi_comm_lat);
+    MPI_Reduce(err.data(), terr.data(), n, MPI_INT, MPI_MAX, 0, lattice.mpi_comm_lat);
+
+    if (hila::myrank() != 0)
+        return;
+
+    int nodes = hila::number_of_nodes();
+    double compute_mean = 0, comm_mean = 0;
+
+    hila::out << "TIMER STATISTICS over " << nodes
+              << " ranks:  min(sec)    mean(sec)     max(sec) max rank  max/mean\n";
+    for (int comm = 0; comm <= 1; comm++) {
+        if (comm == 0)
+            hila::out << "-- compute ------------------------------------------------"
+                         "---------------------\n";
+        else
+            hila::out << "-- communication ------------------------------------------"
+                         "---------------------\n";
+
+        for (int i = 0; i < n; i++) {
+            if (is_comm[i] != comm)
+                continue;
+            if (terr[i]) {
+                char line[202];
+                std::snprintf(line, 200, "%-20s: error:unbalanced start/stop\n",
+                              label_list[i].c_str());
+                hila::out << line;
+                continue;
+            }
+            double mean = tsum[i] / nodes;
+            print_timer_statistics_line(label_list[i], tmin[i], mean, tmax[i].val,
+                                        tmax[i].rank);
+            if (comm)
+                comm_mean += mean;
+            else
+                compute_mean += mean;
+        }
+    }
+    hila::out << "-----------------------------------------------------------------"
+                 "--------------\n";
+    // timers may be nested, thus sums are only indicative
+    hila::out << "Sum of mean times: compute " << compute_mean << " s, communication "
+              << comm_mean << " s\n";
+    hila::out << "-----------------------------------------------------------------"
+                 "--------------\n";
 }
 
 /////////////////////////////////////////////////////////////////
@@ -27,6 +27,13 @@ struct timer_value {
 /// All timer values are automatically reported on program exit (hila::finishrun calls
 /// report_timers())
 ///
+/// With command line option '-timer_stats on' (or hila::timer_statistics = true)
+/// report_timers() gathers also each timer from all ranks and prints min/mean/max,
+/// the rank with the max and the imbalance ratio max/mean.  Timers constructed as
+///       static timer comm_timer("Comm", true);
+/// are communication timers (MPI wait, reductions, ...) and are listed separately,
+/// so that communication and load imbalance can be read off directly.
+///
 /// Timer can be reset with
 ///       loop_timer.reset();
 ///
@@ -60,13 +67,16 @@ class timer {
     int64_t count; // need more than 32 bits
     std::string label;
     bool is_on, is_error;
+    bool is_comm = false;
+    int trace_id = -1; // name in the event trace
 
   public:
     // initialize timer to this timepoint
     timer() {
         init(nullptr);
     }
-    timer(const char *tag) {
+    timer(const char *tag, bool comm = false) {
+        is_comm = comm;
         init(tag);
     }
 
@@ -83,9 +93,24 @@ class timer {
     void report(bool print_not_timed = false);
 
     timer_value value();
+
+    const std::string &get_label() const {
+        return label;
+    }
+    bool is_comm_timer() const {
+        return is_comm;
+    }
+    bool has_error() const {
+        return is_error;
+    }
 };
 
+/// report_timers() prints also cross-rank statistics if this is true.
+/// All ranks must then call report_timers() (hila::finishrun() does)
+extern bool timer_statistics;
+
 void report_timers();
+void report_timer_statistics();
 
 //////////////////////////////////////////////////////////////////
 // Prototypes
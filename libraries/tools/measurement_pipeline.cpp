@@ -0,0 +1,141 @@
+#include "measurement_pipeline.h"
+
+namespace hila {
+
+static hila::timer backpressure_timer("pipeline backpressure");
+static hila::timer pipeline_send_timer("pipeline send");
+
+// message tags, in MPI_COMM_WORLD between the partner ranks
+constexpr int PIPELINE_DATA_TAG = 30001;
+constexpr int PIPELINE_ACK_TAG = 30002;
+
+void measurement_pipeline::setup() {
+    producer = consumer = false;
+    partner = -1;
+
+    if (hila::partitions.number() == 1 || hila::check_input)
+        return;
+
+    if (hila::partitions.number() != 2) {
+        hila::out0 << "measurement_pipeline: needs 2 partitions, now "
+                   << hila::partitions.number() << '\n';
+        hila::terminate(1);
+    }
+
+    // find the partner rank: same rank in the other partition
+    int world_rank, world_size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+    std::vector<int> info(2 * world_size), my = {(int)hila::partitions.mylattice(),
+                                                 hila::myrank()};
+    MPI_Allgather(my.data(), 2, MPI_INT, info.data(), 2, MPI_INT, MPI_COMM_WORLD);
+    for (int r = 0; r < world_size; r++) {
+        if (info[2 * r] != my[0] && info[2 * r + 1] == my[1])
+            partner = r;
+    }
+    if (partner < 0) {
+        hila::out << "measurement_pipeline: partitions have different numbers of ranks\n";
+        hila::terminate(1);
+    }
+
+    producer = (hila::partitions.mylattice() == 0);
+    consumer = !producer;
+
+    if (producer) {
+        max_slots = std::max(1, (int)(buffer_mb * 1024 * 1024 / snapshot_bytes));
+        // all ranks must have the same limit
+        MPI_Allreduce(MPI_IN_PLACE, &max_slots, 1, MPI_INT, MPI_MIN, lattice.mpi_comm_lat);
+        slots.resize(max_slots);
+        send_request.resize(max_slots);
+        hila::out0 << "Measurement pipeline: sending snapshots to partition 1, buffer "
+                   << buffer_mb << " MB, up to " << max_slots << " snapshots\n";
+    } else
+        hila::out0 << "Measurement pipeline: measuring snapshots from partition 0\n";
+}
+
+/// Wait for the acknowledgement of the oldest snapshot in flight and free its slot
+void measurement_pipeline::wait_ack() {
+    if (!ack_posted) {
+        MPI_Irecv(&ack, 1, MPI_INT, partner, PIPELINE_ACK_TAG, MPI_COMM_WORLD, &ack_request);
+        ack_posted = true;
+    }
+    MPI_Wait(&ack_request, MPI_STATUS_IGNORE);
+    ack_posted = false;
+
+    MPI_Wait(&send_request[first_slot], MPI_STATUS_IGNORE);
+    first_slot = (first_slot + 1) % max_slots;
+    n_in_flight--;
+}
+
+/// Free slot for a snapshot, waits if the buffers are full
+std::vector<char> &measurement_pipeline::acquire_slot() {
+    // collect acknowledgements which have arrived
+    while (n_in_flight > 0) {
+        if (!ack_posted) {
+            MPI_Irecv(&ack, 1, MPI_INT, partner, PIPELINE_ACK_TAG, MPI_COMM_WORLD,
+                      &ack_request);
+            ack_posted = true;
+        }
+        int done;
+        MPI_Test(&ack_request, &done, MPI_STATUS_IGNORE);
+        if (!done)
+            break;
+        ack_posted = false;
+        MPI_Wait(&send_request[first_slot], MPI_STATUS_IGNORE);
+        first_slot = (first_slot + 1) % max_slots;
+        n_in_flight--;
+    }
+
+    if (n_in_flight == max_slots) {
+        backpressure_timer.start();
+        wait_ack();
+        backpressure_timer.stop();
+    }
+
+    std::vector<char> &buf = slots[(first_slot + n_in_flight) % max_slots];
+    buf.resize(snapshot_bytes);
+    return buf;
+}
+
+/// Send the slot filled after acquire_slot()
+void measurement_pipeline::post_slot() {
+    pipeline_send_timer.start();
+    int s = (first_slot + n_in_flight) % max_slots;
+    MPI_Isend(slots[s].data(), (int)slots[s].size(), MPI_BYTE, partner, PIPELINE_DATA_TAG,
+              MPI_COMM_WORLD, &send_request[s]);
+    n_in_flight++;
+    pipeline_send_timer.stop();
+}
+
+bool measurement_pipeline::receive_bytes(int64_t &trajectory) {
+    MPI_Status status;
+    int count;
+    MPI_Probe(partner, PIPELINE_DATA_TAG, MPI_COMM_WORLD, &status);
+    MPI_Get_count(&status, MPI_BYTE, &count);
+    receive_buffer.resize(count);
+    MPI_Recv(receive_buffer.data(), count, MPI_BYTE, partner, PIPELINE_DATA_TAG, MPI_COMM_WORLD,
+             MPI_STATUS_IGNORE);
+
+    // received, the producer can reuse the buffer
+    int a = 1;
+    MPI_Send(&a, 1, MPI_INT, partner, PIPELINE_ACK_TAG, MPI_COMM_WORLD);
+
+    std::memcpy(&trajectory, receive_buffer.data(), sizeof(int64_t));
+    return trajectory >= 0;
+}
+
+void measurement_pipeline::finish() {
+    if (!producer)
+        return;
+
+    while (n_in_flight > 0)
+        wait_ack();
+
+    // stop message is a bare trajectory number -1, sent outside the snapshot buffers
+    int64_t stop = -1;
+    MPI_Send(&stop, sizeof(int64_t), MPI_BYTE, partner, PIPELINE_DATA_TAG, MPI_COMM_WORLD);
+    MPI_Recv(&ack, 1, MPI_INT, partner, PIPELINE_ACK_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    producer = false;
+}
+
+} // namespace hila
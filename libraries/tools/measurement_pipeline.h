@@ -0,0 +1,130 @@
+/**
+ * @file measurement_pipeline.h
+ * @brief Hand gauge field snapshots from the update partition to a measurement partition
+ *
+ */
+#ifndef MEASUREMENT_PIPELINE_H
+#define MEASUREMENT_PIPELINE_H
+
+#include "hila.h"
+
+namespace hila {
+
+/**
+ * @brief Asynchronous measurement pipeline between two partitions ('-partitions 2')
+ *
+ * @details Partition 0 (producer) generates configurations and sends snapshots of the
+ * gauge field with send(); partition 1 (consumer) receives them in trajectory order with
+ * receive() and runs the expensive measurements (e.g. gradient flow) while the producer
+ * continues.  Rank n of the producer sends its local part of the field directly to rank n
+ * of the consumer, both partitions have the same lattice and layout.
+ *
+ *     hila::measurement_pipeline pipe(U, buffer_mb);
+ *     if (pipe.is_consumer()) {
+ *         int64_t trajectory;
+ *         while (pipe.receive(V, trajectory))
+ *             measure(V, trajectory);
+ *         hila::finishrun();
+ *     }
+ *     ...
+ *     for (...) {
+ *         update(U);
+ *         pipe.send(U, trajectory);
+ *     }
+ *     pipe.finish();
+ *
+ * Backpressure: the consumer acknowledges each snapshot it has received.  The producer
+ * keeps the snapshots not yet acknowledged in its send buffers, at most buffer_mb
+ * megabytes (at least one snapshot).  The number of buffers is fixed at construction from
+ * the snapshot size of the field type.  When the buffers are full send() waits, the wait
+ * is timed by the timer "pipeline backpressure".
+ */
+class measurement_pipeline {
+  private:
+    bool producer, consumer;
+    int partner; // world rank of the corresponding rank in the other partition
+    double buffer_mb;
+    size_t snapshot_bytes;
+    int max_slots = 0;
+
+    // producer: send buffers in use, oldest first
+    std::vector<std::vector<char>> slots;
+    std::vector<MPI_Request> send_request;
+    int first_slot = 0, n_in_flight = 0;
+    int ack;
+    MPI_Request ack_request;
+    bool ack_posted = false;
+
+    // consumer
+    std::vector<char> receive_buffer;
+
+    void setup();
+    std::vector<char> &acquire_slot();
+    void post_slot();
+    void wait_ack();
+    bool receive_bytes(int64_t &trajectory);
+
+  public:
+    /// Needs exactly 2 partitions for the pipeline to be enabled.  U gives the type of
+    /// the snapshots, buffer_mb is the memory limit for snapshots waiting for the consumer
+    template <typename T>
+    measurement_pipeline(const GaugeField<T> &U, double buffer_mb)
+        : buffer_mb(buffer_mb),
+          snapshot_bytes(sizeof(int64_t) + NDIM * lattice.mynode.volume() * sizeof(T)) {
+        setup();
+    }
+
+    /// false when running without partitions: measure inline
+    bool enabled() const {
+        return producer || consumer;
+    }
+    bool is_producer() const {
+        return producer;
+    }
+    bool is_consumer() const {
+        return consumer;
+    }
+
+    /// Send a snapshot of U, called by all ranks of the producer
+    template <typename T>
+    void send(const GaugeField<T> &U, int64_t trajectory) {
+        std::vector<T> local;
+        size_t fieldsize = lattice.mynode.volume() * sizeof(T);
+        assert(sizeof(int64_t) + NDIM * fieldsize == snapshot_bytes &&
+               "measurement_pipeline: send() field type differs from the constructor");
+        std::vector<char> &buf = acquire_slot();
+        std::memcpy(buf.data(), &trajectory, sizeof(int64_t));
+        foralldir(d) {
+            U[d].copy_local_data(local);
+            std::memcpy(buf.data() + sizeof(int64_t) + (int)d * fieldsize, local.data(), fieldsize);
+        }
+        post_slot();
+    }
+
+    /// Receive the next snapshot into U, called by all ranks of the consumer.
+    /// Returns false when the producer has finished
+    template <typename T>
+    bool receive(GaugeField<T> &U, int64_t &trajectory) {
+        if (!receive_bytes(trajectory))
+            return false;
+        size_t fieldsize = lattice.mynode.volume() * sizeof(T);
+        if (receive_buffer.size() != sizeof(int64_t) + NDIM * fieldsize) {
+            hila::out << "measurement_pipeline: snapshot size mismatch\n";
+            hila::terminate(1);
+        }
+        std::vector<T> local(lattice.mynode.volume());
+        foralldir(d) {
+            std::memcpy(local.data(), receive_buffer.data() + sizeof(int64_t) + (int)d * fieldsize,
+                        fieldsize);
+            U[d].set_local_data(local);
+        }
+        return true;
+    }
+
+    /// Tell the consumer to stop and wait until all snapshots are received
+    void finish();
+};
+
+} // namespace hila
+
+#endif
@@ -8,8 +8,10 @@
 #include <vector>
 #include <algorithm>
 #include <regex>
+#include <array>
 #include <cmath>
 #include "hila.h"
+#include "plumbing/counter_rng.h"
 #include "tools/multicanonical.h"
 
 using string = std::string;
@@ -174,13 +176,24 @@ static int_vector g_N_OP_BinTotal(1,0);
 static int g_WeightIterationCount = 0;
 static bool g_WeightIterationFlag = true;
 
+// Multi-walker state: merge histograms of all partitions, number of
+// walker samples binned since the last weight update
+static bool g_PartitionWalkers = false;
+static int g_WalkerSamples = 0;
+
+// Key and counter of the accept/reject random stream, identical on all
+// ranks of a partition so that the decision needs no communication
+static uint32_t g_ARKey[2] = {0, 0};
+static uint64_t g_ARCounter = 0;
+
 namespace hila
 {
 namespace muca
 {
 
-// Pointer to the iteration function
+// Pointers to the iteration function, single and multiple walkers
 iteration_pointer iterate_weights;
+multi_iteration_pointer iterate_weights_multi;
 
 // Pointer to the finish condition check
 finish_condition_pointer finish_check;
@@ -492,18 +505,14 @@ double weight_function(double OP)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief process 0 interface to "weight function" for the user accessing
-///        the weights.
+/// @brief Interface to "weight function" for the user accessing the weights.
+/// @details The weights are kept identical on all ranks. The order parameter
+///          is taken from rank 0, so that all ranks return the same value even
+///          if OP was reduced to rank 0 only.
 ////////////////////////////////////////////////////////////////////////////////
 double weight(double OP)
 {
-    double val;
-    if (hila::myrank() == 0)
-    {
-        val = weight_function(OP);
-    }
-    hila::broadcast(val);
-    return val;
+    return weight_function(hila::broadcast(OP));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -513,7 +522,7 @@ double weight(double OP)
 ////////////////////////////////////////////////////////////////////////////////
 void set_weight_iter_flag(bool YN)
 {
-    if (hila::myrank() == 0) g_WeightIterationFlag = YN;
+    g_WeightIterationFlag = YN;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -523,10 +532,7 @@ void set_weight_iter_flag(bool YN)
 ////////////////////////////////////////////////////////////////////////////////
 bool check_weight_iter_flag()
 {
-    bool flag;
-    if (hila::myrank() == 0) flag = g_WeightIterationFlag;
-    hila::broadcast(flag);
-    return flag;
+    return hila::broadcast(g_WeightIterationFlag);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -534,6 +540,8 @@ bool check_weight_iter_flag()
 /// @details Using the values of the old and new order parameters the muca
 ///          update is accepted with the logarithmic probability
 ///          log(P) = - (W(OP_new) - W(OP_old))
+///          The order parameters are taken from rank 0, thus they need not be
+///          valid on the other ranks (e.g. reductions with allreduce(false)).
 ///
 /// @param  OP_old     current order parameter
 /// @param  OP_new     order parameter of proposed configuration
@@ -543,43 +551,40 @@ bool check_weight_iter_flag()
 bool accept_reject(const double OP_old, const double OP_new)
 {
     bool update;
-    bool AR_iterate;
-    // Only compute on node 0, broadcast to others
-    if (hila::myrank() == 0)
+    // All ranks compute the same decision from the order parameters of rank 0:
+    // the weights are cached on every rank and the random number comes from a
+    // stream shared by the partition.
+    std::array<double, 2> OPs = {OP_old, OP_new};
+    hila::broadcast(OPs);
+
+    double W_new = weight_function(OPs[1]);
+    double W_old = weight_function(OPs[0]);
+
+    // get log(exp(-delta(W))) = -delta(W)
+    // (just like -delta(S) in Metropolis-Hastings)
+    double log_P = - (W_new - W_old);
+
+    // Get a random uniform from [0,1] and return a boolean indicating
+    // whether the update is to be accepted.
+    uint32_t c[4] = {static_cast<uint32_t>(g_ARCounter),
+                     static_cast<uint32_t>(g_ARCounter >> 32), 0, 0};
+    g_ARCounter++;
+    hila::philox4x32(c, g_ARKey[0], g_ARKey[1]);
+    double rval = hila::philox_to_double(c[0], c[1]);
+    if (::log(rval) < log_P)
     {
-        double W_new = weight_function(OP_new);
-        double W_old = weight_function(OP_old);
-
-        // get log(exp(-delta(W))) = -delta(W)
-        // (just like -delta(S) in Metropolis-Hastings)
-        double log_P = - (W_new - W_old);
-
-        // Get a random uniform from [0,1] and return a boolean indicating
-        // whether the update is to be accepted.
-        double rval = hila::random();
-        if (::log(rval) < log_P)
-        {
-            update = true;
-        }
-        else
-        {
-            update = false;
-        }
-
-        // Get value from process 0
-        AR_iterate = g_WParam.AR_iteration;
+        update = true;
+    }
+    else
+    {
+        update = false;
     }
-
-    // Broadcast the update status to other processes along with the
-    // weight iteration parameter
-    hila::broadcast(update);
-    hila::broadcast(AR_iterate);
 
     // Check if iteration is enabled
-    if (AR_iterate)
+    if (g_WParam.AR_iteration)
     {
-        if (update) set_weight_iter_flag(iterate_weights(OP_new));
-        else set_weight_iter_flag(iterate_weights(OP_old));
+        if (update) set_weight_iter_flag(iterate_weights(OPs[1]));
+        else set_weight_iter_flag(iterate_weights(OPs[0]));
     }
 
     return update;
@@ -953,59 +958,112 @@ static void initialise_weight_vectors()
 ////////////////////////////////////////////////////////////////////////////////
 static bool iterate_weight_function_direct(double OP)
 {
-    bool continue_iteration;
+    return iterate_weight_function_direct_multi({OP});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Merges the histograms of all walkers.
+/// @details Every rank bins the same order parameter values, so the histogram
+///          is already complete within a partition. With partition walkers
+///          the histograms and sample counts of the partitions are summed with
+///          one reduction over MPI_COMM_WORLD, to which only rank 0 of each
+///          partition contributes. Afterwards all ranks of all partitions hold
+///          the same histogram, and the weight updates stay identical.
+///
+/// @param n         histogram to merge, in place
+/// @param samples   number of binned samples, in place
+////////////////////////////////////////////////////////////////////////////////
+static void merge_walker_histograms(int_vector &n, int &samples)
+{
+    if (!g_PartitionWalkers || hila::partitions.number() == 1)
+        return;
+
+    int N = n.size();
+    int_vector buf(N + 1, 0);
     if (hila::myrank() == 0)
     {
-        int samples = g_WParam.DIP.sample_size;
-        int N       = g_WValues.size();
+        for (int m = 0; m < N; m++)
+            buf[m] = n[m];
+        buf[N] = samples;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, buf.data(), N + 1, MPI_INT, MPI_SUM,
+                  MPI_COMM_WORLD);
+    for (int m = 0; m < N; m++)
+        n[m] = buf[m];
+    samples = buf[N];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Direct iteration with several concurrent walkers.
+/// @details Each call bins one order parameter value from each walker (chain)
+///          of this partition. After DIM sample size calls the histograms of
+///          all walkers are merged and the weights are updated jointly, the
+///          update normalised by the total number of samples. With partition
+///          walkers all partitions must call this in step.
+///
+/// @param  OPs_in  order parameters of the walkers, taken from rank 0
+/// @return boolean indicating whether the iteration is considered complete
+////////////////////////////////////////////////////////////////////////////////
+static bool iterate_weight_function_direct_multi(const vector &OPs_in)
+{
+    // order parameters of rank 0, all ranks do the same update
+    vector OPs = OPs_in;
+    hila::broadcast(OPs);
+
+    bool continue_iteration;
+    int samples = g_WParam.DIP.sample_size;
+    int N       = g_WValues.size();
 
+    for (double OP : OPs)
         bin_OP_value(OP);
-        g_WeightIterationCount += 1;
+    g_WalkerSamples += OPs.size();
+    g_WeightIterationCount += 1;
 
-        if (g_WeightIterationCount >= samples)
+    if (g_WeightIterationCount >= samples)
+    {
+        merge_walker_histograms(g_N_OP_Bin, g_WalkerSamples);
+        for (int m = 0; m < N; m++)
         {
-            for (int m = 0; m < N; m++)
-            {
-                g_WValues[m] += g_WParam.DIP.C * g_N_OP_Bin[m] * N / samples;
-                g_N_OP_BinTotal[m] += g_N_OP_Bin[m];
-            }
+            g_WValues[m] += g_WParam.DIP.C * g_N_OP_Bin[m] * N
+                            / std::max(g_WalkerSamples, 1);
+            g_N_OP_BinTotal[m] += g_N_OP_Bin[m];
+        }
 
-            if (g_WParam.visuals) print_iteration_histogram();
+        if (g_WParam.visuals) print_iteration_histogram();
 
-            double base = *std::min_element(g_WValues.begin(), g_WValues.end());
-            for (int m = 0; m < N; ++m)
-            {
-                // Always set minimum weight to zero. This is inconsequential
-                // as only the differences matter.
-                g_WValues[m] -= base;
-                g_N_OP_Bin[m] = 0;
-            }
-            g_WeightIterationCount = 0;
+        double base = *std::min_element(g_WValues.begin(), g_WValues.end());
+        for (int m = 0; m < N; ++m)
+        {
+            // Always set minimum weight to zero. This is inconsequential
+            // as only the differences matter.
+            g_WValues[m] -= base;
+            g_N_OP_Bin[m] = 0;
+        }
+        g_WeightIterationCount = 0;
+        g_WalkerSamples = 0;
 
-            if (finish_check(g_N_OP_BinTotal))
+        if (finish_check(g_N_OP_BinTotal))
+        {
+            for (int m = 0; m < N; m++)
             {
-                for (int m = 0; m < N; m++)
-                {
-                    g_N_OP_BinTotal[m] = 0;
-                }
-
-                g_WParam.DIP.C /= 1.5;
-                hila::out0 << "Decreasing update size...\n";
-                hila::out0 << "New update size C = " << g_WParam.DIP.C << "\n\n";
+                g_N_OP_BinTotal[m] = 0;
             }
-            write_weight_function("intermediate_weight.dat");
-            hila::out0 << "Update size C = " << g_WParam.DIP.C << "\n\n";
-        }
 
-        continue_iteration = true;
-        if (g_WParam.DIP.C < g_WParam.DIP.C_min)
-        {
-            hila::out0 << "Reached minimum update size.\n";
-            hila::out0 << "Weight iteration complete.\n";
-            continue_iteration = false;
+            g_WParam.DIP.C /= 1.5;
+            hila::out0 << "Decreasing update size...\n";
+            hila::out0 << "New update size C = " << g_WParam.DIP.C << "\n\n";
         }
+        write_weight_function("intermediate_weight.dat");
+        hila::out0 << "Update size C = " << g_WParam.DIP.C << "\n\n";
+    }
+
+    continue_iteration = true;
+    if (g_WParam.DIP.C < g_WParam.DIP.C_min)
+    {
+        hila::out0 << "Reached minimum update size.\n";
+        hila::out0 << "Weight iteration complete.\n";
+        continue_iteration = false;
     }
-    hila::broadcast(continue_iteration);
     return continue_iteration;
 }
 
@@ -1023,62 +1081,85 @@ static bool iterate_weight_function_direct(double OP)
 ////////////////////////////////////////////////////////////////////////////////
 static bool iterate_weight_function_direct_single(double OP)
 {
-    int continue_iteration;
-    if (hila::myrank() == 0)
-    {
-        int samples = g_WParam.DIP.sample_size;
-        int N       = g_WValues.size();
+    return iterate_weight_function_direct_single_multi({OP});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief iterate_weight_function_direct_single for several walkers.
+/// @details The visits of all walkers are merged at each call (one reduction
+///          with partition walkers), and each visit adds C to the weight of
+///          the bin.
+///
+/// @param  OPs_in  order parameters of the walkers, taken from rank 0
+/// @return boolean indicating whether the iteration is considered complete
+////////////////////////////////////////////////////////////////////////////////
+static bool iterate_weight_function_direct_single_multi(const vector &OPs_in)
+{
+    // order parameters of rank 0, all ranks do the same update
+    vector OPs = OPs_in;
+    hila::broadcast(OPs);
 
+    int continue_iteration = true;
+    int N       = g_WValues.size();
+
+    // Only increment if on the min-max interval
+    int_vector visits(N, 0);
+    for (double OP : OPs)
+    {
         int bin_index = find_OP_bin_index(OP);
-        // Only increment if on the min-max interval
         if (bin_index != -1)
-            g_N_OP_BinTotal[bin_index] += 1;
+            visits[bin_index] += 1;
+    }
+    int n_visits = OPs.size();
+    merge_walker_histograms(visits, n_visits);
 
-        g_WeightIterationCount += 1;
+    for (int m = 0; m < N; m++)
+    {
+        g_N_OP_BinTotal[m] += visits[m];
+        g_WValues[m] += g_WParam.DIP.C * visits[m];
+    }
 
-        g_WValues[bin_index] += g_WParam.DIP.C;
+    g_WeightIterationCount += 1;
 
-        if (g_WeightIterationCount % g_WParam.DIP.single_check_interval == 0)
-        {
+    if (g_WeightIterationCount % g_WParam.DIP.single_check_interval == 0)
+    {
 
-        double base = *std::min_element(g_WValues.begin(), g_WValues.end());
-        for (int m = 0; m < N; ++m)
-        {
-            // Always set minimum weight to zero. This is inconsequential
-            // as only the differences matter.
-            g_WValues[m] -= base;
-            g_N_OP_Bin[m] = 0;
-        }
+    double base = *std::min_element(g_WValues.begin(), g_WValues.end());
+    for (int m = 0; m < N; ++m)
+    {
+        // Always set minimum weight to zero. This is inconsequential
+        // as only the differences matter.
+        g_WValues[m] -= base;
+        g_N_OP_Bin[m] = 0;
+    }
 
-        // Visuals
-        if (g_WParam.visuals) print_iteration_histogram();
+    // Visuals
+    if (g_WParam.visuals) print_iteration_histogram();
 
-        // If condition satisfied, zero the totals and decrease C
-        if (finish_check(g_N_OP_BinTotal))
+    // If condition satisfied, zero the totals and decrease C
+    if (finish_check(g_N_OP_BinTotal))
+    {
+        for (int m = 0; m < N; m++)
         {
-            for (int m = 0; m < N; m++)
-            {
-                g_N_OP_BinTotal[m] = 0;
-            }
-
-            g_WParam.DIP.C /= 1.5;
-            hila::out0 << "Decreasing update size...\n";
-            hila::out0 << "New update size C = " << g_WParam.DIP.C << "\n\n";
+            g_N_OP_BinTotal[m] = 0;
         }
 
-        continue_iteration = true;
-        if (g_WParam.DIP.C < g_WParam.DIP.C_min)
-        {
-            hila::out0 << "Reached minimum update size.\n";
-            hila::out0 << "Weight iteration complete.\n";
-            continue_iteration = false;
-        }
+        g_WParam.DIP.C /= 1.5;
+        hila::out0 << "Decreasing update size...\n";
+        hila::out0 << "New update size C = " << g_WParam.DIP.C << "\n\n";
+    }
 
-        write_weight_function("intermediate_weight.dat");
-        hila::out0 << "Update size C = " << g_WParam.DIP.C << "\n\n";
-        }
+    continue_iteration = true;
+    if (g_WParam.DIP.C < g_WParam.DIP.C_min)
+    {
+        hila::out0 << "Reached minimum update size.\n";
+        hila::out0 << "Weight iteration complete.\n";
+        continue_iteration = false;
+    }
+
+    write_weight_function("intermediate_weight.dat");
+    hila::out0 << "Update size C = " << g_WParam.DIP.C << "\n\n";
     }
-    hila::broadcast(continue_iteration);
     return continue_iteration;
 }
 
@@ -1091,6 +1172,9 @@ static bool iterate_weight_function_direct_single(double OP)
 ////////////////////////////////////////////////////////////////////////////////
 static void print_iteration_histogram()
 {
+    if (hila::myrank() != 0)
+        return;
+
     int samples = g_WParam.DIP.sample_size;
     int N       = g_WValues.size();
     // Find maximum bin content for normalisation
@@ -1133,21 +1217,25 @@ static void setup_iteration()
         if (g_WParam.DIP.sample_size > 1)
         {
             iterate_weights = &iterate_weight_function_direct;
+            iterate_weights_multi = &iterate_weight_function_direct_multi;
         }
         else
         {
             iterate_weights = &iterate_weight_function_direct_single;
+            iterate_weights_multi = &iterate_weight_function_direct_single_multi;
         }
         g_WParam.DIP.C = g_WParam.DIP.C_init;
     }
     else
     {
         iterate_weights = &iterate_weight_function_direct;
+        iterate_weights_multi = &iterate_weight_function_direct_multi;
         g_WParam.DIP.C = g_WParam.DIP.C_init;
     }
 
-    // Zero the iteration counter
+    // Zero the iteration counters
     g_WeightIterationCount = 0;
+    g_WalkerSamples = 0;
 
     // Set up the finish condition pointer for the direct method.
     if (g_WParam.DIP.finish_condition.compare("all_visited") == 0)
@@ -1174,7 +1262,49 @@ static void setup_iteration()
 ////////////////////////////////////////////////////////////////////////////////
 void set_continuous_iteration(bool YN)
 {
-    if (hila::myrank() == 0) g_WParam.AR_iteration = YN;
+    g_WParam.AR_iteration = YN;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Enable/disable merging the weight iteration histograms of all
+///        partitions ('-partitions' command line option).
+/// @details With partition walkers each partition runs its own chain, and the
+///          weight function is iterated jointly from the merged histograms.
+///          All partitions must then call the iteration functions in step.
+///          Call after initialise(), which makes the weights of the
+///          partitions identical.
+///
+/// @param YN   enable (true) or disable (false) the merging
+////////////////////////////////////////////////////////////////////////////////
+void set_partition_walkers(bool YN)
+{
+    g_PartitionWalkers = YN;
+    if (YN && hila::partitions.number() > 1)
+    {
+        // start from the weights of partition 0
+        int N = g_WValues.size();
+        vector buf(3 * N + 1, 0.0);
+        if (hila::myrank() == 0 && hila::partitions.mylattice() == 0)
+        {
+            for (int m = 0; m < N; m++)
+            {
+                buf[m] = g_WValues[m];
+                buf[N + m] = g_OPValues[m];
+                buf[2 * N + m] = g_OPBinLimits[m];
+            }
+            buf[3 * N] = g_OPBinLimits[N];
+        }
+        MPI_Allreduce(MPI_IN_PLACE, buf.data(), 3 * N + 1, MPI_DOUBLE, MPI_SUM,
+                      MPI_COMM_WORLD);
+        for (int m = 0; m < N; m++)
+        {
+            g_WValues[m] = buf[m];
+            g_OPValues[m] = buf[N + m];
+            g_OPBinLimits[m] = buf[2 * N + m];
+        }
+        g_OPBinLimits[N] = buf[3 * N];
+        g_WParam.DIP.C = g_WParam.DIP.C_init;
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1189,19 +1319,32 @@ void initialise(const string wfile_name)
 {
     // Read parameters into g_WParam struct
     read_weight_parameters(wfile_name);
-    // This is fine to do just for process zer0
-    if (hila::myrank() == 0)
+
+    // Read pre-existing weight if given, on process 0 only,
+    // and copy it to all ranks
+    if (g_WParam.weight_loc.compare("NONE") != 0)
     {
-        // Read pre-existing weight if given
-        if (g_WParam.weight_loc.compare("NONE") != 0)
+        if (hila::myrank() == 0)
         {
             read_weight_function(g_WParam.weight_loc);
         }
-
-        // Initialise rest of the uninitialised vectors
-        initialise_weight_vectors();
+        hila::broadcast(g_OPBinLimits);
+        hila::broadcast(g_OPValues);
+        hila::broadcast(g_WValues);
     }
 
+    // Initialise rest of the uninitialised vectors
+    initialise_weight_vectors();
+
+    // Key of the accept/reject random stream, from process 0 of the partition
+    uint64_t key = 0;
+    if (hila::myrank() == 0)
+        key = static_cast<uint64_t>(hila::random() * (1UL << 61));
+    hila::broadcast(key);
+    g_ARKey[0] = static_cast<uint32_t>(key);
+    g_ARKey[1] = static_cast<uint32_t>(key >> 32);
+    g_ARCounter = 0;
+
     // Choose an iteration method (or the default)
     setup_iteration();
 }
@@ -24,6 +24,10 @@ namespace muca
 typedef bool (* iteration_pointer)(const double OP);
 extern iteration_pointer iterate_weights;
 
+// Same for several concurrent walkers, one order parameter value per walker
+typedef bool (* multi_iteration_pointer)(const std::vector<double> &OPs);
+extern multi_iteration_pointer iterate_weights_multi;
+
 // Quick helper function for writing values to a file
 template <class K>
 void to_file(std::ofstream &output_file, std::string fmt, K input_value);
@@ -53,6 +57,9 @@ void set_direct_iteration_FC(bool (* fc_pointer)(std::vector<int> &n));
 // Set to perform the weight iteration at each call to accept_reject
 void set_continuous_iteration(bool YN);
 
+// Set to iterate the weights jointly with the chains of all partitions
+void set_partition_walkers(bool YN);
+
 // For the continuous iteration the finish condition is tracked internally
 // and can be checked and set using the two functions below
 bool check_weight_iter_flag();
@@ -88,9 +95,13 @@ static void setup_equidistant_bins();
 
 static void initialise_weight_vectors();
 
+static void merge_walker_histograms(std::vector<int> &n, int &samples);
+
 static bool iterate_weight_function_direct(double OP);
+static bool iterate_weight_function_direct_multi(const std::vector<double> &OPs);
 
 static bool iterate_weight_function_direct_single(double OP);
+static bool iterate_weight_function_direct_single_multi(const std::vector<double> &OPs);
 
 static void setup_iteration();
 
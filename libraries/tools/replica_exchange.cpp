@@ -0,0 +1,225 @@
+#include "replica_exchange.h"
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+namespace hila {
+
+static hila::timer replica_exchange_timer("replica exchange");
+
+replica_exchange::replica_exchange(const std::vector<std::vector<double>> &parameter_sets) {
+
+    int n = hila::partitions.number();
+    if (parameter_sets.size() != n) {
+        hila::out0 << "replica_exchange: " << parameter_sets.size()
+                   << " parameter sets given, but there are " << n << " partitions\n";
+        hila::terminate(1);
+    }
+
+    params = parameter_sets;
+    slot_of.resize(n);
+    for (int i = 0; i < n; i++)
+        slot_of[i] = i;
+    parity = 0;
+
+    rep_tried.assign(n, 0);
+    rep_accepted.assign(n, 0);
+    pair_tried.assign(n > 1 ? n - 1 : 0, 0);
+    pair_accepted.assign(n > 1 ? n - 1 : 0, 0);
+}
+
+static std::vector<std::vector<double>> to_parameter_sets(const std::vector<double> &v) {
+    std::vector<std::vector<double>> sets(v.size());
+    for (int i = 0; i < v.size(); i++)
+        sets[i] = {v[i]};
+    return sets;
+}
+
+replica_exchange::replica_exchange(const std::vector<double> &parameter_values)
+    : replica_exchange(to_parameter_sets(parameter_values)) {}
+
+
+/// The slot this one is paired with in this round, -1 if none
+int replica_exchange::partner_slot(int s) const {
+    if (s % 2 == parity)
+        return (s + 1 < size()) ? s + 1 : -1;
+    else
+        return (s > 0) ? s - 1 : -1;
+}
+
+bool replica_exchange::exchange(
+    const std::function<double(const std::vector<double> &)> &action) {
+
+    int n = size();
+    if (n < 2 || hila::check_input)
+        return false;
+
+    replica_exchange_timer.start();
+
+    int me = hila::partitions.mylattice();
+    int s = slot_of[me];
+    int ps = partner_slot(s);
+
+    // action change of this replica if moved to the partner slot.  The action
+    // evaluation is collective within the partition
+    std::vector<double> dS(n, 0.0);
+    double d = 0;
+    if (ps >= 0)
+        d = action(params[ps]) - action(params[s]);
+    if (hila::myrank() == 0)
+        dS[me] = d;
+
+    MPI_Allreduce(MPI_IN_PLACE, dS.data(), n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+    std::vector<int> replica_in(n);
+    for (int r = 0; r < n; r++)
+        replica_in[slot_of[r]] = r;
+
+    // accept/reject on world rank 0, indexed by the lower slot of the pair
+    std::vector<int> accept(n, 0);
+    int world_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+    if (world_rank == 0) {
+        for (int k = parity; k + 1 < n; k += 2) {
+            double dd = dS[replica_in[k]] + dS[replica_in[k + 1]];
+            accept[k] = (dd <= 0 || hila::random() < exp(-dd));
+        }
+    }
+    MPI_Bcast(accept.data(), n, MPI_INT, 0, MPI_COMM_WORLD);
+
+    for (int k = parity; k + 1 < n; k += 2) {
+        int a = replica_in[k], b = replica_in[k + 1];
+        pair_tried[k]++;
+        rep_tried[a]++;
+        rep_tried[b]++;
+        if (accept[k]) {
+            pair_accepted[k]++;
+            rep_accepted[a]++;
+            rep_accepted[b]++;
+            slot_of[a] = k + 1;
+            slot_of[b] = k;
+        }
+    }
+    parity = 1 - parity;
+
+    replica_exchange_timer.stop();
+
+    return slot_of[me] != s;
+}
+
+double replica_exchange::acceptance(int r) const {
+    if (rep_tried.at(r) == 0)
+        return 0;
+    return static_cast<double>(rep_accepted[r]) / rep_tried[r];
+}
+
+void replica_exchange::report() const {
+    if (size() < 2)
+        return;
+
+    hila::out0 << "REPLICA EXCHANGE: this replica " << hila::partitions.mylattice()
+               << " in slot " << slot() << '\n';
+    hila::out0 << "  replica  slot  tried  acceptance\n";
+    for (int r = 0; r < size(); r++) {
+        hila::out0 << "  " << std::setw(7) << r << std::setw(6) << slot_of[r] << std::setw(7)
+                   << rep_tried[r] << "  " << acceptance(r) << '\n';
+    }
+    hila::out0 << "  slots    tried  acceptance\n";
+    for (int k = 0; k + 1 < size(); k++) {
+        double rate = pair_tried[k] > 0 ? static_cast<double>(pair_accepted[k]) / pair_tried[k] : 0;
+        hila::out0 << "  " << std::setw(3) << k << '-' << std::setw(3) << std::left << k + 1
+                   << std::right << std::setw(7) << pair_tried[k] << "  " << rate << '\n';
+    }
+}
+
+template <typename T>
+static void write_list(std::ofstream &outf, const std::string &label, const std::vector<T> &v) {
+    outf << label;
+    for (int i = 0; i < v.size(); i++) {
+        outf << (i == 0 ? " " : ", ") << v[i];
+    }
+    outf << '\n';
+}
+
+void replica_exchange::checkpoint(const std::string &filename) const {
+    if (size() < 2)
+        return;
+
+    if (hila::myrank() == 0) {
+        std::ofstream outf;
+        outf.open(filename, std::ios::out | std::ios::trunc);
+        outf << "replicas         " << size() << '\n';
+        outf << "parity           " << parity << '\n';
+        write_list(outf, "slots           ", slot_of);
+        write_list(outf, "replica tried   ", rep_tried);
+        write_list(outf, "replica accepted", rep_accepted);
+        write_list(outf, "pair tried      ", pair_tried);
+        write_list(outf, "pair accepted   ", pair_accepted);
+        outf.close();
+    }
+}
+
+bool replica_exchange::restore_checkpoint(const std::string &filename) {
+    if (size() < 2)
+        return false;
+
+    // all partitions must agree on whether the state is restored
+    int found = 0;
+    if (hila::myrank() == 0 && filesys_ns::exists(filename))
+        found = 1;
+    MPI_Allreduce(MPI_IN_PLACE, &found, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    if (found == 0)
+        return false;
+    if (found != size()) {
+        hila::out0 << "replica_exchange: file '" << filename << "' found only in " << found
+                   << " partitions out of " << size() << '\n';
+        hila::terminate(1);
+    }
+
+    hila::input status;
+    status.quiet();
+    status.open(filename);
+    int n = status.get("replicas");
+    if (n != size()) {
+        hila::out0 << "replica_exchange: file '" << filename << "' has " << n
+                   << " replicas, now " << size() << '\n';
+        hila::terminate(1);
+    }
+    parity = status.get("parity");
+    std::vector<int> slots = status.get("slots");
+    std::vector<int64_t> rt = status.get("replica tried");
+    std::vector<int64_t> ra = status.get("replica accepted");
+    std::vector<int64_t> pt = status.get("pair tried");
+    std::vector<int64_t> pa = status.get("pair accepted");
+    status.close();
+
+    // Check that the files of all partitions agree and form a permutation
+    bool ok = (slots.size() == size() && rt.size() == size() && ra.size() == size() &&
+               pt.size() == size() - 1 && pa.size() == size() - 1);
+    std::vector<int> mine(size(), 0), seen(size(), 0);
+    if (ok && hila::myrank() == 0) {
+        int s = slots[hila::partitions.mylattice()];
+        if (s >= 0 && s < size())
+            mine[s] = 1;
+    }
+    MPI_Allreduce(mine.data(), seen.data(), size(), MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    for (int k = 0; k < size(); k++) {
+        if (seen[k] != 1) {
+            hila::out0 << "replica_exchange: inconsistent slot assignment in '" << filename
+                       << "'\n";
+            hila::terminate(1);
+        }
+    }
+
+    slot_of = slots;
+    rep_tried = rt;
+    rep_accepted = ra;
+    pair_tried = pt;
+    pair_accepted = pa;
+
+    hila::out0 << "Replica exchange restored, this replica in slot " << slot() << '\n';
+    return true;
+}
+
+} // namespace hila
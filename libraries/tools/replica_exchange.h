@@ -0,0 +1,100 @@
+/**
+ * @file replica_exchange.h
+ * @brief Replica exchange (parallel tempering) between lattice partitions
+ *
+ */
+#ifndef REPLICA_EXCHANGE_H
+#define REPLICA_EXCHANGE_H
+
+#include "hila.h"
+#include <functional>
+
+namespace hila {
+
+/**
+ * @brief Replica exchange driver over the partitions given with '-partitions'
+ *
+ * @details Each partition (replica) evolves its own configuration.  The replicas share a
+ * list of parameter sets ("slots"), e.g. {beta} or {beta, twist coeff, weight offset},
+ * one slot for each partition.  exchange() proposes swapping the slots of replicas in
+ * neighbouring slots k, k+1, alternating between even and odd k on successive calls.
+ * Only the slot indices move between partitions, configurations stay where they are.
+ *
+ * The swap is accepted with the Metropolis probability
+ *     min(1, exp(-[S_a(p_k+1) - S_a(p_k) + S_b(p_k) - S_b(p_k+1)]))
+ * where S_a(p) is the action of the configuration of replica a with parameters p.
+ * S is given as a function, which is called collectively by all ranks of the partition:
+ *
+ *     hila::replica_exchange rex(beta_list);    // beta_list[k] = {beta_k}
+ *     p.beta = rex.parameters()[0];
+ *     ...
+ *     double plaq = measure_plaq(U);
+ *     if (rex.exchange([&](const std::vector<double> &v) { return v[0] * plaq; }))
+ *         p.beta = rex.parameters()[0];
+ *
+ * All partitions must call exchange(), checkpoint() and restore_checkpoint() at the
+ * same points.  The state goes to file "replica_status" in the partition directory,
+ * next to "run_status" written by checkpoint().
+ */
+class replica_exchange {
+  private:
+    std::vector<std::vector<double>> params;
+    // slot of each replica, identical on all ranks of all partitions
+    std::vector<int> slot_of;
+    int parity;
+
+    // per replica and per slot pair (k, k+1) statistics
+    std::vector<int64_t> rep_tried, rep_accepted;
+    std::vector<int64_t> pair_tried, pair_accepted;
+
+    int partner_slot(int slot) const;
+
+  public:
+    /// Parameter sets, one for each partition.  Replica n starts from slot n.
+    explicit replica_exchange(const std::vector<std::vector<double>> &parameter_sets);
+
+    /// Convenience for a single exchanged parameter (e.g. beta)
+    explicit replica_exchange(const std::vector<double> &parameter_values);
+
+    /// Number of replicas
+    int size() const {
+        return slot_of.size();
+    }
+
+    /// Slot of this partition
+    int slot() const {
+        return slot_of[hila::partitions.mylattice()];
+    }
+
+    /// Current parameter set of this partition
+    const std::vector<double> &parameters() const {
+        return params[slot()];
+    }
+
+    /// Parameter set of slot k
+    const std::vector<double> &parameters(int k) const {
+        return params.at(k);
+    }
+
+    /// Propose swaps between neighbouring slots.  Returns true if the slot of this
+    /// partition changed, i.e. parameters() must be re-read.
+    bool exchange(const std::function<double(const std::vector<double> &)> &action);
+
+    /// Acceptance rate of exchanges of replica n, or of this replica
+    double acceptance(int n) const;
+    double acceptance() const {
+        return acceptance(hila::partitions.mylattice());
+    }
+
+    /// Print the per replica and per slot pair acceptance rates
+    void report() const;
+
+    /// Save / restore slot assignment and statistics.  restore_checkpoint() returns
+    /// false and keeps the initial assignment if the file does not exist.
+    void checkpoint(const std::string &filename = "replica_status") const;
+    bool restore_checkpoint(const std::string &filename = "replica_status");
+};
+
+} // namespace hila
+
+#endif
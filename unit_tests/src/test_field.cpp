@@ -117,6 +117,20 @@ TEST_CASE_METHOD(FieldTest, "Field arithmetic", "[Field]") {
         REQUIRE((temporary_field(1) * temporary_field(2)) == dummy_field);
         REQUIRE((temporary_field(4) / temporary_field(2)) == dummy_field);
     }
+    SECTION("Arithmetic with field expressions") {
+        Field<MyType> a = 1, b = 3, c = 4;
+        Field<MyType> r = a + b * c / 2 - 5;
+        REQUIRE(r == dummy_field);
+        // more than 4 field operands, evaluated in parts
+        r = (a + b) * (c - a) / (b - a) - (c + a) / 5 - 6 * a + 3;
+        REQUIRE(r == dummy_field);
+        r = -a + b;
+        REQUIRE(r == dummy_field);
+        r = 0;
+        r += a.conj() + temporary_field(1);
+        REQUIRE(r == dummy_field);
+        REQUIRE((4 * temporary_field(1) - c / 2) == dummy_field);
+    }
 }
 
 // UNARY OPERATOR?
@@ -144,4 +158,147 @@ TEST_CASE_METHOD(FieldTest, "Field mathematical operations", "[Field]") {
         REQUIRE(dummy_field.min(EVEN, loc_min) == 1.0);
         REQUIRE(dummy_field.max(ODD, loc_max) == 1.0);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE_METHOD(FieldTest, "Field write and read", "[Field]") {
+    fill_dummy_field();
+    bool parallel_io = hila::parallel_io;
+    Field<MyType> read_field;
+
+    hila::parallel_io = true;
+    dummy_field.write("test_field_parallel.dat");
+    hila::parallel_io = false;
+    dummy_field.write("test_field_rank0.dat");
+
+    SECTION("Parallel and rank 0 files identical") {
+        bool same = true;
+        if (hila::myrank() == 0) {
+            std::ifstream a("test_field_parallel.dat", std::ios::binary);
+            std::ifstream b("test_field_rank0.dat", std::ios::binary);
+            std::string sa((std::istreambuf_iterator<char>(a)), std::istreambuf_iterator<char>());
+            std::string sb((std::istreambuf_iterator<char>(b)), std::istreambuf_iterator<char>());
+            same = (sa == sb) && sa.size() == lattice.volume() * sizeof(MyType);
+        }
+        REQUIRE(hila::broadcast(same));
+    }
+    SECTION("Parallel read") {
+        hila::parallel_io = true;
+        read_field.read("test_field_rank0.dat");
+        REQUIRE(read_field == dummy_field);
+    }
+    SECTION("Rank 0 read") {
+        hila::parallel_io = false;
+        read_field.read("test_field_parallel.dat");
+        REQUIRE(read_field == dummy_field);
+    }
+    hila::parallel_io = parallel_io;
+
+    // all ranks are done with the files
+    hila::synchronize();
+    if (hila::myrank() == 0) {
+        std::remove("test_field_parallel.dat");
+        std::remove("test_field_rank0.dat");
+    }
+}
+
+TEST_CASE_METHOD(FieldTest, "Fused multi_dot and multi_axpy", "[Field]") {
+    using VType = Vector<2, Complex<double>>;
+    const int n = 5;
+    std::vector<Field<VType>> a(n), b(n + 1);
+    for (auto &f : a)
+        onsites(ALL) f[X].gaussian_random();
+    for (auto &f : b)
+        onsites(ALL) f[X].gaussian_random();
+
+    SECTION("Gram matrix matches separate reductions") {
+        auto G = hila::multi_dot(a, b);
+        auto Gr = hila::multi_rdot(a, b, EVEN);
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j <= n; j++) {
+                Complex<double> d = 0;
+                double dr = 0;
+                onsites(ALL) d += a[i][X].dot(b[j][X]);
+                onsites(EVEN) dr += real(a[i][X].dot(b[j][X]));
+                REQUIRE(abs(G[i][j] - d) < 1e-10 * lattice.volume());
+                REQUIRE(fabs(Gr[i][j] - dr) < 1e-10 * lattice.volume());
+            }
+    }
+    SECTION("multi_axpy matches separate updates") {
+        std::vector<double> c(n);
+        for (int i = 0; i < n; i++)
+            c[i] = 0.5 + i;
+        Field<VType> y = 0, ref = 0;
+        hila::multi_axpy(y, c, a);
+        for (int i = 0; i < n; i++)
+            onsites(ALL) ref[X] += c[i] * a[i][X];
+        double diff = 0;
+        onsites(ALL) diff += squarenorm(y[X] - ref[X]);
+        REQUIRE(diff < 1e-20 * lattice.volume());
+    }
+}
+
+TEST_CASE("More gathers started than halo mailbox slots", "[Field]") {
+    // EVEN and ODD gathers are separate messages: 2n ongoing gathers to e_x before waiting,
+    // more than the shared memory halo exchange mailbox ring holds
+    const int n = SHM_HALO_SLOTS / 2 + 8;
+    const int nx = lattice.size(e_x);
+    std::vector<Field<float>> f(n);
+    for (int i = 0; i < n; i++)
+        onsites(ALL) f[i][X] = X.coordinate(e_x) + 1000 * i;
+
+    for (int i = 0; i < n; i++) {
+        f[i].start_gather(e_x, EVEN);
+        f[i].start_gather(e_x, ODD);
+    }
+
+    int errors = 0;
+    for (int i = 0; i < n; i++) {
+        onsites(ALL) {
+            float expect = (X.coordinate(e_x) + 1) % nx + 1000 * i;
+            errors += (f[i][X + e_x] != expect);
+        }
+    }
+    REQUIRE(errors == 0);
+}
+
+TEST_CASE("Loop local direction references", "[Field]") {
+    // built with hilapp -direction-analysis (unit_tests/Makefile), which gathers only the
+    // directions the guards allow; compare with loops over constant directions
+    Field<double> f, s, ref = 0;
+    onsites(ALL) f[X] = hila::random();
+    const Direction d1 = e_y;
+
+    SECTION("foralldir with a direction excluded") {
+        onsites(ALL) {
+            double t = 0;
+            foralldir(d) if (d != d1) t += f[X + d];
+            s[X] = t;
+        }
+        foralldir(d) if (d != d1) onsites(ALL) ref[X] += f[X + d];
+        REQUIRE(s == ref);
+    }
+    SECTION("continue guard") {
+        onsites(ALL) {
+            double t = 0;
+            for (Direction d = e_x; d < NDIRS; ++d) {
+                if (d == d1 || d == -d1)
+                    continue;
+                t += f[X + d];
+            }
+            s[X] = t;
+        }
+        for (Direction d = e_x; d < NDIRS; ++d)
+            if (d != d1 && d != -d1)
+                onsites(ALL) ref[X] += f[X + d];
+        REQUIRE(s == ref);
+    }
+    SECTION("negative directions") {
+        onsites(ALL) {
+            double t = 0;
+            foralldir(d) if (d != d1) t += f[X + (-d)];
+            s[X] = t;
+        }
+        foralldir(d) if (d != d1) onsites(ALL) ref[X] += f[X - d];
+        REQUIRE(s == ref);
+    }
+}
@@ -0,0 +1,93 @@
+#include "hila.h"
+#include "catch.hpp"
+#include "hmc/integrator.h"
+
+/**
+ * @brief Anharmonic oscillator at every site, H = p^2/2 + q^2/2 + q^4/4.
+ * The momentum part is the lowest integrator level, updating q with p
+ */
+class oscillator_momentum : public integrator_base {
+  public:
+    Field<double> q, p, q_store, p_store;
+
+    void step(double eps) {
+        field_update(eps);
+    }
+    void momentum_push() {
+        p_store = p;
+        p = 0;
+    }
+    void momentum_pop(double scale) {
+        onsites(ALL) p[X] = p_store[X] + scale * p[X];
+    }
+    void field_push() {
+        q_store = q;
+    }
+    void field_pop() {
+        q = q_store;
+    }
+    void field_update(double eps) {
+        onsites(ALL) q[X] += eps * p[X];
+    }
+};
+
+/// The potential part, force -dV/dq
+class oscillator_potential : public action_base {
+  public:
+    oscillator_momentum &m;
+    oscillator_potential(oscillator_momentum &mom) : m(mom) {}
+
+    void force_step(double eps) {
+        onsites(ALL) m.p[X] -= eps * (m.q[X] + m.q[X] * m.q[X] * m.q[X]);
+    }
+};
+
+inline double oscillator_energy(double q, double p) {
+    return 0.5 * p * p + 0.5 * q * q + 0.25 * q * q * q * q;
+}
+
+/// Sum of |H_end - H_start| over the sites after a unit length trajectory
+double energy_violation(integrator_scheme scheme, int n_steps, const Field<double> &q0,
+                        const Field<double> &p0) {
+    oscillator_momentum m;
+    oscillator_potential V(m);
+    multiscale_integrator integrator(m);
+    integrator.add_level(V, scheme);
+
+    m.q = q0;
+    m.p = p0;
+    for (int i = 0; i < n_steps; i++)
+        integrator.step(1.0 / n_steps);
+
+    double dH = 0;
+    onsites(ALL) dH += fabs(oscillator_energy(m.q[X], m.p[X]) - oscillator_energy(q0[X], p0[X]));
+    return dH;
+}
+
+TEST_CASE("Integrator order on anharmonic oscillator", "[Integrator]") {
+    // halving the step divides the energy violation by 2^order
+    Field<double> q0, p0;
+    onsites(ALL) {
+        q0[X] = hila::gaussrand();
+        p0[X] = hila::gaussrand();
+    }
+
+    SECTION("leapfrog is 2nd order") {
+        double r = energy_violation(integrator_scheme::leapfrog, 20, q0, p0) /
+                   energy_violation(integrator_scheme::leapfrog, 40, q0, p0);
+        REQUIRE(r > 3.5);
+        REQUIRE(r < 4.5);
+    }
+    SECTION("OMF4 is 4th order") {
+        double r = energy_violation(integrator_scheme::O4, 20, q0, p0) /
+                   energy_violation(integrator_scheme::O4, 40, q0, p0);
+        REQUIRE(r > 13);
+        REQUIRE(r < 19);
+    }
+    SECTION("force gradient is 4th order") {
+        double r = energy_violation(integrator_scheme::force_gradient, 20, q0, p0) /
+                   energy_violation(integrator_scheme::force_gradient, 40, q0, p0);
+        REQUIRE(r > 13);
+        REQUIRE(r < 19);
+    }
+}
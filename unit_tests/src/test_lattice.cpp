@@ -155,6 +155,46 @@ TEST_CASE_METHOD(TestLattice, "Lattice routines", "[MPI][.]") {
         REQUIRE(lattice.local_coordinates(0) == CoordinateVector(0));
         REQUIRE(lattice.local_coordinates(total_lattice_size/num_nodes-1) == local_coordinate_dict[num_nodes]);
     }
+    SECTION("Test interior and boundary site split") {
+        for (Parity par : {EVEN, ODD, ALL}) {
+            dir_mask_t mask = get_dir_mask(e_z) | get_dir_mask(-e_z);
+            const auto &split = lattice.site_split(par, mask);
+
+            // every site of the parity exactly once, interior has no z-neighbour off node
+            std::vector<int> seen(lattice.mynode.sites, 0);
+            unsigned n_interior = 0;
+            for (const auto &b : split.interior) {
+                for (unsigned i = b.begin; i < b.end; i++) {
+                    seen[i]++;
+                    REQUIRE((lattice.wait_arr_[i] & mask) == 0);
+                }
+                n_interior += b.end - b.begin;
+            }
+            for (unsigned i : split.boundary) {
+                seen[i]++;
+                REQUIRE((lattice.wait_arr_[i] & mask) != 0);
+            }
+            REQUIRE(n_interior == split.n_interior);
+            for (unsigned i = 0; i < lattice.mynode.sites; i++) {
+                bool in_loop = (i >= lattice.loop_begin(par) && i < lattice.loop_end(par));
+                REQUIRE(seen[i] == (in_loop ? 1 : 0));
+            }
+        }
+    }
+    SECTION("Test site index and neighbours independent of layout") {
+        for (unsigned i = 0; i < lattice.mynode.sites; i++) {
+            CoordinateVector c = lattice.coordinates(i);
+            REQUIRE(lattice.site_index(c) == i);
+            REQUIRE(lattice.site_parity(i) == c.parity());
+            foralldir(d) {
+                CoordinateVector cn = (c + d).mod(lattice.size());
+                if (lattice.is_on_mynode(cn))
+                    REQUIRE(lattice.neighb[d][i] == lattice.site_index(cn));
+                else
+                    REQUIRE(lattice.neighb[d][i] >= lattice.mynode.sites);
+            }
+        }
+    }
 }
 
 TEST_CASE_METHOD(TestLattice, "Node information", "[MPI][.]") {
@@ -0,0 +1,54 @@
+#include "hila.h"
+#include "catch.hpp"
+
+// This file is built with hilapp -loop-fusion -loop-profile (see unit_tests/Makefile).
+// The loop profile call counts show whether consecutive site loops ran as one loop,
+// and the loops marked '#pragma hila nofuse' give the unfused result.
+
+static int64_t loop_calls() {
+    return hila::loop_profile_calls("test_loop_fusion.cpp");
+}
+
+TEST_CASE("Site loop fusion", "[Field]") {
+    Field<Complex<double>> r, p;
+    onsites(ALL) {
+        r[X].gaussian_random();
+        p[X].gaussian_random();
+    }
+    const double alpha = 0.3;
+
+    SECTION("CG-style update and norm are fused") {
+        Field<Complex<double>> r_ref = r;
+        double rr = 0, rr_ref = 0;
+
+        int64_t n_calls = loop_calls();
+        onsites(ALL) r[X] -= alpha * p[X];
+        onsites(ALL) rr += squarenorm(r[X]);
+        REQUIRE(loop_calls() - n_calls == 1);
+
+        n_calls = loop_calls();
+#pragma hila nofuse
+        onsites(ALL) r_ref[X] -= alpha * p[X];
+#pragma hila nofuse
+        onsites(ALL) rr_ref += squarenorm(r_ref[X]);
+        REQUIRE(loop_calls() - n_calls == 2);
+
+        REQUIRE(r == r_ref);
+        REQUIRE(fabs(rr - rr_ref) < 1e-12 * rr_ref);
+    }
+    SECTION("neighbour read of a written field is not fused") {
+        Field<Complex<double>> f, g, f_ref, g_ref;
+
+        int64_t n_calls = loop_calls();
+        onsites(ALL) f[X] = alpha * r[X];
+        onsites(ALL) g[X] = f[X + e_x] - f[X];
+        REQUIRE(loop_calls() - n_calls == 2);
+
+#pragma hila nofuse
+        onsites(ALL) f_ref[X] = alpha * r[X];
+#pragma hila nofuse
+        onsites(ALL) g_ref[X] = f_ref[X + e_x] - f_ref[X];
+
+        REQUIRE(g == g_ref);
+    }
+}
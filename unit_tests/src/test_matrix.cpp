@@ -288,4 +288,58 @@ TEST_CASE_METHOD(MatrixTest, "Matrix mathematical operations", "[Matrix]") {
 
     }
 
-}
\ No newline at end of file
+}
+
+TEST_CASE("Compressed SU(3)", "[Matrix]") {
+    SU<3, double> m;
+    for (int i = 0; i < 9; i++)
+        m.c[i] = Complex<double>(sin(1.0 + i), cos(2.0 * i + 0.5));
+    m.reunitarize();
+
+    SECTION("Reconstruct-12") {
+        SU3_r12<double> c = m;
+        REQUIRE(sizeof(c) == 12 * sizeof(double));
+        REQUIRE((c.expand() - m).norm() == Approx(0).margin(1e-12));
+        REQUIRE((c * m - m * m).norm() == Approx(0).margin(1e-12));
+    }
+
+    SECTION("Reconstruct-8") {
+        SU3_r8<double> c = m;
+        REQUIRE(sizeof(c) == 8 * sizeof(double));
+        REQUIRE((c.expand() - m).norm() == Approx(0).margin(1e-12));
+        REQUIRE((c.dagger() - m.dagger()).norm() == Approx(0).margin(1e-12));
+
+        // singular point, exact for unit matrix
+        c = 1;
+        SU<3, double> one;
+        one = 1;
+        REQUIRE((c.expand() - one).norm() == Approx(0).margin(1e-12));
+    }
+
+    SECTION("Compressed links in a Field") {
+#if defined(AVX)
+        // the vector backend must vectorize the compressed types like SU<3,T>
+        static_assert(std::is_same<vectorize_struct<SU3_r8<double>, 4>::type,
+                                   SU3_r8<Vec4d>>::value,
+                      "SU3_r8<double> is not vectorized");
+        static_assert(std::is_same<vectorize_struct<SU3_r12<float>, 8>::type,
+                                   SU3_r12<Vec8f>>::value,
+                      "SU3_r12<float> is not vectorized");
+#endif
+        Field<SU<3, double>> U;
+        Field<SU3_r12<double>> U12;
+        Field<SU3_r8<double>> U8;
+        onsites(ALL) {
+            U[X].random();
+            U12[X] = U[X];
+            U8[X] = U[X];
+        }
+        double diff12 = 0, diff8 = 0;
+        onsites(ALL) {
+            diff12 += (U12[X].expand() - U[X]).squarenorm();
+            diff8 += (U8[X].expand() - U[X]).squarenorm();
+        }
+        REQUIRE(diff12 / lattice.volume() == Approx(0).margin(1e-20));
+        REQUIRE(diff8 / lattice.volume() == Approx(0).margin(1e-20));
+    }
+}